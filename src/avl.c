@@ -2,6 +2,18 @@
 #include <string.h>
 
 #include "avl.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_AVL
+
+/* Altura máxima de uma AVL, muito acima da de qualquer árvore que caiba em memória */
+#define MAX_HEIGHT 64
+
+/* Número de nodos de uma subárvore, possivelmente vazia */
+#define SIZE(n) ((n) ? (n)->size : 0)
+
+/* As rotações podem acontecer em várias árvores ao mesmo tempo (ver catalog.h) */
+#define COUNT_ROTATION() __sync_add_and_fetch(&rotations, 1)
 
 typedef enum balance { LH, EH, RH } Balance;
 
@@ -10,6 +22,7 @@ typedef struct node {
 	void* content;
 	struct node *left, *right;
 	Balance bal;
+	int size;   /* nodos da subárvore, incluindo este */
 } *NODE;
 
 struct avl {
@@ -25,6 +38,15 @@ struct element {
 	void** address;
 };
 
+/* Nodos cuja subárvore esquerda já foi visitada, do mais fundo para o mais alto */
+struct avl_iterator {
+	struct node* stack[MAX_HEIGHT];
+	int top;
+};
+
+/* Rotações feitas por todas as árvores desde o início do programa */
+static long rotations = 0;
+
 static NODE newNode      (char* hash, void* content, NODE left, NODE right);
 static NODE insertNode   (NODE node, char* hash, void* content, int* update, NODE* last);
 static NODE insertRight  (NODE node, char* hash, void* content, int* update, NODE* last);
@@ -34,18 +56,23 @@ static NODE balanceLeft  (NODE node);
 static NODE rotateRight  (NODE node);
 static NODE rotateLeft   (NODE node);
 static NODE cloneNode    (NODE n, clone_t clone);
+static void resize       (NODE node);
 
 static bool equalsNode   (NODE a, NODE b, condition_t equals);
+static AVLITER pushLeft  (AVLITER it, NODE node);
+static bool scanRange    (NODE n, char* lo, char* hi, visit_t visit, void* arg);
+static bool scanPrefix   (NODE n, char* prefix, int len, visit_t visit, void* arg);
 static void freeNode     (NODE node, free_t free);
 
 static SET addNodeToSet (SET s, NODE node, clone_t clone);
 static SET filterNode   (NODE n, SET s, clone_t clone, condition_t predicate, void* arg);
+static SET prefixNode   (NODE n, SET s, clone_t clone, char* prefix, int len);
 
-static SET dumpNode (NODE n, SET set, void*(*dumper)(void*));
+static SET dumpNode (NODE n, SET set, void*(*dumper)(void*, void*), void* arg);
 
 
 AVL initAVL(condition_t equals, clone_t clone, free_t free){
-	AVL tree = malloc (sizeof (*tree));
+	AVL tree = MALLOC (sizeof (*tree));
 
 	tree->head = NULL;
 	tree->size = 0;
@@ -108,8 +135,21 @@ void *getAVLcontent(AVL tree, char *hash, ELEMENT elem) {
 	return NULL;
 }
 
+bool updateAVLcontent(AVL tree, char *hash, update_t update, void* arg) {
+	NODE p = tree->head;
+	int res;
+
+	while(p && (res = strcmp(hash, p->hash)))
+		p = (res > 0) ? p->right : p->left;
+
+	if (!p) return false;
+
+	p->content = update(p->content, arg);
+	return true;
+}
+
 ELEMENT newElement() {
-	ELEMENT new = malloc(sizeof(*new));
+	ELEMENT new = MALLOC(sizeof(*new));
 
 	new->address = NULL;
 	return new;
@@ -120,7 +160,7 @@ void updateElement(ELEMENT elem, void* content) {
 }
 
 void freeElement(ELEMENT elem) {
-	free(elem);
+	FREE(elem);
 }
 
 bool lookUpAVL(AVL tree, char *hash) {
@@ -156,10 +196,117 @@ int countNodes(AVL tree) {
 	return tree->size;
 }
 
+long getAVLRotations() {
+	return __sync_add_and_fetch(&rotations, 0);
+}
+
+char* selectAVL(AVL tree, int k) {
+	NODE node = tree->head;
+
+	while(node) {
+		if (k < SIZE(node->left))
+			node = node->left;
+		else if (k == SIZE(node->left))
+			return node->hash;
+		else {
+			k -= SIZE(node->left) + 1;
+			node = node->right;
+		}
+	}
+
+	return NULL;
+}
+
+int rankAVL(AVL tree, char* hash) {
+	NODE node = tree->head;
+	int res, rank = 0;
+
+	while(node) {
+		res = strcmp(hash, node->hash);
+
+		if (res < 0)
+			node = node->left;
+		else if (res == 0)
+			return rank + SIZE(node->left);
+		else {
+			rank += SIZE(node->left) + 1;
+			node = node->right;
+		}
+	}
+
+	return rank;
+}
+
+bool rangeScanAVL(AVL tree, char* lo, char* hi, visit_t visit, void* arg) {
+	return scanRange(tree->head, lo, hi, visit, arg);
+}
+
+bool prefixScanAVL(AVL tree, char* prefix, visit_t visit, void* arg) {
+	return scanPrefix(tree->head, prefix, strlen(prefix), visit, arg);
+}
+
+int countPrefixAVL(AVL tree, char* prefix) {
+	NODE node = tree->head;
+	int len = strlen(prefix), upto = 0;
+
+	/* Conta as hashes cujos primeiros len carateres não excedem o prefixo */
+	while(node) {
+		if (strncmp(node->hash, prefix, len) <= 0) {
+			upto += SIZE(node->left) + 1;
+			node = node->right;
+		} else
+			node = node->left;
+	}
+
+	return upto - rankAVL(tree, prefix);
+}
+
+AVLITER initAVLIterator(AVL tree, int pos) {
+	AVLITER it = MALLOC(sizeof(*it));
+	NODE node = tree->head;
+
+	it->top = 0;
+
+	/*
+	 * Desce até ao nodo na posição pos, guardando os nodos onde se seguiu pela esquerda,
+	 * que são os que ainda faltam visitar depois dele.
+	 */
+	while(node) {
+		if (pos < SIZE(node->left)) {
+			it->stack[it->top++] = node;
+			node = node->left;
+		} else if (pos == SIZE(node->left)) {
+			it->stack[it->top++] = node;
+			break;
+		} else {
+			pos -= SIZE(node->left) + 1;
+			node = node->right;
+		}
+	}
+
+	return it;
+}
+
+char* nextAVLIterator(AVLITER it) {
+	NODE node;
+
+	if (it->top == 0)
+		return NULL;
+
+	node = it->stack[--it->top];
+	it = pushLeft(it, node->right);
+
+	return node->hash;
+}
+
+void freeAVLIterator(AVLITER it) {
+	FREE(it);
+}
+
 void freeAVL(AVL tree) {
 	if (tree){
 		freeNode(tree->head, tree->free);
-		free(tree);
+		FREE(tree);
 	}	
 }
 
@@ -175,21 +322,28 @@ SET filterAVL (AVL tree, SET s, condition_t condition, void* arg) {
 	return s;
 }
 
-SET dumpAVL (AVL tree, SET set, void* (*dumper)(void*)){
-	set = dumpNode(tree->head, set, dumper);
+SET prefixSetAVL (AVL tree, SET s, char* prefix) {
+	s = prefixNode(tree->head, s, tree->clone, prefix, strlen(prefix));
+
+	return s;
+}
+
+SET dumpAVL (AVL tree, SET set, void* (*dumper)(void*, void*), void* arg){
+	set = dumpNode(tree->head, set, dumper, arg);
 
 	return set;
 }
 
 static NODE newNode(char *hash, void *content, NODE left, NODE right) {
-	NODE new = malloc(sizeof(struct node));
+	NODE new = MALLOC(sizeof(struct node));
 	int size = strlen(hash);
 
 	new->bal = EH;
-	new->hash = malloc(sizeof(char) * size + 1);
+	new->hash = MALLOC(sizeof(char) * size + 1);
 	new->content = content;
 	new->left = left;
 	new->right = right;
+	new->size = 1 + SIZE(left) + SIZE(right);
 	strcpy(new->hash, hash);
 
 	return new;
@@ -201,9 +355,14 @@ static NODE rotateRight(NODE node) {
 	if (!node || !(node->left))
 		return 0;
 
+	COUNT_ROTATION();
+
 	aux = node->left;
 	node->left = aux->right;
 	aux->right = node;
+
+	resize(node);
+	resize(aux);
 	node = aux;
 
 	return node;
@@ -215,9 +374,14 @@ static NODE rotateLeft(NODE node) {
 	if (!node || !(node->right))
 		return 0;
 
+	COUNT_ROTATION();
+
 	aux = node->right;
 	node->right = aux->left;
 	aux->left = node;
+
+	resize(node);
+	resize(aux);
 	node = aux;
 
 	return node;
@@ -284,6 +448,10 @@ static NODE balanceLeft(NODE node) {
 static NODE insertRight(NODE node, char* hash, void* content, int *update, NODE *last) {
 	node->right = insertNode(node->right, hash, content, update, last);
 
+	/* Só não foi criado um nodo se a hash já existia */
+	if (*update != -1)
+		node->size++;
+
 	if (*update == 1) {
 		switch (node->bal) {
 			case LH:
@@ -307,6 +475,9 @@ static NODE insertRight(NODE node, char* hash, void* content, int *update, NODE
 static NODE insertLeft(NODE node, char* hash, void* content, int *update, NODE *last) {
 	node->left = insertNode(node->left, hash, content, update, last);
 
+	if (*update != -1)
+		node->size++;
+
 	if (*update == 1) {
 		switch (node->bal) {
 			case RH:
@@ -357,11 +528,12 @@ static NODE cloneNode(NODE n, void* (*clone)(void *)) {
 	if (n) {
 		NODE new;
 	
-		new = malloc(sizeof(*new));
-		new->hash = malloc(sizeof(char) * strlen(n->hash) + 1);
+		new = MALLOC(sizeof(*new));
+		new->hash = MALLOC(sizeof(char) * strlen(n->hash) + 1);
 	
 		strcpy(new->hash, n->hash);
 		new->bal = n->bal;
+		new->size = n->size;
 		new->content = (clone) ? clone(n->content) : NULL;
 		new->left = cloneNode(n->left, clone);
 		new->right = cloneNode(n->right, clone);
@@ -398,12 +570,12 @@ static void freeNode(NODE node, void (*freeContent)(void*)) {
 		freeNode(node->left, freeContent);
 		freeNode(node->right, freeContent);
 
-		free(node->hash);
+		FREE(node->hash);
 
 		if (freeContent)
 			freeContent(node->content);
 
-		free(node);
+		FREE(node);
 	}
 }
 
@@ -428,17 +600,17 @@ static SET filterNode(NODE n, SET s, clone_t clone, condition_t condition, void*
 	return s;
 }
 
-static SET dumpNode(NODE n, SET set, void* (*dumper)(void*)) {
+static SET dumpNode(NODE n, SET set, void* (*dumper)(void*, void*), void* arg) {
 	void* element;
 
 	if (n) {
-		set = dumpNode(n->left, set, dumper);
+		set = dumpNode(n->left, set, dumper, arg);
 
-		element = dumper(n->content);
+		element = dumper(n->content, arg);
 		if (element)
 			set = insertElement(set, n->hash, element);
 
-		set = dumpNode(n->right, set, dumper);	
+		set = dumpNode(n->right, set, dumper, arg);	
 	}
 
 	return set;
@@ -461,3 +633,85 @@ static SET addNodeToSet(SET s, NODE node, clone_t clone) {
 
 	return s;
 }
+
+static SET prefixNode(NODE n, SET s, clone_t clone, char* prefix, int len) {
+	void* contCopy;
+	int res;
+
+	if (n) {
+		res = strncmp(n->hash, prefix, len);
+
+		if (res >= 0)
+			s = prefixNode(n->left, s, clone, prefix, len);
+
+		if (res == 0) {
+			contCopy = NULL;
+			if (clone && n->content)
+				contCopy = clone(n->content);
+
+			s = insertElement(s, n->hash, contCopy);
+		}
+
+		if (res <= 0)
+			s = prefixNode(n->right, s, clone, prefix, len);
+	}
+
+	return s;
+}
+
+/**
+ * Coloca no iterador o nodo dado e todos os seus descendentes à esquerda.
+ */
+static AVLITER pushLeft(AVLITER it, NODE node) {
+	while(node) {
+		it->stack[it->top++] = node;
+		node = node->left;
+	}
+
+	return it;
+}
+
+/**
+ * Recalcula o tamanho de um nodo a partir dos seus filhos, depois de uma rotação.
+ */
+static void resize(NODE node) {
+	node->size = 1 + SIZE(node->left) + SIZE(node->right);
+}
+
+/**
+ * Visita os nodos da subárvore entre lo e hi. Só se desce para a esquerda se o nodo não
+ * for menor do que lo, e para a direita se não for maior do que hi.
+ * @return false se o percurso foi terminado pelo visit
+ */
+static bool scanRange(NODE n, char* lo, char* hi, visit_t visit, void* arg) {
+	bool aboveLo, belowHi;
+
+	if (!n) return true;
+
+	aboveLo = !lo || strcmp(n->hash, lo) >= 0;
+	belowHi = !hi || strcmp(n->hash, hi) <= 0;
+
+	if (aboveLo && !scanRange(n->left, lo, hi, visit, arg))
+		return false;
+
+	if (aboveLo && belowHi && !visit(n->hash, n->content, arg))
+		return false;
+
+	return !belowHi || scanRange(n->right, lo, hi, visit, arg);
+}
+
+static bool scanPrefix(NODE n, char* prefix, int len, visit_t visit, void* arg) {
+	int res;
+
+	if (!n) return true;
+
+	res = strncmp(n->hash, prefix, len);
+
+	if (res >= 0 && !scanPrefix(n->left, prefix, len, visit, arg))
+		return false;
+
+	if (res == 0 && !visit(n->hash, n->content, arg))
+		return false;
+
+	return res > 0 || scanPrefix(n->right, prefix, len, visit, arg);
+}
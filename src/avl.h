@@ -6,6 +6,7 @@
 
 typedef struct avl *AVL;
 typedef struct element *ELEMENT;
+typedef struct avl_iterator *AVLITER;
 
 /**
  * Inicia uma AVL com as funções auxiliares dadas.
@@ -55,6 +56,13 @@ ELEMENT newElement();
  */
 void* getAVLcontent (AVL tree, char *hash, ELEMENT elem);
 
+/**
+ * Substitui o conteúdo do nodo com a hash dada pelo resultado de update, que recebe o
+ * conteúdo atual (possivelmente NULL) e arg.
+ * @return false se não existir nenhum nodo com a hash dada
+ */
+bool updateAVLcontent (AVL tree, char *hash, update_t update, void* arg);
+
 /**
  * Atualiza o conteúdo do nodo associado ao elemento dado.
  * @param elem Elemento associado ao nodo a ser atualizado
@@ -92,6 +100,66 @@ bool equalsAVL (AVL tree, AVL b);
  */
 int countNodes (AVL tree);
 
+/**
+ * Devolve o número de rotações feitas por todas as árvores desde o início do programa.
+ */
+long getAVLRotations ();
+
+/**
+ * Devolve a hash na posição k (a partir de 0) da ordem alfabética da árvore, em tempo
+ * logarítmico. A hash pertence à árvore.
+ * @return Hash encontrada, ou NULL se a posição não existir
+ */
+char* selectAVL (AVL tree, int k);
+
+/**
+ * Determina a posição de uma hash na ordem alfabética da árvore, isto é, o número de
+ * hashes menores do que ela, em tempo logarítmico. A hash não tem de existir na árvore.
+ */
+int rankAVL (AVL tree, char* hash);
+
+/**
+ * Visita, por ordem alfabética, os nodos cuja hash está entre lo e hi (inclusive),
+ * ignorando as subárvores que estão fora desses limites.
+ * @param lo Limite inferior, ou NULL se não houver
+ * @param hi Limite superior, ou NULL se não houver
+ * @param visit Função chamada com a hash, o conteúdo do nodo e arg. Se devolver false,
+ * o percurso termina
+ * @return false se o percurso foi terminado por visit
+ */
+bool rangeScanAVL (AVL tree, char* lo, char* hi, visit_t visit, void* arg);
+
+/**
+ * Visita, por ordem alfabética, os nodos cuja hash começa pelo prefixo dado. Tal como
+ * em rangeScanAVL, o percurso termina se visit devolver false.
+ * @return false se o percurso foi terminado por visit
+ */
+bool prefixScanAVL (AVL tree, char* prefix, visit_t visit, void* arg);
+
+/**
+ * Conta as hashes começadas pelo prefixo dado, em tempo logarítmico. Estas ocupam as
+ * posições [rankAVL(tree, prefix), rankAVL(tree, prefix) + countPrefixAVL(tree, prefix)).
+ */
+int countPrefixAVL (AVL tree, char* prefix);
+
+/**
+ * Inicia um iterador que percorre as hashes da árvore por ordem, a partir da posição
+ * dada, que é encontrada em tempo logarítmico. A árvore não pode ser alterada enquanto
+ * o iterador existir.
+ */
+AVLITER initAVLIterator (AVL tree, int pos);
+
+/**
+ * Devolve a próxima hash do iterador, que pertence à árvore, ou NULL se já não houver
+ * mais elementos.
+ */
+char* nextAVLIterator (AVLITER it);
+
+/**
+ * Liberta o iterador.
+ */
+void freeAVLIterator (AVLITER it);
+
 /**
  * Liberta o espaço ocupado pelos nodos da árvore. Se existir uma função free no conjunto de
  * operações da árvore, o conteúdo de cada nodo é também libertado.
@@ -118,6 +186,14 @@ SET addAVLtoSet (SET s, AVL tree);
  */
 SET filterAVL (AVL tree, SET s, condition_t condition, void* arg);
 
+/**
+ * Adiciona ao conjunto de dados indicado os elementos da árvore cuja hash começa pelo
+ * prefixo dado, percorrendo apenas as subárvores onde estes podem estar. O conteúdo
+ * dos nodos é copiado tal como em addAVLtoSet.
+ * @return Set s, agora com os elementos adicionados
+ */
+SET prefixSetAVL (AVL tree, SET s, char* prefix);
+
 /**
  * Transforma o conteúdo de cada nodo, usando a função dumper dada. O resultado do dumper
  * é então adicionado, juntamente com a hash do elemento, ao set dado.
@@ -125,10 +201,11 @@ SET filterAVL (AVL tree, SET s, condition_t condition, void* arg);
  * @param tree Árvore com a informação a ser extraida
  * @param set Local onde a informação será guardada
  * @param dumper Função responsável por extrair o conteúdo dos nodos. O primeiro argumento
- * corresponde à estrutura de dados onde vai ser guardada a informação (data). O segundo
- * argumento corresponde à estrutura de dados presente no conteúdo de cada nodo
+ * corresponde ao conteúdo de cada nodo. O segundo argumento corresponde ao argumento
+ * adicional arg
+ * @param arg Argumento opcional para o dumper
  * @return Estrutura de dados com toda a informação
  */
-SET dumpAVL(AVL tree, SET set, void* (*dumper)(void*));
+SET dumpAVL(AVL tree, SET set, void* (*dumper)(void*, void*), void* arg);
 
 #endif
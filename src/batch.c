@@ -0,0 +1,402 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batch.h"
+#include "dataloader.h"
+#include "engine.h"
+#include "memstat.h"
+#include "loadstats.h"
+
+#define BUFF_SIZE 255
+#define MAX_ARGS 4
+#define MONTHS 12
+#define TOP_PRODUCTS 3
+
+typedef struct batch {
+	SALESINDEX si;
+	FATGLOBAL fat;
+	PRODUCTCAT pcat;
+	CLIENTCAT ccat;
+	FILE* out;
+	char* args[MAX_ARGS + 1];
+	int argc;
+	char* error;
+}*BATCH;
+
+typedef RESULT (*command_t)(BATCH b);
+
+/* Instante e contadores de memória no início de um comando */
+struct mark {
+	struct timespec time;
+	long allocs;
+	long frees;
+	long bytes;
+};
+
+static RESULT batchQ2(BATCH b);
+static RESULT batchQ3(BATCH b);
+static RESULT batchQ4(BATCH b);
+static RESULT batchQ5(BATCH b);
+static RESULT batchQ6(BATCH b);
+static RESULT batchQ7(BATCH b);
+static RESULT batchQ8(BATCH b);
+static RESULT batchQ9(BATCH b);
+static RESULT batchQ10(BATCH b);
+static RESULT batchQ11(BATCH b);
+static RESULT batchQ12(BATCH b);
+static RESULT batchBuyers(BATCH b);
+static RESULT batchMem(BATCH b);
+
+static void printResult(FILE* out, char* query, RESULT r);
+static int argMonth(BATCH b, char* arg);
+static int argBranch(BATCH b, char* arg);
+static struct mark setMark();
+static void printMark(FILE* out, struct mark* m);
+
+static struct command {
+	char* name;
+	int minArgs;
+	int maxArgs;
+	command_t run;
+} commands[] = {
+	{"q2",  1, 1, batchQ2},
+	{"q3",  2, 2, batchQ3},
+	{"q4",  0, 1, batchQ4},
+	{"q5",  1, 1, batchQ5},
+	{"q6",  2, 2, batchQ6},
+	{"q7",  0, 0, batchQ7},
+	{"q8",  2, 2, batchQ8},
+	{"q9",  2, 2, batchQ9},
+	{"q10", 1, 1, batchQ10},
+	{"q11", 1, 1, batchQ11},
+	{"q12", 0, 0, batchQ12},
+	{"buyers", 2, 2, batchBuyers},
+	{"mem", 0, 0, batchMem},
+	{NULL,  0, 0, NULL}
+};
+
+int batchLoad(FILE* out, char** paths, SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat,
+              CLIENTCAT ccat) {
+	FILE *clients, *products, *sales;
+	struct mark m;
+	int nClients, nProducts, success, failed;
+
+	clients  = fopen(paths[0], "r");
+	products = fopen(paths[1], "r");
+	sales    = fopen(paths[2], "r");
+
+	if (!clients || !products || !sales) {
+		fprintf(out, "=load\terror\tficheiro %s inválido ou inexistente\n",
+		        (!clients) ? paths[0] : (!products) ? paths[1] : paths[2]);
+		if (clients) fclose(clients);
+		if (products) fclose(products);
+		if (sales) fclose(sales);
+		return -1;
+	}
+
+	m = setMark();
+	resetLoadStats();
+
+	nClients  = loadClients(clients, ccat);
+	nProducts = loadProducts(products, pcat);
+	success   = loadSales(sales, fat, si, pcat, ccat, &failed);
+
+	fprintf(out, "=load\tok\tclients=%d\tproducts=%d\tsales=%d\tfailed=%d",
+	        nClients, nProducts, success, failed);
+	printMark(out, &m);
+
+	fputs("=profile\tok", out);
+	printLoadStatsFields(out);
+	fputc('\n', out);
+
+	fclose(clients);
+	fclose(products);
+	fclose(sales);
+
+	return 0;
+}
+
+int runBatch(FILE* in, FILE* out, SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat,
+             CLIENTCAT ccat) {
+	struct batch b;
+	struct mark m;
+	RESULT r;
+	char line[BUFF_SIZE], *name;
+	int i, rows, failed = 0;
+
+	b.si   = si;
+	b.fat  = fat;
+	b.pcat = pcat;
+	b.ccat = ccat;
+	b.out  = out;
+
+	while(fgets(line, BUFF_SIZE, in)) {
+		name = strtok(line, " \t\n\r");
+		if (!name || name[0] == '#') continue;
+
+		for(b.argc = 0; b.argc <= MAX_ARGS; b.argc++)
+			if (!(b.args[b.argc] = strtok(NULL, " \t\n\r"))) break;
+
+		for(i = 0; commands[i].name && strcmp(commands[i].name, name); i++);
+
+		b.error = NULL;
+		r = NULL;
+		m = setMark();
+
+		if (!commands[i].name)
+			b.error = "comando desconhecido";
+		else if (b.argc < commands[i].minArgs || b.argc > commands[i].maxArgs)
+			b.error = "número de argumentos inválido";
+		else
+			r = commands[i].run(&b);
+
+		if (!r) {
+			fprintf(out, "=%s\terror\t%s\n", name, b.error);
+			failed++;
+		} else {
+			rows = getResultRows(r);
+			printResult(out, name, r);
+			freeResult(r);
+
+			fprintf(out, "=%s\tok\trows=%d", name, rows);
+			printMark(out, &m);
+		}
+	}
+
+	return failed;
+}
+
+	/*========================= QUERIES ==========================*/
+
+static RESULT batchQ2(BATCH b) {
+	if (b->args[0][0] < 'A' || b->args[0][0] > 'Z') {
+		b->error = "prefixo inválido";
+		return NULL;
+	}
+
+	return getProductsByPrefix(b->pcat, b->args[0]);
+}
+
+static RESULT batchQ3(BATCH b) {
+	PRODUCT product;
+	RESULT r = NULL;
+	int month;
+
+	if ((month = argMonth(b, b->args[1])) == -1) return NULL;
+
+	product = toProduct(b->args[0]);
+	r = getProductRevenue(b->fat, b->pcat, product, month);
+	if (!r) b->error = "produto inválido";
+
+	freeProduct(product);
+	return r;
+}
+
+static RESULT batchQ4(BATCH b) {
+	int branch = -1;
+
+	if (b->argc && (branch = argBranch(b, b->args[0])) == -1) return NULL;
+
+	return getUnsoldProducts(b->fat, branch);
+}
+
+static RESULT batchQ5(BATCH b) {
+	CLIENT client;
+	RESULT r;
+
+	client = toClient(b->args[0]);
+	r = getClientMonthlyQuant(b->si, client);
+	if (!r) b->error = "cliente inválido";
+
+	freeClient(client);
+	return r;
+}
+
+static RESULT batchQ6(BATCH b) {
+	int begin, end;
+
+	if ((begin = argMonth(b, b->args[0])) == -1) return NULL;
+	if ((end = argMonth(b, b->args[1])) == -1) return NULL;
+
+	if (end < begin) {
+		b->error = "mês final anterior ao inicial";
+		return NULL;
+	}
+
+	return getSalesInMonthRange(b->fat, begin, end);
+}
+
+static RESULT batchQ7(BATCH b) {
+	return getLoyalClients(b->si);
+}
+
+static RESULT batchQ8(BATCH b) {
+	PRODUCT product;
+	RESULT r;
+	int branch;
+
+	if ((branch = argBranch(b, b->args[1])) == -1) return NULL;
+
+	product = toProduct(b->args[0]);
+	r = getProductBuyers(b->si, b->pcat, product, branch);
+	if (!r) b->error = "produto inválido";
+
+	freeProduct(product);
+	return r;
+}
+
+static RESULT batchQ9(BATCH b) {
+	CLIENT client;
+	RESULT r;
+	int month;
+
+	if ((month = argMonth(b, b->args[1])) == -1) return NULL;
+
+	client = toClient(b->args[0]);
+	r = getClientFavourites(b->si, client, month);
+	if (!r) b->error = "cliente inválido";
+
+	freeClient(client);
+	return r;
+}
+
+static RESULT batchQ10(BATCH b) {
+	int n = atoi(b->args[0]);
+
+	if (n <= 0) {
+		b->error = "número de produtos inválido";
+		return NULL;
+	}
+
+	return getTopProducts(b->si, n);
+}
+
+static RESULT batchQ11(BATCH b) {
+	CLIENT client;
+	RESULT r;
+
+	client = toClient(b->args[0]);
+	r = getClientTopSpending(b->si, client, TOP_PRODUCTS);
+	if (!r) b->error = "cliente inválido";
+
+	freeClient(client);
+	return r;
+}
+
+static RESULT batchQ12(BATCH b) {
+	return getInactiveCounts(b->si, b->fat);
+}
+
+static RESULT batchBuyers(BATCH b) {
+	int month, quant = atoi(b->args[1]);
+
+	if ((month = argMonth(b, b->args[0])) == -1) return NULL;
+
+	if (quant < 0) {
+		b->error = "quantidade inválida";
+		return NULL;
+	}
+
+	return getClientsAboveQuant(b->si, month, quant);
+}
+
+/**
+ * Contabilidade das alocações, com uma linha por subsistema e uma última linha com o
+ * total (ver memstat.h). Os bytes são arredondados para kB.
+ * Colunas: subsistema, alocações, blocos por libertar, kB por libertar, máximo de kB.
+ */
+static RESULT batchMem(BATCH b) {
+	RESULT r = initResult("ciiii");
+	int tag;
+
+	(void) b;
+
+	for(tag = 0; tag <= MEM_ALL; tag++) {
+		r = addResultRow(r);
+		r = setResultCode(r, 0, getMemTagName(tag));
+		r = setResultInt(r, 1, (int) getMemAllocs(tag));
+		r = setResultInt(r, 2, (int) getMemLiveBlocks(tag));
+		r = setResultInt(r, 3, (int) (getMemLiveBytes(tag) / 1024));
+		r = setResultInt(r, 4, (int) (getMemPeakBytes(tag) / 1024));
+	}
+
+	return r;
+}
+
+	/*========================= AUXILIARES ==========================*/
+
+/**
+ * Escreve cada linha do resultado precedida do nome da query, com os campos separados
+ * por tabs.
+ */
+static void printResult(FILE* out, char* query, RESULT r) {
+	int row, col;
+
+	for(row = 0; row < getResultRows(r); row++) {
+		fputs(query, out);
+
+		for(col = 0; col < getResultCols(r); col++) {
+			switch(getResultColType(r, col)) {
+				case COL_CODE : fprintf(out, "\t%s", getResultCode(r, row, col));
+				                break;
+				case COL_INT  : fprintf(out, "\t%d", getResultInt(r, row, col));
+				                break;
+				default       : fprintf(out, "\t%.2f", getResultDouble(r, row, col));
+			}
+		}
+
+		fputc('\n', out);
+	}
+}
+
+static int argMonth(BATCH b, char* arg) {
+	int month = atoi(arg);
+
+	if (month < 1 || month > MONTHS) {
+		b->error = "mês inválido";
+		return -1;
+	}
+
+	return month - 1;
+}
+
+static int argBranch(BATCH b, char* arg) {
+	int branch = atoi(arg);
+
+	if (branch < 1 || branch > getSalesIndexBranches(b->si)) {
+		b->error = "filial inválida";
+		return -1;
+	}
+
+	return branch - 1;
+}
+
+static struct mark setMark() {
+	struct mark m;
+
+	m.allocs = getAllocCount();
+	m.frees  = getFreeCount();
+	m.bytes  = getAllocBytes();
+	clock_gettime(CLOCK_MONOTONIC, &m.time);
+
+	return m;
+}
+
+/**
+ * Completa a linha de resumo de um comando com o tempo e as alocações desde a marca.
+ */
+static void printMark(FILE* out, struct mark* m) {
+	struct timespec now;
+	long ns;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ns = (now.tv_sec - m->time.tv_sec) * 1000000000L + (now.tv_nsec - m->time.tv_nsec);
+
+	fprintf(out, "\tns=%ld\tallocs=%ld\tfrees=%ld\tbytes=%ld\n", ns,
+	        getAllocCount() - m->allocs, getFreeCount() - m->frees,
+	        getAllocBytes() - m->bytes);
+}
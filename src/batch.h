@@ -0,0 +1,44 @@
+#ifndef __BATCH__
+#define __BATCH__
+
+#include <stdio.h>
+
+#include "salesindex.h"
+#include "fatglobal.h"
+#include "products.h"
+#include "clients.h"
+
+/**
+ * Carrega os catálogos e as vendas sem qualquer interação, escrevendo no fim uma linha
+ * de resumo no formato usado por runBatch, seguida de uma linha "=profile" com os tempos
+ * de cada fase e os contadores da leitura (ver loadstats.h).
+ * @param out Ficheiro onde escrever o resumo
+ * @param paths Caminhos dos ficheiros de clientes, produtos e vendas, por esta ordem
+ * @return 0 se os dados foram carregados, -1 se algum ficheiro não pôde ser aberto
+ */
+int batchLoad(FILE* out, char** paths, SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat,
+              CLIENTCAT ccat);
+
+/**
+ * Executa, sem interação, os comandos lidos de um ficheiro. Cada linha tem o nome da
+ * query seguido dos seus argumentos, com meses e filiais a começar em 1:
+ *
+ *     q2 PREFIXO       q3 PRODUTO MÊS     q4 [FILIAL]     q5 CLIENTE
+ *     q6 MÊS MÊS       q7                 q8 PRODUTO FILIAL
+ *     q9 CLIENTE MÊS   q10 N              q11 CLIENTE     q12
+ *
+ * O comando buyers MÊS QUANTIDADE escreve os clientes que num mês compraram mais do
+ * que a quantidade dada (ver getClientsAboveQuant), e o comando mem a memória ocupada
+ * por cada subsistema (ver memstat.h).
+ * Linhas vazias ou começadas por '#' são ignoradas. Cada linha do resultado começa com
+ * o nome da query e tem os campos separados por tabs. Cada comando termina com uma
+ * linha começada por '=', com o nome da query, "ok" ou "error", o número de linhas
+ * escritas, o tempo de execução em nanosegundos e as alocações feitas.
+ * @param in Ficheiro com os comandos
+ * @param out Ficheiro onde escrever os resultados
+ * @return Número de comandos que falharam
+ */
+int runBatch(FILE* in, FILE* out, SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat,
+             CLIENTCAT ccat);
+
+#endif
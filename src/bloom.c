@@ -0,0 +1,138 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include "bloom.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_CATALOG
+
+#define MASK 0xFFFFFFFFUL
+
+/* Cada bloco ocupa uma linha de cache: 16 palavras de 32 bits */
+#define LINE 64
+#define WORDS 16
+#define BLOCK_BITS (WORDS * 32)
+
+/* O i-ésimo bit de uma chave é tirado dos 9 bits de topo do produto da hash por um
+ * multiplicador ímpar próprio: 4 escolhem a palavra do bloco e 5 o bit na palavra */
+#define MAX_HASHES 16
+#define PRODUCT(h, i) (((h) * salts[i]) & MASK)
+#define WORD(h, i) (PRODUCT(h, i) >> 28)
+#define BIT(h, i) (1U << ((PRODUCT(h, i) >> 23) & 31))
+
+static unsigned long salts[MAX_HASHES] = {
+	0x47b6137bUL, 0x44974d91UL, 0x8824ad5bUL, 0xa2b7289dUL,
+	0x705495c7UL, 0x2df1424bUL, 0x9efc4947UL, 0x5c6bfb31UL,
+	0x9e3779b1UL, 0x85ebca6bUL, 0xc2b2ae35UL, 0x27d4eb2fUL,
+	0x165667b1UL, 0xd3a2646dUL, 0xfd7046c5UL, 0xb55a4f09UL
+};
+
+struct bloom {
+	unsigned int *blocks;   /* alinhado a LINE, dentro de raw */
+	void *raw;
+	unsigned long nBlocks;
+	int hashes;
+};
+
+static void hashKey(char* key, unsigned long* a, unsigned long* b);
+static unsigned long mix(unsigned long h);
+
+BLOOM initBloom(int n, double fpRate, long budget) {
+	BLOOM new = MALLOC(sizeof(*new));
+	double bits, perKey;
+	unsigned long i;
+
+	if (n < 1) n = 1;
+
+	/* Tamanho ótimo de um filtro de Bloom: -ln(p) / ln(2)^2 bits por chave */
+	bits = (fpRate > 0 && fpRate < 1) ? n * -log(fpRate) / (log(2) * log(2)) : 0;
+	if (budget > 0 && bits > budget * 8.0)
+		bits = budget * 8.0;
+
+	new->nBlocks = (unsigned long) (bits / BLOCK_BITS) + 1;
+	perKey = (double) new->nBlocks * BLOCK_BITS / n;
+
+	new->hashes = (int) (perKey * log(2) + 0.5);
+	if (new->hashes < 1) new->hashes = 1;
+	if (new->hashes > MAX_HASHES) new->hashes = MAX_HASHES;
+
+	new->raw = MALLOC(new->nBlocks * LINE + LINE);
+	new->blocks = (unsigned int*) (((unsigned long) new->raw + LINE - 1) & ~(LINE - 1UL));
+
+	for(i = 0; i < new->nBlocks * WORDS; i++)
+		new->blocks[i] = 0;
+
+	return new;
+}
+
+BLOOM addBloom(BLOOM b, char* key) {
+	unsigned long h1, h2;
+	unsigned int* block;
+	int i;
+
+	hashKey(key, &h1, &h2);
+	block = b->blocks + (h1 % b->nBlocks) * WORDS;
+
+	for(i = 0; i < b->hashes; i++)
+		block[WORD(h2, i)] |= BIT(h2, i);
+
+	return b;
+}
+
+bool lookUpBloom(BLOOM b, char* key) {
+	unsigned long h1, h2;
+	unsigned int *block, missing = 0;
+	int i;
+
+	hashKey(key, &h1, &h2);
+	block = b->blocks + (h1 % b->nBlocks) * WORDS;
+
+	/* Sem saltos a meio: a linha é toda lida de uma vez */
+	for(i = 0; i < b->hashes; i++)
+		missing |= BIT(h2, i) & ~block[WORD(h2, i)];
+
+	return !missing;
+}
+
+long getBloomBytes(BLOOM b) {
+	return b->nBlocks * LINE;
+}
+
+int getBloomHashes(BLOOM b) {
+	return b->hashes;
+}
+
+void freeBloom(BLOOM b) {
+	if (b) {
+		FREE(b->raw);
+		FREE(b);
+	}
+}
+
+/**
+ * Calcula, numa só passagem pela chave, as duas hashes de 32 bits que escolhem o bloco
+ * e os bits dentro dele.
+ */
+static void hashKey(char* key, unsigned long* a, unsigned long* b) {
+	unsigned long h = 2166136261UL;
+	unsigned char c;
+
+	while ((c = *key++))
+		h = ((h ^ c) * 16777619UL) & MASK;
+
+	*a = mix(h);
+	*b = mix(*a ^ 0x9747b28cUL);
+}
+
+/**
+ * Espalha os bits de uma hash de 32 bits (finalizador do MurmurHash3).
+ */
+static unsigned long mix(unsigned long h) {
+	h ^= h >> 16;
+	h = (h * 0x85ebca6bUL) & MASK;
+	h ^= h >> 13;
+	h = (h * 0xc2b2ae35UL) & MASK;
+	h ^= h >> 16;
+
+	return h;
+}
@@ -0,0 +1,45 @@
+#ifndef __BLOOM__
+#define __BLOOM__
+
+#include "generic.h"
+
+typedef struct bloom *BLOOM;
+
+/**
+ * Inicia um filtro de Bloom por blocos: cada chave marca todos os seus bits num único
+ * bloco do tamanho de uma linha de cache, pelo que uma consulta lê só essa linha. O
+ * filtro nunca rejeita uma chave adicionada, mas pode aceitar chaves que não o foram.
+ * @param n Número de chaves previsto
+ * @param fpRate Taxa de falsos positivos pretendida para n chaves (por exemplo, 0.01)
+ * @param budget Número máximo de bytes dos bits do filtro, ou 0 para não haver limite;
+ * se o limite obrigar a um filtro mais pequeno, a taxa de falsos positivos aumenta
+ */
+BLOOM initBloom(int n, double fpRate, long budget);
+
+/**
+ * Adiciona uma chave ao filtro.
+ */
+BLOOM addBloom(BLOOM b, char* key);
+
+/**
+ * Verifica se uma chave pode ter sido adicionada ao filtro.
+ * @return false se a chave de certeza não foi adicionada
+ */
+bool lookUpBloom(BLOOM b, char* key);
+
+/**
+ * Devolve o número de bytes ocupados pelos bits do filtro.
+ */
+long getBloomBytes(BLOOM b);
+
+/**
+ * Devolve o número de bits marcados por cada chave.
+ */
+int getBloomHashes(BLOOM b);
+
+/**
+ * Liberta o filtro.
+ */
+void freeBloom(BLOOM b);
+
+#endif
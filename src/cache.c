@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_QUERIES
+
+#define BUCKETS 256
+
+/*
+ * As entradas estão numa tabela de hash com encadeamento, para as procuras, e numa
+ * lista duplamente ligada ordenada pelo último uso, para saber qual descartar.
+ */
+typedef struct entry {
+	char* key;
+	RESULT result;
+	long bytes;
+	struct entry *prev, *next;
+	struct entry *chain;
+}*ENTRY;
+
+struct cache {
+	ENTRY buckets[BUCKETS];
+	ENTRY head, tail;
+	long budget;
+	long used;
+	int generation;
+	long hits;
+	long misses;
+};
+
+static unsigned int hash(char* key);
+static CACHE removeEntry(CACHE c, ENTRY e);
+static CACHE clearCache(CACHE c);
+static CACHE unlinkEntry(CACHE c, ENTRY e);
+static CACHE pushEntry(CACHE c, ENTRY e);
+
+CACHE initCache(long budget) {
+	CACHE new = MALLOC(sizeof(*new));
+	int i;
+
+	for(i = 0; i < BUCKETS; i++)
+		new->buckets[i] = NULL;
+
+	new->head = new->tail = NULL;
+	new->budget = budget;
+	new->used = 0;
+	new->generation = 0;
+	new->hits = new->misses = 0;
+
+	return new;
+}
+
+CACHE setCacheGeneration(CACHE c, int generation) {
+	if (c->generation != generation) {
+		c = clearCache(c);
+		c->generation = generation;
+	}
+
+	return c;
+}
+
+RESULT getCachedResult(CACHE c, char* key) {
+	ENTRY e;
+
+	for(e = c->buckets[hash(key)]; e && strcmp(e->key, key); e = e->chain);
+
+	if (!e) {
+		c->misses++;
+		return NULL;
+	}
+
+	c->hits++;
+	c = unlinkEntry(c, e);
+	c = pushEntry(c, e);
+
+	return retainResult(e->result);
+}
+
+RESULT cacheResult(CACHE c, char* key, RESULT r) {
+	ENTRY e;
+	long bytes;
+	unsigned int h = hash(key);
+
+	if (!r) return r;
+
+	bytes = getResultBytes(r) + strlen(key) + 1 + sizeof(*e);
+	if (bytes > c->budget)
+		return r;
+
+	for(e = c->buckets[h]; e && strcmp(e->key, key); e = e->chain);
+	if (e) c = removeEntry(c, e);
+
+	while(c->used + bytes > c->budget)
+		c = removeEntry(c, c->tail);
+
+	e = MALLOC(sizeof(*e));
+	e->key = MALLOC(strlen(key) + 1);
+	strcpy(e->key, key);
+	e->result = retainResult(r);
+	e->bytes = bytes;
+
+	e->chain = c->buckets[h];
+	c->buckets[h] = e;
+	c->used += bytes;
+	c = pushEntry(c, e);
+
+	return r;
+}
+
+long getCacheHits(CACHE c) {
+	return c->hits;
+}
+
+long getCacheMisses(CACHE c) {
+	return c->misses;
+}
+
+void freeCache(CACHE c) {
+	if (c) {
+		clearCache(c);
+		FREE(c);
+	}
+}
+
+static unsigned int hash(char* key) {
+	unsigned int h = 5381;
+
+	while(*key)
+		h = h * 33 + (unsigned char) *key++;
+
+	return h % BUCKETS;
+}
+
+static CACHE removeEntry(CACHE c, ENTRY e) {
+	ENTRY *p;
+
+	for(p = &c->buckets[hash(e->key)]; *p != e; p = &(*p)->chain);
+	*p = e->chain;
+
+	c = unlinkEntry(c, e);
+	c->used -= e->bytes;
+
+	freeResult(e->result);
+	FREE(e->key);
+	FREE(e);
+
+	return c;
+}
+
+static CACHE clearCache(CACHE c) {
+	while(c->head)
+		c = removeEntry(c, c->head);
+
+	return c;
+}
+
+static CACHE unlinkEntry(CACHE c, ENTRY e) {
+	if (e->prev) e->prev->next = e->next;
+	else c->head = e->next;
+
+	if (e->next) e->next->prev = e->prev;
+	else c->tail = e->prev;
+
+	e->prev = e->next = NULL;
+	return c;
+}
+
+/**
+ * Coloca uma entrada no início da lista, como a usada mais recentemente.
+ */
+static CACHE pushEntry(CACHE c, ENTRY e) {
+	e->prev = NULL;
+	e->next = c->head;
+
+	if (c->head) c->head->prev = e;
+	else c->tail = e;
+
+	c->head = e;
+	return c;
+}
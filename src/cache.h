@@ -0,0 +1,51 @@
+#ifndef __CACHE__
+#define __CACHE__
+
+#include "result.h"
+
+typedef struct cache *CACHE;
+
+/**
+ * Inicializa uma cache de resultados que ocupa no máximo o número de bytes dado. Quando
+ * este limite é atingido, são descartados os resultados usados há mais tempo (LRU).
+ */
+CACHE initCache(long budget);
+
+/**
+ * Indica a geração dos dados carregados. Se esta for diferente da geração atual da
+ * cache, todos os resultados guardados são descartados, uma vez que foram calculados
+ * sobre dados que já não existem.
+ */
+CACHE setCacheGeneration(CACHE c, int generation);
+
+/**
+ * Procura o resultado guardado com uma dada chave, formada pela identificação da
+ * query e pelos seus parâmetros.
+ * @return Resultado encontrado, que deve ser libertado com freeResult, ou NULL
+ */
+RESULT getCachedResult(CACHE c, char* key);
+
+/**
+ * Guarda um resultado na cache com uma dada chave. A cache regista-se como dona do
+ * resultado, pelo que quem o calculou continua a ter de o libertar. Resultados maiores
+ * do que a capacidade da cache, ou NULL, não são guardados.
+ * @return O resultado dado
+ */
+RESULT cacheResult(CACHE c, char* key, RESULT r);
+
+/**
+ * Determina o número de procuras que encontraram um resultado na cache.
+ */
+long getCacheHits(CACHE c);
+
+/**
+ * Determina o número de procuras que não encontraram um resultado na cache.
+ */
+long getCacheMisses(CACHE c);
+
+/**
+ * Liberta a cache e todos os resultados que esta guarda.
+ */
+void freeCache(CACHE c);
+
+#endif
@@ -1,25 +1,89 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #include "catalog.h"
 #include "avl.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_CATALOG
+
+#define LETTERS 26
+
+/* Posição de um carácter entre as letras; os restantes ficam nos extremos */
+#define LETTER(c) ((unsigned char) (c) < 'A' ? 0 : \
+                   (unsigned char) (c) > 'Z' ? LETTERS - 1 : (c) - 'A')
 
 struct catalog{
 	AVL *root;
 	int size;
+	shard_t shard;
+
+	/* Um lock por índice no modo concorrente, NULL caso contrário */
+	pthread_rwlock_t *locks;
+
+	clone_t clone;
+	free_t free;
 };
 
 struct member {
 	ELEMENT element;
 };
 
+/* Percurso de cada índice do catálogo feito por filterCatParallel */
+struct shard_scan {
+	CATALOG cat;
+	SET *sets;
+	condition_t condition;
+	void* arg;
+};
+
+static void scanShards(struct shard_scan* scan, int begin, int end);
+
+/*
+ * Fonte de um cursor sobre os índices [first, last) do catálogo. As posições do cursor
+ * começam na hash offset desses índices.
+ */
+struct catalog_cursor {
+	CATALOG cat;
+	int first, last;
+	int offset;
+	int shard;
+	int pos;
+	AVLITER it;
+};
+
+static CURSOR newCatalogCursor(CATALOG cat, int first, int last, int offset, int size);
+static RESULT readCatalog(struct catalog_cursor* cc, RESULT page, int pos, int n);
+static void seekCatalog(struct catalog_cursor* cc, int pos);
+static void freeCatalogCursor(struct catalog_cursor* cc);
+static SET scanParallel(CATALOG cat, SET set, condition_t condition, void* arg,
+                                                                    THREADPOOL pool);
+static void prefixShards(CATALOG cat, char* prefix, int* first, int* last);
+static int largestShard(CATALOG cat, int n, shard_t shard);
+static bool addPerfectHashCode(char* hash, void* content, PERFECTHASH ph);
+static bool addBloomCode(char* hash, void* content, BLOOM b);
+static void readShard(CATALOG cat, int i);
+static void writeShard(CATALOG cat, int i);
+static void unlockShard(CATALOG cat, int i);
+
 CATALOG initCatalog(int n, clone_t clone, free_t free) {
+	return initShardedCatalog(n, shardByLetter, clone, free);
+}
+
+CATALOG initShardedCatalog(int n, shard_t shard, clone_t clone, free_t free) {
 	CATALOG c;
 	int i;
 
-	c = malloc(sizeof (*c));
-	c->root = malloc(sizeof(*c->root) * n);
+	c = MALLOC(sizeof (*c));
+	c->root = MALLOC(sizeof(*c->root) * n);
 	c->size = n;
+	c->shard = shard;
+	c->locks = NULL;
+	c->clone = clone;
+	c->free = free;
 
 	for (i=0; i < n; i++)
 		c->root[i] = initAVL(NULL, clone, free);
@@ -27,17 +91,123 @@ CATALOG initCatalog(int n, clone_t clone, free_t free) {
 	return c;
 }
 
+CATALOG setCatalogConcurrent(CATALOG cat, bool concurrent) {
+	int i;
+
+	if (concurrent && !cat->locks) {
+		cat->locks = MALLOC(sizeof(pthread_rwlock_t) * cat->size);
+
+		for(i = 0; i < cat->size; i++)
+			pthread_rwlock_init(&cat->locks[i], NULL);
+	}
+	else if (!concurrent && cat->locks) {
+		for(i = 0; i < cat->size; i++)
+			pthread_rwlock_destroy(&cat->locks[i]);
+
+		FREE(cat->locks);
+		cat->locks = NULL;
+	}
+
+	return cat;
+}
+
+bool isConcurrentCatalog(CATALOG cat) {
+	return cat->locks != NULL;
+}
+
 CATALOG changeCatalogOps (CATALOG cat, clone_t clone, free_t free){
 	int i, size = cat->size;
 	
 	for(i = 0; i < size; i++)
 		changeOps(cat->root[i], NULL, clone, free);
 
+	cat->clone = clone;
+	cat->free = free;
+
 	return cat;
 }
 
-CATALOG insertCatalog(CATALOG cat, int i, char *hash, void *content) {
+int shardByLetter(char* hash, int shards) {
+	return LETTER(hash[0]) * shards / LETTERS;
+}
+
+int shardByPrefix(char* hash, int shards) {
+	int key = LETTER(hash[0]) * LETTERS;
+
+	if (hash[0]) key += LETTER(hash[1]);
+
+	return key * shards / (LETTERS * LETTERS);
+}
+
+int shardByHash(char* hash, int shards) {
+	unsigned int h = 5381;
+
+	while(*hash)
+		h = h * 33 + (unsigned char) *hash++;
+
+	return h % shards;
+}
+
+int getCatalogShard(CATALOG cat, char* hash) {
+	return cat->shard(hash, cat->size);
+}
+
+int getCatalogShards(CATALOG cat) {
+	return cat->size;
+}
+
+CATALOG reshardCatalog(CATALOG cat, int n, shard_t shard) {
+	AVL *old = cat->root;
+	AVLITER it;
+	char* hash;
+	int i, size = cat->size;
+	bool concurrent = isConcurrentCatalog(cat);
+
+	cat = setCatalogConcurrent(cat, false);
+	cat->root = MALLOC(sizeof(*cat->root) * n);
+	cat->size = n;
+	cat->shard = shard;
+
+	for(i = 0; i < n; i++)
+		cat->root[i] = initAVL(NULL, cat->clone, cat->free);
+
+	/* Os conteúdos passam para as novas árvores, pelo que não são libertados */
+	for(i = 0; i < size; i++) {
+		it = initAVLIterator(old[i], 0);
+
+		while((hash = nextAVLIterator(it)))
+			cat = insertCatalog(cat, hash, getAVLcontent(old[i], hash, NULL));
+
+		freeAVLIterator(it);
+		freeAVL(changeOps(old[i], NULL, NULL, NULL));
+	}
+
+	FREE(old);
+	return setCatalogConcurrent(cat, concurrent);
+}
+
+CATALOG balanceCatalog(CATALOG cat, int target) {
+	int n = countAllElems(cat) / target;
+
+	if (cat->shard == shardByHash) return cat;
+
+	if (n < LETTERS) n = LETTERS;
+	if (n > LETTERS * LETTERS) n = LETTERS * LETTERS;
+
+	if (n == cat->size && cat->shard == shardByPrefix) return cat;
+
+	if (largestShard(cat, n, shardByPrefix) < largestShard(cat, cat->size, cat->shard))
+		cat = reshardCatalog(cat, n, shardByPrefix);
+
+	return cat;
+}
+
+CATALOG insertCatalog(CATALOG cat, char *hash, void *content) {
+	int i = getCatalogShard(cat, hash);
+
+	writeShard(cat, i);
 	cat->root[i] = insertAVL(cat->root[i], hash, content);
+	unlockShard(cat, i);
 
 	return cat;
 }
@@ -46,8 +216,11 @@ bool isEmptyCatalog (CATALOG cat) {
 	int i;
 	bool r = true;
 
-	for (i = 0; r && i < cat->size ; i++) 
+	for (i = 0; r && i < cat->size ; i++) {
+		readShard(cat, i);
 		r = isEmptyAVL(cat->root[i]);
+		unlockShard(cat, i);
+	}
 
 	return r;
 }
@@ -56,30 +229,54 @@ CATALOG cloneCatalog(CATALOG cat){
 	CATALOG c;
 	int i, size = cat->size;
 
-	c = malloc(sizeof(*c));
-	c->root = malloc(sizeof(*c->root) * size);
+	c = MALLOC(sizeof(*c));
+	c->root = MALLOC(sizeof(*c->root) * size);
 	c->size = size;
+	c->shard = cat->shard;
+	c->locks = NULL;
+	c->clone = cat->clone;
+	c->free = cat->free;
 
-	for (i = 0; i < size; i++)
+	for (i = 0; i < size; i++) {
+		readShard(cat, i);
 		c->root[i] = cloneAVL(cat->root[i]);
+		unlockShard(cat, i);
+	}
 
-	return c;
+	return setCatalogConcurrent(c, isConcurrentCatalog(cat));
 }
 
 MEMBER newMember() {
-	MEMBER member = malloc(sizeof(*member));
+	MEMBER member = MALLOC(sizeof(*member));
 	member->element = newElement();
 	
 	return member;
 }
 
-void* getCatContent(CATALOG c, int index, char *hash, MEMBER member) {
+void* getCatContent(CATALOG c, char *hash, MEMBER member) {
 	ELEMENT elem = NULL;
+	void* content;
+	int i = getCatalogShard(c, hash);
 
 	if (member)
 		elem = member->element;
 	
-	return getAVLcontent(c->root[index], hash, elem);
+	readShard(c, i);
+	content = getAVLcontent(c->root[i], hash, elem);
+	unlockShard(c, i);
+
+	return content;
+}
+
+bool updateCatContent(CATALOG cat, char* hash, update_t update, void* arg) {
+	bool found;
+	int i = getCatalogShard(cat, hash);
+
+	writeShard(cat, i);
+	found = updateAVLcontent(cat->root[i], hash, update, arg);
+	unlockShard(cat, i);
+
+	return found;
 }
 
 void updateMember(MEMBER member, void* content) {
@@ -89,25 +286,45 @@ void updateMember(MEMBER member, void* content) {
 void freeMember(MEMBER member) {
 	if (member) {
 		freeElement(member->element);
-		free(member);
+		FREE(member);
 	}	
 }
 
-bool lookUpCatalog(CATALOG cat, int index, char *hash) {
-	return lookUpAVL(cat->root[index], hash);
+bool lookUpCatalog(CATALOG cat, char *hash) {
+	bool found;
+	int i = getCatalogShard(cat, hash);
+
+	readShard(cat, i);
+	found = lookUpAVL(cat->root[i], hash);
+	unlockShard(cat, i);
+
+	return found;
 }
 
 int countAllElems(CATALOG cat) {
 	int i, size = 0, catSize = cat->size;
 
-	for(i = 0; i < catSize; i++)
+	for(i = 0; i < catSize; i++) {
+		readShard(cat, i);
 		size += countNodes(cat->root[i]);
+		unlockShard(cat, i);
+	}
 
 	return size;
 }
 
-int countPosElems(CATALOG c, int index){
-	return countNodes(c->root[index]);
+int countPrefixElems(CATALOG cat, char* prefix) {
+	int i, first, last, size = 0;
+
+	prefixShards(cat, prefix, &first, &last);
+
+	for(i = first; i < last; i++) {
+		readShard(cat, i);
+		size += countPrefixAVL(cat->root[i], prefix);
+		unlockShard(cat, i);
+	}
+
+	return size;
 }
 
 void freeCatalog(CATALOG cat){
@@ -115,17 +332,26 @@ void freeCatalog(CATALOG cat){
 
 	if (cat){
 		size = cat->size;
+		cat = setCatalogConcurrent(cat, false);
 
 		for (i=0; i < size; i++)
 			freeAVL(cat->root[i]);
 
-		free(cat->root);
-		free(cat);
+		FREE(cat->root);
+		FREE(cat);
 	}
 }
 
-SET fillSet(CATALOG cat, SET set, int index) {
-	set = addAVLtoSet(set, cat->root[index]);
+SET fillPrefixSet(CATALOG cat, SET set, char* prefix) {
+	int i, first, last;
+
+	prefixShards(cat, prefix, &first, &last);
+
+	for(i = first; i < last; i++) {
+		readShard(cat, i);
+		set = prefixSetAVL(cat->root[i], set, prefix);
+		unlockShard(cat, i);
+	}
 
 	return set;
 }
@@ -136,8 +362,11 @@ SET fillAllSet(CATALOG cat, SET set) {
 	if (size == 0)
 		return NULL;
 
-	for(i = 0; i < size; i++)
+	for(i = 0; i < size; i++) {
+		readShard(cat, i);
 		set = addAVLtoSet(set, cat->root[i]);
+		unlockShard(cat, i);
+	}
 
 	return set;
 }
@@ -145,17 +374,326 @@ SET fillAllSet(CATALOG cat, SET set) {
 SET filterCat (CATALOG cat, SET set, condition_t condition, void* arg) {
 	int i, size = cat->size;
 
-	for(i = 0; i < size; i++)
+	for(i = 0; i < size; i++) {
+		readShard(cat, i);
 		set = filterAVL(cat->root[i], set, condition, arg);
+		unlockShard(cat, i);
+	}
+
+	return set;
+}
+
+SET fillAllSetParallel(CATALOG cat, SET set, THREADPOOL pool) {
+	if (!pool) return fillAllSet(cat, set);
+
+	return scanParallel(cat, set, NULL, NULL, pool);
+}
+
+SET filterCatParallel(CATALOG cat, SET set, condition_t condition, void* arg,
+                                                                   THREADPOOL pool) {
+	if (!pool) return filterCat(cat, set, condition, arg);
+
+	return scanParallel(cat, set, condition, arg, pool);
+}
+
+char* selectCatalog(CATALOG cat, int k) {
+	char* hash = NULL;
+	int i, size;
+
+	for(i = 0; k >= 0 && !hash && i < cat->size; i++) {
+		readShard(cat, i);
+		size = countNodes(cat->root[i]);
+
+		if (k < size) hash = selectAVL(cat->root[i], k);
+		else k -= size;
+
+		unlockShard(cat, i);
+	}
+
+	return hash;
+}
+
+int rankCatalog(CATALOG cat, char* hash) {
+	int i, rank = 0, index = getCatalogShard(cat, hash);
+
+	for(i = 0; i <= index; i++) {
+		readShard(cat, i);
+		rank += (i < index) ? countNodes(cat->root[i]) : rankAVL(cat->root[i], hash);
+		unlockShard(cat, i);
+	}
+
+	return rank;
+}
+
+PERFECTHASH perfectHashCatalog(CATALOG cat) {
+	PERFECTHASH ph = initPerfectHash(countAllElems(cat));
+
+	rangeScanCatalog(cat, NULL, NULL, (visit_t) addPerfectHashCode, ph);
+
+	return buildPerfectHash(ph);
+}
+
+BLOOM bloomCatalog(CATALOG cat, double fpRate, long budget) {
+	BLOOM b = initBloom(countAllElems(cat), fpRate, budget);
+
+	rangeScanCatalog(cat, NULL, NULL, (visit_t) addBloomCode, b);
+
+	return b;
+}
+
+bool rangeScanCatalog(CATALOG cat, char* lo, char* hi, visit_t visit, void* arg) {
+	bool done;
+	int i, first = 0, last = cat->size;
+
+	/* Com uma distribuição ordenada, só os índices entre os limites são percorridos */
+	if (cat->shard != shardByHash) {
+		if (lo) first = getCatalogShard(cat, lo);
+		if (hi) last = getCatalogShard(cat, hi) + 1;
+	}
+
+	for(i = first; i < last; i++) {
+		readShard(cat, i);
+		done = rangeScanAVL(cat->root[i], lo, hi, visit, arg);
+		unlockShard(cat, i);
+
+		if (!done) return false;
+	}
+
+	return true;
+}
+
+bool prefixScanCatalog(CATALOG cat, char* prefix, visit_t visit, void* arg) {
+	bool done;
+	int i, first, last;
+
+	prefixShards(cat, prefix, &first, &last);
+
+	for(i = first; i < last; i++) {
+		readShard(cat, i);
+		done = prefixScanAVL(cat->root[i], prefix, visit, arg);
+		unlockShard(cat, i);
+
+		if (!done) return false;
+	}
+
+	return true;
+}
+
+CURSOR initPrefixCursor(CATALOG cat, char* prefix) {
+	int first, last, offset;
+
+	prefixShards(cat, prefix, &first, &last);
+
+	readShard(cat, first);
+	offset = rankAVL(cat->root[first], prefix);
+	unlockShard(cat, first);
+
+	return newCatalogCursor(cat, first, last, offset, countPrefixElems(cat, prefix));
+}
+
+CURSOR initCatalogCursor(CATALOG cat) {
+	return initPrefixCursor(cat, "");
+}
+
+SET dumpCatalog(CATALOG cat, SET set, void* (*dumper)(void*, void*), void* arg) {
+	int i, size = cat->size;
+
+	for (i = 0; i < size; i++) {
+		readShard(cat, i);
+		set = dumpAVL(cat->root[i], set, dumper, arg);
+		unlockShard(cat, i);
+	}
 
 	return set;
 }
 
-SET dumpCatalog(CATALOG cat, SET set, void* (*dumper)(void*)) {
+/**
+ * Percorre os índices do catálogo em paralelo, um por pedaço do parallelFor, guardando
+ * os elementos de cada um num set próprio. Como os índices têm tamanhos muito
+ * diferentes, os trabalhadores que acabam primeiro roubam os restantes. No fim, os sets
+ * são juntados ao set dado pela ordem dos índices.
+ * @param condition Condição a aplicar aos elementos, ou NULL para os aceitar todos
+ */
+static SET scanParallel(CATALOG cat, SET set, condition_t condition, void* arg,
+                                                                    THREADPOOL pool) {
+	struct shard_scan scan;
 	int i, size = cat->size;
 
-	for (i = 0; i < size; i++)
-		set = dumpAVL(cat->root[i], set, dumper);
+	scan.cat = cat;
+	scan.sets = MALLOC(sizeof(SET) * size);
+	scan.condition = condition;
+	scan.arg = arg;
+
+	pool = parallelFor(pool, 0, size, 1, (range_t) scanShards, &scan);
+
+	for(i = 0; i < size; i++)
+		set = appendSet(set, scan.sets[i]);
 
+	FREE(scan.sets);
 	return set;
 }
+
+static void scanShards(struct shard_scan* scan, int begin, int end) {
+	AVL tree;
+	int i;
+
+	for(i = begin; i < end; i++) {
+		readShard(scan->cat, i);
+		tree = scan->cat->root[i];
+		scan->sets[i] = initSet(countNodes(tree) + 1, NULL);
+
+		if (scan->condition)
+			scan->sets[i] = filterAVL(tree, scan->sets[i], scan->condition, scan->arg);
+		else
+			scan->sets[i] = addAVLtoSet(scan->sets[i], tree);
+
+		unlockShard(scan->cat, i);
+	}
+}
+
+/**
+ * Determina os índices [first, last) onde podem estar as hashes começadas pelo prefixo
+ * dado. Como as distribuições ordenadas nunca trocam a ordem de duas hashes, basta
+ * calcular o índice do prefixo e o do prefixo seguido do maior carácter ASCII.
+ */
+static void prefixShards(CATALOG cat, char* prefix, int* first, int* last) {
+	char* upper;
+	int size = strlen(prefix);
+
+	if (cat->shard == shardByHash) {
+		*first = 0;
+		*last = cat->size;
+		return;
+	}
+
+	upper = MALLOC(size + 2);
+	strcpy(upper, prefix);
+	upper[size] = '\177';
+	upper[size + 1] = '\0';
+
+	*first = getCatalogShard(cat, prefix);
+	*last = getCatalogShard(cat, upper) + 1;
+
+	FREE(upper);
+}
+
+/**
+ * Determina o tamanho do maior índice que o catálogo teria se as hashes fossem
+ * distribuídas por n índices com a função dada.
+ */
+static int largestShard(CATALOG cat, int n, shard_t shard) {
+	AVLITER it;
+	char* hash;
+	int i, largest = 0, *sizes = CALLOC(n, sizeof(int));
+
+	for(i = 0; i < cat->size; i++) {
+		it = initAVLIterator(cat->root[i], 0);
+
+		while((hash = nextAVLIterator(it)))
+			sizes[shard(hash, n)]++;
+
+		freeAVLIterator(it);
+	}
+
+	for(i = 0; i < n; i++)
+		if (sizes[i] > largest) largest = sizes[i];
+
+	FREE(sizes);
+	return largest;
+}
+
+static CURSOR newCatalogCursor(CATALOG cat, int first, int last, int offset, int size) {
+	struct catalog_cursor *cc = MALLOC(sizeof(*cc));
+
+	cc->cat = cat;
+	cc->first = first;
+	cc->last = last;
+	cc->offset = offset;
+	cc->shard = first;
+	cc->pos = 0;
+	cc->it = NULL;
+
+	return initCursor(cc, size, "c", (read_t) readCatalog, (free_t) freeCatalogCursor);
+}
+
+/**
+ * Lê as hashes seguintes do catálogo. Leituras seguidas continuam o percurso da leitura
+ * anterior; caso contrário, o iterador é reposicionado.
+ */
+static RESULT readCatalog(struct catalog_cursor* cc, RESULT page, int pos, int n) {
+	char* hash;
+
+	pos += cc->offset;
+	if (!cc->it || pos != cc->pos)
+		seekCatalog(cc, pos);
+
+	while(n > 0 && cc->it) {
+		if ((hash = nextAVLIterator(cc->it))) {
+			page = addResultRow(page);
+			page = setResultCode(page, 0, hash);
+			cc->pos++;
+			n--;
+			continue;
+		}
+
+		freeAVLIterator(cc->it);
+		cc->it = (++cc->shard < cc->last) ? initAVLIterator(cc->cat->root[cc->shard], 0)
+		                                  : NULL;
+	}
+
+	return page;
+}
+
+/**
+ * Posiciona o iterador numa dada hash, saltando os índices anteriores pelo seu tamanho
+ * e descendo depois na árvore do índice, em tempo logarítmico.
+ */
+static void seekCatalog(struct catalog_cursor* cc, int pos) {
+	int shard, skip = pos;
+
+	for(shard = cc->first; shard < cc->last && skip >= countNodes(cc->cat->root[shard]);
+	    shard++)
+		skip -= countNodes(cc->cat->root[shard]);
+
+	if (cc->it) freeAVLIterator(cc->it);
+
+	cc->shard = shard;
+	cc->pos = pos;
+	cc->it = (shard < cc->last) ? initAVLIterator(cc->cat->root[shard], skip) : NULL;
+}
+
+static void freeCatalogCursor(struct catalog_cursor* cc) {
+	if (cc->it) freeAVLIterator(cc->it);
+	FREE(cc);
+}
+
+static bool addPerfectHashCode(char* hash, void* content, PERFECTHASH ph) {
+	(void) content;
+
+	addPerfectHashKey(ph, hash);
+	return true;
+}
+
+static bool addBloomCode(char* hash, void* content, BLOOM b) {
+	(void) content;
+
+	addBloom(b, hash);
+	return true;
+}
+
+/*
+ * Locks de cada índice. Fora do modo concorrente não fazem nada, pelo que o catálogo
+ * não paga pelos locks quando é usado por uma só thread.
+ */
+
+static void readShard(CATALOG cat, int i) {
+	if (cat->locks) pthread_rwlock_rdlock(&cat->locks[i]);
+}
+
+static void writeShard(CATALOG cat, int i) {
+	if (cat->locks) pthread_rwlock_wrlock(&cat->locks[i]);
+}
+
+static void unlockShard(CATALOG cat, int i) {
+	if (cat->locks) pthread_rwlock_unlock(&cat->locks[i]);
+}
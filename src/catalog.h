@@ -3,12 +3,43 @@
 
 #include "generic.h"
 #include "set.h"
+#include "threadpool.h"
+#include "cursor.h"
+#include "perfecthash.h"
+#include "bloom.h"
 
 typedef struct catalog *CATALOG;
 typedef struct member* MEMBER;
 
 /**
- * Inicia um catálogo com o tamanho e funções auxiliares dadas.
+ * Distribui as hashes pelos índices de um catálogo: devolve o índice, entre 0 e
+ * shards - 1, onde fica a hash dada.
+ */
+typedef int (*shard_t)(char* hash, int shards);
+
+/**
+ * Distribui as hashes pela primeira letra. Com 26 índices, cada letra tem o seu.
+ */
+int shardByLetter (char* hash, int shards);
+
+/**
+ * Distribui as hashes pelas duas primeiras letras. Com 676 índices, cada par de letras
+ * tem o seu; com menos, pares seguidos partilham o mesmo índice. Os dígitos contam
+ * como a primeira letra.
+ */
+int shardByPrefix (char* hash, int shards);
+
+/**
+ * Distribui as hashes por uma função de hash, o que equilibra os índices seja qual for
+ * a forma dos códigos. Ao contrário das anteriores, não mantém a ordem das hashes entre
+ * índices, pelo que os percursos por prefixo e intervalo visitam todos os índices e a
+ * ordem de selectCatalog e dos cursores deixa de ser alfabética.
+ */
+int shardByHash (char* hash, int shards);
+
+/**
+ * Inicia um catálogo com o tamanho e funções auxiliares dadas, com as hashes
+ * distribuídas pela primeira letra (ver shardByLetter).
  * @param n Número de indíces que o catálogo terá
  * @param init Inicia o conteúdo de um elemento quando necessário
  * @param clone Função capaz de clonar o conteúdo de um elemento do catálogo
@@ -16,6 +47,55 @@ typedef struct member* MEMBER;
  */
 CATALOG initCatalog (int n, clone_t clone, free_t free);
 
+/**
+ * Inicia um catálogo cujas hashes são distribuídas pelos n índices com a função dada.
+ * @param shard Função de distribuição, que é mantida pelos clones do catálogo
+ */
+CATALOG initShardedCatalog (int n, shard_t shard, clone_t clone, free_t free);
+
+/**
+ * Determina o índice do catálogo onde está, ou estaria, a hash dada.
+ */
+int getCatalogShard (CATALOG cat, char* hash);
+
+/**
+ * Determina o número de índices do catálogo.
+ */
+int getCatalogShards (CATALOG cat);
+
+/**
+ * Redistribui os elementos do catálogo por n índices, com a função dada. Os elementos
+ * (e o seu conteúdo) passam para os novos índices sem serem copiados.
+ */
+CATALOG reshardCatalog (CATALOG cat, int n, shard_t shard);
+
+/**
+ * Escolhe, a partir dos elementos já inseridos, o número de índices do catálogo, para
+ * que cada um tenha perto de target elementos. Se uma distribuição pelas duas primeiras
+ * letras (entre 26 e 676 índices) diminuir o maior índice, o catálogo é redistribuído;
+ * caso contrário fica como está. A ordem das hashes é sempre mantida, e os catálogos
+ * distribuídos por hash não são alterados.
+ */
+CATALOG balanceCatalog (CATALOG cat, int target);
+
+/**
+ * Liga ou desliga o modo concorrente do catálogo. Neste modo cada índice tem um lock de
+ * leitura/escrita: as inserções e updateCatContent bloqueiam apenas o índice da hash,
+ * pelo que várias threads podem alterar índices diferentes ao mesmo tempo, e as
+ * consultas e percursos bloqueiam cada índice para leitura enquanto o percorrem.
+ *
+ * A mudança de modo, changeCatalogOps, reshardCatalog, balanceCatalog, freeCatalog e os
+ * cursores não são protegidos e não podem correr em paralelo com outras operações. As
+ * funções passadas aos percursos (condições, visit, dumpers) correm com o índice
+ * bloqueado, pelo que não podem alterar o catálogo.
+ */
+CATALOG setCatalogConcurrent (CATALOG cat, bool concurrent);
+
+/**
+ * Verifica se o catálogo está no modo concorrente.
+ */
+bool isConcurrentCatalog (CATALOG cat);
+
 /**
  * Altera as operações com que o catálogo foi inicializado.
  * @param cat Catálogo cujas operações serão mudadas
@@ -26,15 +106,14 @@ CATALOG initCatalog (int n, clone_t clone, free_t free);
 CATALOG changeCatalogOps (CATALOG cat, clone_t clone, free_t free);
 
 /** 
- * Insere no índice especificado do catálogo um elemento com a hash e o conteúdo dados.
- * Se o nodo já existir, nada faz.
+ * Insere no catálogo um elemento com a hash e o conteúdo dados. Se o nodo já existir,
+ * nada faz.
  * @param cat Catálogo onde será inserido o novo elemento
- * @param index Índice do catálogo onde o elemento deverá ser inserido
  * @param hash String que identifica o elemento
  * @param content Conteúdo a ser colocado no elemento
  * @result Catálogo com o elemento adicionado
  */
-CATALOG insertCatalog (CATALOG cat, int index, char* hash, void* content);
+CATALOG insertCatalog (CATALOG cat, char* hash, void* content);
 
 /**
  * Cria um novo membro vazio. Um membro pode ser associado a um item do catálogo para
@@ -68,30 +147,36 @@ CATALOG cloneCatalog (CATALOG cat);
  * Devolve o conteúdo do elemento com a hash dada. Se o nodo não tiver conteúdo mas
  * existir uma função init, o conteúdo é inicializado antes de ser devolvido.
  * @param cat Catálogo a ser pesquisado
- * @param index Índice do catálogo onde se encontra o elemento pretendido
  * @param hash Indentificador do elemento
  * @return Conteúdo do elemento
  */
-void* getCatContent (CATALOG cat, int index, char* hash, MEMBER member);
+void* getCatContent (CATALOG cat, char* hash, MEMBER member);
+
+/**
+ * Substitui o conteúdo do elemento com a hash dada pelo resultado de update, chamada
+ * com o conteúdo atual (NULL se ainda não tiver) e arg. No modo concorrente, update
+ * corre com o índice do elemento bloqueado para escrita, pelo que é a forma segura de
+ * alterar conteúdos: um MEMBER obtido com getCatContent não mantém o lock.
+ * @return false se o elemento não existir
+ */
+bool updateCatContent (CATALOG cat, char* hash, update_t update, void* arg);
 
 /**
  * Adiciona um elemento com a hash dada à árvore, inicializando o conteúdo com a função
  * init (requerida) existente nas operações. Se o elemento já existir apenas devolve o
  * conteúdo, inicializando-o se necessário.
  * @param cat Catálogo onde se pretendo inserir o elemento
- * @param index Índice do catálogo onde se pretente inserir o elemento
  * @param hash Identificador do elemento que se pretende inserir
  * @return Conteúdo do nodo com a hash dada
  */
-void* addCatalog (CATALOG cat, int index, char *hash);
+void* addCatalog (CATALOG cat, char *hash);
 
 /**
  * Verifica se existe um nodo com o identificador hash.
  * @param cat Catálogo a ser pesquisado.
- * @param index Índice do catálogo a ser pesquisado
  * @param hash Identificador do elemento procurado
  */
-bool lookUpCatalog (CATALOG cat, int index, char* hash);
+bool lookUpCatalog (CATALOG cat, char* hash);
 
 /**
  * Calcula o número de elementos existentes em todo o catálogo.
@@ -99,9 +184,9 @@ bool lookUpCatalog (CATALOG cat, int index, char* hash);
 int countAllElems (CATALOG cat);
 
 /**
- * Calcula o número de elementos existentes num nodo do catálogo.
+ * Calcula o número de elementos do catálogo cuja hash começa pelo prefixo dado.
  */
-int countPosElems (CATALOG cat, int index);
+int countPrefixElems (CATALOG cat, char* prefix);
 
 /**
  * Liberta o espaço ocupado por todos os elementos do catálogo. Se existir uma função free
@@ -110,14 +195,14 @@ int countPosElems (CATALOG cat, int index);
 void freeCatalog (CATALOG cat);
 
 /**
- * Adiciona a um conjunto de dados todos os elementos existentes num dado índice do
- * catálogo.
+ * Adiciona a um conjunto de dados todos os elementos do catálogo cuja hash começa pelo
+ * prefixo dado.
  * @param cat Catálogo com os elementos pretendidos
  * @param set Conjunto de dados onde serão inseridos os elementos pretendidos
- * @param index Índice do catálogo cujos elementos serão inseridos
+ * @param prefix Prefixo das hashes dos elementos que serão inseridos
  * @return Conjunto de dados com os novos elementos adicionados
  */
-SET fillSet (CATALOG cat, SET set, int index);
+SET fillPrefixSet (CATALOG cat, SET set, char* prefix);
 
 /**
  * Adiciona a um conjunto de dados todos os elementos existentes num catálogo.
@@ -142,6 +227,87 @@ SET fillAllSet (CATALOG cat, SET set);
  */
 SET filterCat(CATALOG cat, SET set, condition_t condition, void* arg);
 
+/**
+ * Igual a fillAllSet, mas cada índice do catálogo é percorrido por um dos trabalhadores
+ * do pool dado. Os elementos são adicionados ao set pela mesma ordem.
+ * @param pool Trabalhadores a usar; se for NULL o catálogo é percorrido sequencialmente
+ */
+SET fillAllSetParallel(CATALOG cat, SET set, THREADPOOL pool);
+
+/**
+ * Igual a filterCat, mas cada índice do catálogo é filtrado por um dos trabalhadores
+ * do pool dado. Os elementos são adicionados ao set pela mesma ordem, pelo que o
+ * resultado é o mesmo. A condição não pode alterar o conteúdo dos elementos.
+ * @param pool Trabalhadores a usar; se for NULL o catálogo é filtrado sequencialmente
+ */
+SET filterCatParallel(CATALOG cat, SET set, condition_t condition, void* arg,
+                                                                   THREADPOOL pool);
+
+/**
+ * Devolve a hash na posição k (a partir de 0) do catálogo, percorrido pela ordem dos
+ * índices e, em cada índice, por ordem alfabética. Os índices anteriores são saltados
+ * pelo seu tamanho, pelo que o custo é logarítmico no tamanho do índice.
+ * @return Hash encontrada, que pertence ao catálogo, ou NULL se a posição não existir
+ */
+char* selectCatalog(CATALOG cat, int k);
+
+/**
+ * Determina a posição de uma hash no catálogo, pela mesma ordem de selectCatalog. A
+ * hash não tem de existir no catálogo.
+ */
+int rankCatalog(CATALOG cat, char* hash);
+
+/**
+ * Constrói uma função de hash perfeita sobre as hashes do catálogo, em que o
+ * identificador de cada hash é a sua posição pela ordem de selectCatalog. Deixa de
+ * corresponder ao catálogo se este for alterado.
+ * @return A função, ou NULL se não tiver sido possível construí-la
+ */
+PERFECTHASH perfectHashCatalog(CATALOG cat);
+
+/**
+ * Constrói um filtro de Bloom com as hashes do catálogo (ver initBloom), que rejeita
+ * sem percorrer o catálogo a maior parte das hashes que lá não estão. Deixa de
+ * corresponder ao catálogo se lhe forem adicionados elementos.
+ */
+BLOOM bloomCatalog(CATALOG cat, double fpRate, long budget);
+
+/**
+ * Visita os elementos do catálogo cuja hash está entre lo e hi (inclusive), pela ordem
+ * dos índices e, em cada índice, por ordem alfabética. Só são percorridos os índices e,
+ * em cada um, as subárvores que podem ter hashes dentro dos limites, e nenhum set é
+ * criado. Se visit devolver false, o percurso termina.
+ * @param lo Limite inferior, ou NULL se não houver
+ * @param hi Limite superior, ou NULL se não houver
+ * @param visit Função chamada com a hash, o conteúdo do elemento e arg
+ * @return false se o percurso foi terminado por visit
+ */
+bool rangeScanCatalog(CATALOG cat, char* lo, char* hi, visit_t visit, void* arg);
+
+/**
+ * Visita, pela ordem do catálogo, os elementos cuja hash começa pelo prefixo dado,
+ * percorrendo apenas os índices onde estes podem estar. Se visit devolver false, o
+ * percurso termina.
+ * @return false se o percurso foi terminado por visit
+ */
+bool prefixScanCatalog(CATALOG cat, char* prefix, visit_t visit, void* arg);
+
+/**
+ * Cria um cursor sobre as hashes do catálogo começadas pelo prefixo dado. Tanto o
+ * tamanho do cursor como cada página são obtidos em tempo logarítmico, diretamente das
+ * árvores. Requer uma distribuição que mantenha a ordem das hashes (ver shardByHash), e
+ * o catálogo não pode ser alterado enquanto o cursor existir.
+ * @return Cursor com uma coluna de códigos
+ */
+CURSOR initPrefixCursor(CATALOG cat, char* prefix);
+
+/**
+ * Cria um cursor sobre todas as hashes do catálogo, pela ordem do catálogo. É o cursor
+ * de initPrefixCursor com o prefixo vazio.
+ * @return Cursor com uma coluna de códigos
+ */
+CURSOR initCatalogCursor(CATALOG cat);
+
 /**
  * Transforma o conteúdo de cada elemento, usando a função dumper dada. O resultado do
  * dumper é então adicionado, juntamente com a hash do elemento, ao set dado.
@@ -149,10 +315,11 @@ SET filterCat(CATALOG cat, SET set, condition_t condition, void* arg);
  * @param cat Catálogo com a informação a ser extraida
  * @param data Local onde a informação será guardada
  * @param dumper Função responsável por extrair o conteúdo dos elementos. O primeiro
- * argumento corresponde à estrutura de dados onde vai ser guardada a informação (data).
- * O segundo argumento corresponde à estrutura presente no conteúdo de cada elemento
+ * argumento corresponde à estrutura presente no conteúdo de cada elemento. O segundo
+ * argumento corresponde ao argumento adicional arg
+ * @param arg Argumento opcional para o dumper
  * @return Estrutura de dados com toda a informação
  */
-SET dumpCatalog(CATALOG cat, SET set, void* (*dumper)(void*));
+SET dumpCatalog(CATALOG cat, SET set, void* (*dumper)(void*, void*), void* arg);
 
 #endif
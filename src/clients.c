@@ -3,10 +3,16 @@
 
 #include "catalog.h"
 #include "clients.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_CATALOG
 
 #define CATALOG_SIZE 26
 
-#define INDEX(c) (c->str[0] - 'A')
+/* Número de clientes pretendido em cada índice do catálogo depois de carregado */
+#define SHARD_TARGET 1024
+
+#define VALID(str) ((str)[0] >= 'A' && (str)[0] <= 'Z')
 
 struct client{
 	char *str;
@@ -14,6 +20,12 @@ struct client{
 
 struct client_catalog {
 		CATALOG cat;
+		PERFECTHASH codes;   /* identificadores dos códigos, depois de balanceado */
+
+		/* Filtro dos códigos, construído ao balancear se filterRate for positiva */
+		BLOOM filter;
+		double filterRate;
+		long filterBytes;
 };
 
 struct client_set {
@@ -21,27 +33,54 @@ struct client_set {
 };
 
 CLIENTCAT initClientCat() {
-	CLIENTCAT clientCat = malloc(sizeof (*clientCat));
+	CLIENTCAT clientCat = MALLOC(sizeof (*clientCat));
 
 	clientCat->cat = initCatalog(CATALOG_SIZE, NULL, NULL);
+	clientCat->codes = NULL;
+	clientCat->filter = NULL;
+	clientCat->filterRate = 0;
+	clientCat->filterBytes = 0;
 
     return clientCat;
 }
 
 CLIENTCAT insertClient(CLIENTCAT clientCat, CLIENT client) {
-	clientCat->cat = insertCatalog(clientCat->cat, INDEX(client), client->str, NULL);
+	clientCat->cat = insertCatalog(clientCat->cat, client->str, NULL);
+
+	/* Os identificadores deixam de corresponder ao catálogo até ser balanceado */
+	freePerfectHash(clientCat->codes);
+	freeBloom(clientCat->filter);
+	clientCat->codes = NULL;
+	clientCat->filter = NULL;
 
 	return clientCat;
 }
 
 void freeClientCat(CLIENTCAT clientCat) {
 	freeCatalog(clientCat->cat);
-	free(clientCat);
+	freePerfectHash(clientCat->codes);
+	freeBloom(clientCat->filter);
+	FREE(clientCat);
 }
 
 bool lookUpClient(CLIENTCAT clientCat, CLIENT client) {
-	if (INDEX(client) < 0 || INDEX(client) > 26) return false;
-	return lookUpCatalog(clientCat->cat, INDEX(client), client->str);
+	return lookUpClientCode(clientCat, client->str);
+}
+
+bool lookUpClientCode(CLIENTCAT clientCat, char* code) {
+	return getClientCodeId(clientCat, code) >= 0;
+}
+
+int getClientCodeId(CLIENTCAT clientCat, char* code) {
+	if (!VALID(code)) return -1;
+
+	/* A maior parte dos códigos inexistentes é rejeitada com uma só linha de cache */
+	if (clientCat->filter && !lookUpBloom(clientCat->filter, code)) return -1;
+
+	if (clientCat->codes)
+		return getPerfectHashId(clientCat->codes, code);
+
+	return lookUpCatalog(clientCat->cat, code) ? rankCatalog(clientCat->cat, code) : -1;
 }
 
 bool isEmptyClientCat (CLIENTCAT clientCat) {
@@ -49,7 +88,34 @@ bool isEmptyClientCat (CLIENTCAT clientCat) {
 }
 
 int countClients(CLIENTCAT clientCat, char index) {
-	return countPosElems(clientCat->cat, index-'A');
+	char prefix[2];
+
+	prefix[0] = index;
+	prefix[1] = '\0';
+
+	return countPrefixElems(clientCat->cat, prefix);
+}
+
+CLIENTCAT balanceClientCat(CLIENTCAT clientCat) {
+	clientCat->cat = balanceCatalog(clientCat->cat, SHARD_TARGET);
+
+	freePerfectHash(clientCat->codes);
+	clientCat->codes = perfectHashCatalog(clientCat->cat);
+
+	return setClientCatFilter(clientCat, clientCat->filterRate, clientCat->filterBytes);
+}
+
+CLIENTCAT setClientCatFilter(CLIENTCAT clientCat, double fpRate, long budget) {
+	clientCat->filterRate = fpRate;
+	clientCat->filterBytes = budget;
+
+	freeBloom(clientCat->filter);
+	clientCat->filter = NULL;
+
+	if (fpRate > 0 && !isEmptyCatalog(clientCat->cat))
+		clientCat->filter = bloomCatalog(clientCat->cat, fpRate, budget);
+
+	return clientCat;
 }
 
 CATALOG getClientCat(CLIENTCAT clientCat) {
@@ -57,7 +123,7 @@ CATALOG getClientCat(CLIENTCAT clientCat) {
 }
 
 CLIENT newClient() {
-	CLIENT new = malloc(sizeof(struct client));
+	CLIENT new = MALLOC(sizeof(struct client));
 	new->str = NULL;
 
 	return new;
@@ -65,9 +131,9 @@ CLIENT newClient() {
 
 CLIENT changeClientCode(CLIENT c, char* str) {
 	if (c->str)
-		free(c->str);
+		FREE(c->str);
 
-	c->str = malloc(sizeof(char) * strlen(str) + 1);
+	c->str = MALLOC(sizeof(char) * strlen(str) + 1);
 	strcpy(c->str, str);
 
 	return c;
@@ -76,8 +142,8 @@ CLIENT changeClientCode(CLIENT c, char* str) {
 CLIENT toClient(char* str) {
 	CLIENT new;
 
-	new  = malloc(sizeof (*new));
-	new->str = malloc(sizeof(char) * strlen(str) + 1);
+	new  = MALLOC(sizeof (*new));
+	new->str = MALLOC(sizeof(char) * strlen(str) + 1);
 	
 	strcpy(new->str, str);
 
@@ -87,8 +153,8 @@ CLIENT toClient(char* str) {
 CLIENT cloneClient(CLIENT c) {
 	CLIENT new;
 
-	new = malloc(sizeof(*new));
-	new->str = malloc(sizeof(char) * strlen(c->str) + 1);
+	new = MALLOC(sizeof(*new));
+	new->str = MALLOC(sizeof(char) * strlen(c->str) + 1);
 
 	strcpy(new->str, c->str);
 
@@ -96,7 +162,7 @@ CLIENT cloneClient(CLIENT c) {
 }
 
 char* fromClient(CLIENT c) {
-	char *str = malloc(sizeof(char) * strlen(c->str) + 1);
+	char *str = MALLOC(sizeof(char) * strlen(c->str) + 1);
 	strcpy(str, c->str);
 
 	return str;
@@ -108,15 +174,19 @@ bool isEmptyClient(CLIENT c) {
 
 void freeClient(CLIENT client) {
 	if (client->str)
-		free(client->str);
+		FREE(client->str);
 
-	free(client);
+	FREE(client);
 }
  
 SET fillClientSet(CLIENTCAT catProd, char index) {
 	SET set = initSet(countAllElems(catProd->cat), NULL);
+	char prefix[2];
+
+	prefix[0] = index;
+	prefix[1] = '\0';
 
-	set = fillSet(catProd->cat, set, index - 'A');
+	set = fillPrefixSet(catProd->cat, set, prefix);
 
 	return set;
 }
@@ -19,6 +19,21 @@ CLIENTCAT initClientCat ();
  */
 CLIENTCAT insertClient (CLIENTCAT catalog, CLIENT client);
 
+/**
+ * Redistribui os clientes pelos índices do catálogo de acordo com os códigos já
+ * inseridos, para que nenhum índice fique demasiado grande (ver balanceCatalog).
+ */
+CLIENTCAT balanceClientCat (CLIENTCAT catalog);
+
+/**
+ * Configura o filtro de Bloom consultado por getClientCodeId antes do catálogo, que é
+ * construído sempre que o catálogo é balanceado. Se o catálogo não estiver vazio, o
+ * filtro é construído logo.
+ * @param fpRate Taxa de falsos positivos pretendida, ou 0 para não usar filtro
+ * @param budget Número máximo de bytes do filtro, ou 0 para não haver limite
+ */
+CLIENTCAT setClientCatFilter (CLIENTCAT catalog, double fpRate, long budget);
+
 /**
  * Liberta todo o espaço ocupado por um catálogo de clientes.
  */
@@ -29,6 +44,19 @@ void freeClientCat (CLIENTCAT catalog);
  */
 bool lookUpClient (CLIENTCAT catalog, CLIENT client);
 
+/**
+ * Verifica se o código dado é de um cliente do catálogo, sem o copiar.
+ */
+bool lookUpClientCode (CLIENTCAT catalog, char* code);
+
+/**
+ * Determina o identificador denso de um código do catálogo, isto é, a sua posição por
+ * ordem do catálogo. Depois de o catálogo ser balanceado, basta uma hash e uma
+ * comparação.
+ * @return O identificador, ou -1 se o código não existir no catálogo
+ */
+int getClientCodeId (CLIENTCAT catalog, char* code);
+
 /**
  * Verifica se o catálogo de clientes está ou não vazio
  * @return true caso seja vazio, false caso contrário
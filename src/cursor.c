@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cursor.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_QUERIES
+
+struct cursor {
+	void* source;
+	int size;
+	int pos;
+	char* types;
+	read_t read;
+	free_t free;
+};
+
+/* Fonte de um cursor sobre um resultado */
+struct result_source {
+	RESULT r;
+	int first;
+};
+
+static RESULT readResult(struct result_source* rs, RESULT page, int pos, int n);
+static void freeResultSource(struct result_source* rs);
+
+CURSOR initCursor(void* source, int size, char* types, read_t read, free_t free) {
+	CURSOR new = MALLOC(sizeof(*new));
+
+	new->source = source;
+	new->size = size;
+	new->pos = 0;
+	new->types = MALLOC(strlen(types) + 1);
+	new->read = read;
+	new->free = free;
+
+	strcpy(new->types, types);
+
+	return new;
+}
+
+CURSOR initResultCursor(RESULT r, int first, int rows) {
+	struct result_source *rs = MALLOC(sizeof(*rs));
+	CURSOR new;
+	char* types;
+	int i, cols = getResultCols(r);
+
+	rs->r = retainResult(r);
+	rs->first = first;
+
+	types = MALLOC(cols + 1);
+	for(i = 0; i < cols; i++)
+		types[i] = getResultColType(r, i);
+	types[cols] = '\0';
+
+	new = initCursor(rs, rows, types, (read_t) readResult, (free_t) freeResultSource);
+
+	FREE(types);
+	return new;
+}
+
+int getCursorSize(CURSOR c) {
+	return c->size;
+}
+
+int getCursorPos(CURSOR c) {
+	return c->pos;
+}
+
+CURSOR seekCursor(CURSOR c, int pos) {
+	if (pos > c->size) pos = c->size;
+	if (pos < 0) pos = 0;
+
+	c->pos = pos;
+	return c;
+}
+
+RESULT readCursor(CURSOR c, int n) {
+	RESULT page = initResult(c->types);
+
+	if (n > c->size - c->pos)
+		n = c->size - c->pos;
+
+	if (n > 0) {
+		page = c->read(c->source, page, c->pos, n);
+		c->pos += n;
+	}
+
+	return page;
+}
+
+void freeCursor(CURSOR c) {
+	if (c) {
+		if (c->free) c->free(c->source);
+		FREE(c->types);
+		FREE(c);
+	}
+}
+
+static RESULT readResult(struct result_source* rs, RESULT page, int pos, int n) {
+	int i;
+
+	for(i = 0; i < n; i++)
+		page = copyResultRow(page, rs->r, rs->first + pos + i);
+
+	return page;
+}
+
+static void freeResultSource(struct result_source* rs) {
+	freeResult(rs->r);
+	FREE(rs);
+}
@@ -0,0 +1,58 @@
+#ifndef __CURSOR__
+#define __CURSOR__
+
+#include "generic.h"
+#include "result.h"
+
+typedef struct cursor *CURSOR;
+
+/**
+ * Lê as linhas [pos, pos + n) de uma fonte, acrescentando-as ao resultado page.
+ * É garantido que pos + n não excede o tamanho da fonte.
+ */
+typedef RESULT (*read_t)(void* source, RESULT page, int pos, int n);
+
+/**
+ * Inicia um cursor sobre uma fonte de linhas, que é lida página a página sem nunca ser
+ * materializada por completo.
+ * @param source Fonte das linhas, que passa a pertencer ao cursor
+ * @param size Número de linhas da fonte
+ * @param types Tipos das colunas das linhas lidas (ver initResult)
+ * @param read Função que lê as linhas da fonte
+ * @param free Função que liberta a fonte, ou NULL
+ */
+CURSOR initCursor(void* source, int size, char* types, read_t read, free_t free);
+
+/**
+ * Inicia um cursor sobre as linhas [first, first + rows) de um resultado já calculado.
+ * O cursor regista-se como dono do resultado (ver retainResult).
+ */
+CURSOR initResultCursor(RESULT r, int first, int rows);
+
+/**
+ * Determina o número de linhas do cursor.
+ */
+int getCursorSize(CURSOR c);
+
+/**
+ * Determina a posição atual do cursor, isto é, a próxima linha a ser lida.
+ */
+int getCursorPos(CURSOR c);
+
+/**
+ * Coloca o cursor numa dada linha. Posições fora dos limites são ajustadas.
+ */
+CURSOR seekCursor(CURSOR c, int pos);
+
+/**
+ * Lê no máximo n linhas a partir da posição atual e avança o cursor.
+ * @return Resultado com as linhas lidas, que deve ser libertado com freeResult
+ */
+RESULT readCursor(CURSOR c, int n);
+
+/**
+ * Liberta o cursor e a sua fonte.
+ */
+void freeCursor(CURSOR c);
+
+#endif
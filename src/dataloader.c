@@ -1,18 +1,56 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
 
 #include "dataloader.h"
 #include "sales.h"
+#include "loadstats.h"
+#include "threadpool.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_OTHER
 
 #define CODE_BUFFER 32
-#define SALE_BUFFER 128
+
+/* Bytes de vendas lidos de cada vez, e tamanho aproximado dos pedaços desse bloco que
+ * são separados e validados por cada trabalhador */
+#define SALES_BLOCK (1 << 22)
+#define SALES_CHUNK (1 << 16)
+
+/* Venda de uma linha, com os identificadores encontrados na validação */
+struct parsed_sale {
+	struct sale sale;
+	int product;
+	int client;
+	int reason;   /* motivo por que é inválida, ou -1 */
+};
+
+/* Linhas inteiras do bloco, entre begin e end */
+struct sales_chunk {
+	char *begin, *end;
+	struct parsed_sale *sales;
+	int lines;
+};
+
+struct sales_load {
+	struct sales_chunk *chunks;
+	PRODUCTCAT products;
+	CLIENTCAT clients;
+	int branches;
+};
+
+static int splitChunks(char* block, long size, struct sales_chunk* chunks);
+static void parseChunks(struct sales_load* load, int begin, int end);
+static void validateChunks(struct sales_load* load, int begin, int end);
 
 int loadClients(FILE *file, CLIENTCAT cat) {
 
 	char buf[CODE_BUFFER], *clientCode;
 	CLIENT client;
 	int success;
+	long start = startPhase();
 
 	client = newClient();
 	success = 0;
@@ -26,6 +64,8 @@ int loadClients(FILE *file, CLIENTCAT cat) {
 	}
 
 	freeClient(client);
+	cat = balanceClientCat(cat);
+	endPhase(PHASE_CLIENTS, start);
 
 	return success;
 }
@@ -35,6 +75,7 @@ int loadProducts(FILE *file, PRODUCTCAT cat) {
 	char buf[CODE_BUFFER], *productCode;
 	PRODUCT product;
 	int success;
+	long start = startPhase();
 
 	product = newProduct();
 	success = 0;
@@ -48,41 +89,159 @@ int loadProducts(FILE *file, PRODUCTCAT cat) {
 	}
 
 	freeProduct(product);
+	cat = balanceProductCat(cat);
+	endPhase(PHASE_PRODUCTS, start);
 
 	return success;
 }
 
-int loadSales(FILE *file, FATGLOBAL fat, BRANCHSALES* bs, PRODUCTCAT products, 
+int loadSales(FILE *file, FATGLOBAL fat, SALESINDEX si, PRODUCTCAT products, 
               CLIENTCAT clients, int *failed) {
 
-	char buffer[SALE_BUFFER], *line;
-	PRODUCT prod;
-	CLIENT client;
-	SALE s;
-	int success, total;
+	struct sales_load load;
+	struct parsed_sale *ps;
+	char *block;
+	long size, used, kept;
+	int i, j, chunks, success, total;
+	THREADPOOL pool = getSalesIndexPool(si);
+	long t = startPhase();
 
-	prod = newProduct();
-	client = newClient();
-	success = total = 0;
+	load.branches = getSalesIndexBranches(si);
+	load.products = products;
+	load.clients = clients;
+	si  = fillSalesIndex(si, clients, products);
+	fat = fillFat(fat, products);
 
-	while(fgets(buffer, SALE_BUFFER, file)) {
-		s = initSale();
-		line = strtok (buffer, "\n\r");
-		s = readSale(s, prod, client, line);
-		total++;
-		
-		if (isSale(s, products, clients)) {
-			addSaleToFat(fat, s);	
-			addSaleToBranch(bs[getBranch(s)], s);
-		 	success++;
+	success = total = 0;
+	t = endPhase(PHASE_CLONES, t);
+
+	/* As linhas de cada bloco são separadas e validadas em paralelo, mas a faturação e o
+	 * índice só podem ser alterados por uma thread, pelo que as vendas válidas lhes são
+	 * acrescentadas a seguir, pela ordem do ficheiro */
+	block = MALLOC(SALES_BLOCK + 1);
+	load.chunks = MALLOC(sizeof(struct sales_chunk) * (SALES_BLOCK / SALES_CHUNK + 1));
+	kept = 0;
+
+	while ((size = kept + fread(block + kept, 1, SALES_BLOCK - kept, file)) > 0) {
+		/* A última linha, se estiver incompleta, passa para o bloco seguinte */
+		used = size;
+		if (size == SALES_BLOCK)
+			while (used > 0 && block[used - 1] != '\n') used--;
+		if (used == 0) used = size;
+
+		chunks = splitChunks(block, used, load.chunks);
+		parallelFor(pool, 0, chunks, 1, (range_t) parseChunks, &load);
+		t = endPhase(PHASE_PARSE, t);
+
+		parallelFor(pool, 0, chunks, 1, (range_t) validateChunks, &load);
+		t = endPhase(PHASE_VALIDATE, t);
+
+		for(i = 0; i < chunks; i++) {
+			for(j = 0; j < load.chunks[i].lines; j++) {
+				ps = &load.chunks[i].sales[j];
+				total++;
+				countLoadLine();
+
+				/* A venda aponta para o bloco: nada é copiado nem alocado por linha */
+				if (ps->reason == -1) {
+					addSaleToFat(fat, &ps->sale);
+					t = endPhase(PHASE_FAT, t);
+					addSaleToIndex(si, &ps->sale, ps->product, ps->client);
+					t = endPhase(PHASE_INDEX, t);
+					success++;
+				}
+				else countInvalidLine(ps->reason);
+			}
+
+			FREE(load.chunks[i].sales);
 		}
-		freeSale(s);
+
+		kept = size - used;
+		memmove(block, block + used, kept);
 	}
 
-	freeProduct(prod);
-	freeClient(client);
+	FREE(load.chunks);
+	FREE(block);
 
+	si = compactSalesIndex(si);
+	endPhase(PHASE_COMPACT, t);
 	*failed = total - success;
 
 	return success;
 }
+
+/**
+ * Divide as primeiras size posições do bloco em pedaços de cerca de SALES_CHUNK bytes,
+ * terminados no fim de uma linha.
+ * @return Número de pedaços escritos em chunks
+ */
+static int splitChunks(char* block, long size, struct sales_chunk* chunks) {
+	long begin, end;
+	int n = 0;
+
+	for(begin = 0; begin < size; begin = end, n++) {
+		end = (size - begin > SALES_CHUNK) ? begin + SALES_CHUNK : size;
+		while (end < size && block[end - 1] != '\n') end++;
+
+		chunks[n].begin = block + begin;
+		chunks[n].end = block + end;
+		chunks[n].sales = NULL;
+		chunks[n].lines = 0;
+	}
+
+	return n;
+}
+
+/**
+ * Separa os campos de cada linha dos pedaços dados. Tal como as linhas lidas com fgets,
+ * cada linha termina no primeiro \n ou \r; as linhas vazias são ignoradas.
+ */
+static void parseChunks(struct sales_load* load, int begin, int end) {
+	struct sales_chunk *chunk;
+	char *p, *next, *line, *save;
+	int i, lines;
+
+	for(i = begin; i < end; i++) {
+		chunk = &load->chunks[i];
+
+		for(p = chunk->begin, lines = 0; p < chunk->end; p++)
+			if (*p == '\n') lines++;
+
+		/* A última linha do ficheiro pode não terminar em \n */
+		chunk->sales = MALLOC(sizeof(struct parsed_sale) * (lines + 1));
+
+		for(p = chunk->begin; p < chunk->end; p = next + 1) {
+			next = memchr(p, '\n', chunk->end - p);
+			if (!next) next = chunk->end;
+			*next = '\0';
+
+			if ((line = strtok_r(p, "\r", &save)))
+				readSale(&chunk->sales[chunk->lines++].sale, line);
+		}
+	}
+}
+
+/**
+ * Verifica a filial, o produto e o cliente de cada venda dos pedaços dados, guardando
+ * os identificadores do produto e do cliente das vendas válidas.
+ */
+static void validateChunks(struct sales_load* load, int begin, int end) {
+	struct parsed_sale *ps;
+	SALE s;
+	int i, j;
+
+	for(i = begin; i < end; i++) {
+		for(j = 0; j < load->chunks[i].lines; j++) {
+			ps = &load->chunks[i].sales[j];
+			s = &ps->sale;
+
+			if (getBranch(s) < 0 || getBranch(s) >= load->branches)
+				ps->reason = INVALID_BRANCH;
+			else if ((ps->product = getProductCodeId(load->products, getProduct(s))) < 0)
+				ps->reason = INVALID_PRODUCT;
+			else if ((ps->client = getClientCodeId(load->clients, getClient(s))) < 0)
+				ps->reason = INVALID_CLIENT;
+			else ps->reason = -1;
+		}
+	}
+}
@@ -4,13 +4,18 @@
 #include <stdio.h>
 
 #include "generic.h"
-#include "branchsales.h"
+#include "salesindex.h"
 #include "fatglobal.h"
 #include "clients.h"
 #include "products.h"
 
+#define SALES_PATH "Vendas_1M.txt"
+#define CLIENTS_PATH "Clientes.txt"
+#define PRODUCTS_PATH "Produtos.txt"
+
 /**
- * Carrega o catálogo de produtos a partir do ficheiro dado.
+ * Carrega o catálogo de produtos a partir do ficheiro dado. No fim, o número de índices
+ * do catálogo é escolhido a partir dos produtos lidos.
  * @param file Ficheiro com os produtos a ser lidos
  * @param cat Catálogo a ser preenchido
  * @return Número de produtos corretamente lidos
@@ -18,7 +23,8 @@
 int loadProducts (FILE *file, PRODUCTCAT cat);
 
 /**
- * Carrega o catálogo de clientes a partir do ficheiro dado.
+ * Carrega o catálogo de clientes a partir do ficheiro dado. No fim, o número de índices
+ * do catálogo é escolhido a partir dos clientes lidos.
  * @param file Ficheiro com os clientes a ser lidos
  * @param cat Catálogo a ser preenchido
  * @return Número de clientes corretamente lidos
@@ -26,16 +32,22 @@ int loadProducts (FILE *file, PRODUCTCAT cat);
 int loadClients (FILE *file, CLIENTCAT cat);
 
 /**
- * Carrega a Faturação Global e as Filiais com as vendas lidas a partir do ficheiro
+ * Carrega a Faturação Global e o Índice de Vendas com as vendas lidas a partir do
+ * ficheiro. Vendas de filiais que o índice não conhece são consideradas inválidas.
+ * Os catálogos de produtos e de clientes já devem estar carregados; no fim da leitura
+ * o índice de vendas é compactado. As linhas são separadas e validadas em paralelo com
+ * o pool do índice de vendas (ver setSalesIndexPool), e as vendas válidas são depois
+ * acrescentadas pela ordem do ficheiro.
+ * Os tempos de cada fase e as vendas inválidas por motivo são acumulados em loadstats.h.
  * @param file Ficheiro com as vendas a ser lidas
  * @param fat Módulo de faturação a ser caregado
- * @param bs Módulo de filiais a ser carregado
+ * @param si Índice de vendas a ser carregado
  * @param products Catálogo com os produtos necessários para validar as vendas
  * @param clients Catálogo com os clientes necessários para validar as vendas
  * @param failed Número de vendas que não foram lidas corretamente
  * @return Número de vendas lidas corretamente
  */
-int loadSales (FILE *file, FATGLOBAL fat, BRANCHSALES *bs, PRODUCTCAT products, 
+int loadSales (FILE *file, FATGLOBAL fat, SALESINDEX si, PRODUCTCAT products, 
                CLIENTCAT clients, int *failed);
 
 #endif
@@ -0,0 +1,299 @@
+#include <stdlib.h>
+
+#include "engine.h"
+#include "set.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_QUERIES
+
+#define MONTHS 12
+#define MAX_COLS (MAX_BRANCHES + 2)
+
+static RESULT fillCodes(RESULT r, SET s);
+static bool addCode(char* code, void* content, RESULT* r);
+
+RESULT getProductsByPrefix(PRODUCTCAT pcat, char* prefix) {
+	RESULT r = initResult("c");
+
+	scanProductsByPrefix(pcat, prefix, (visit_t) addCode, &r);
+
+	return r;
+}
+
+RESULT getProductRevenue(FATGLOBAL fat, PRODUCTCAT pcat, PRODUCT p, int month) {
+	RESULT r;
+	PRODUCTFAT pfat;
+	double billedN, billedP;
+	int branch, salesN, salesP;
+
+	if (!lookUpProduct(pcat, p)) return NULL;
+
+	r = initResult("iiidd");
+	pfat = getProductDataByMonth(fat, p, month);
+
+	for(branch = 0; branch < getFatBranches(fat); branch++) {
+		getProductFatSales(pfat, branch, &salesN, &salesP);
+		getProductFatBilled(pfat, branch, &billedN, &billedP);
+
+		r = addResultRow(r);
+		r = setResultInt(r, 0, branch+1);
+		r = setResultInt(r, 1, salesN);
+		r = setResultInt(r, 2, salesP);
+		r = setResultDouble(r, 3, billedN);
+		r = setResultDouble(r, 4, billedP);
+	}
+
+	freeProductFat(pfat);
+	return r;
+}
+
+RESULT getUnsoldProducts(FATGLOBAL fat, int branch) {
+	RESULT r = initResult("c");
+	SET s;
+
+	s = (branch == -1) ? getProductsNotSold(fat) : getProductsNotSoldInBranch(fat, branch);
+	r = fillCodes(r, s);
+	freeSet(s);
+
+	return r;
+}
+
+RESULT getUnsoldProductsByBranch(FATGLOBAL fat) {
+	RESULT r = initResult("ic");
+	SET *sets;
+	char* code;
+	int i, branch;
+
+	sets = getProductsNotSoldByBranch(fat);
+
+	for(branch = 0; branch < getFatBranches(fat); branch++) {
+		for(i = 0; i < getSetSize(sets[branch]); i++) {
+			code = getSetHash(sets[branch], i);
+			r = addResultRow(r);
+			r = setResultInt(r, 0, branch+1);
+			r = setResultCode(r, 1, code);
+			FREE(code);
+		}
+
+		freeSet(sets[branch]);
+	}
+
+	FREE(sets);
+	return r;
+}
+
+RESULT getClientMonthlyQuant(SALESINDEX si, CLIENT c) {
+	RESULT r;
+	char types[MAX_COLS + 1];
+	int month, branch, branches, id, *quant;
+
+	if ((id = getClientId(si, c)) == -1) return NULL;
+
+	branches = getSalesIndexBranches(si);
+	quant = getClientQuantByMonth(si, id);
+
+	types[0] = COL_INT;
+	for(branch = 0; branch < branches; branch++)
+		types[branch+1] = COL_INT;
+	types[branches+1] = '\0';
+
+	r = initResult(types);
+
+	for(month = 0; month < MONTHS; month++) {
+		r = addResultRow(r);
+		r = setResultInt(r, 0, month+1);
+		for(branch = 0; branch < branches; branch++)
+			r = setResultInt(r, branch+1, quant[branch * MONTHS + month]);
+	}
+
+	return r;
+}
+
+RESULT getClientsAboveQuant(SALESINDEX si, int month, int quant) {
+	RESULT r = initResult("ci");
+	int i, branch, total, size, *clients, *row;
+
+	clients = MALLOC(sizeof(int) * (getSalesIndexClients(si) + 1));
+	size = getClientsByMonthQuant(si, month, quant, clients);
+
+	for(i = 0; i < size; i++) {
+		row = getClientQuantByMonth(si, clients[i]);
+		for(branch = 0, total = 0; branch < getSalesIndexBranches(si); branch++)
+			total += row[branch * MONTHS + month];
+
+		r = addResultRow(r);
+		r = setResultCode(r, 0, getClientCode(si, clients[i]));
+		r = setResultInt(r, 1, total);
+	}
+
+	FREE(clients);
+	return r;
+}
+
+RESULT getSalesInMonthRange(FATGLOBAL fat, int begin, int end) {
+	RESULT r = initResult("id");
+
+	r = addResultRow(r);
+	r = setResultInt(r, 0, getSalesByMonthRange(fat, begin, end));
+	r = setResultDouble(r, 1, getBilledByMonthRange(fat, begin, end));
+
+	return r;
+}
+
+RESULT getLoyalClients(SALESINDEX si) {
+	RESULT r = initResult("c");
+	SET s;
+
+	s = getClientsWhoBoughtInAll(si);
+	r = fillCodes(r, s);
+	freeSet(s);
+
+	return r;
+}
+
+RESULT getProductBuyers(SALESINDEX si, PRODUCTCAT pcat, PRODUCT p, int branch) {
+	RESULT r;
+	int i, normal, promo, size, *clients;
+
+	if (!lookUpProduct(pcat, p)) return NULL;
+
+	r = initResult("cc");
+
+	countClientsByProduct(si, p, branch, &normal, &promo);
+	clients = MALLOC(sizeof(int) * (((normal > promo) ? normal : promo) + 1));
+
+	size = getClientsByProduct(si, p, branch, MODE_N, clients);
+	for(i = 0; i < size; i++) {
+		r = addResultRow(r);
+		r = setResultCode(r, 0, getClientCode(si, clients[i]));
+		r = setResultCode(r, 1, "N");
+	}
+
+	size = getClientsByProduct(si, p, branch, MODE_P, clients);
+	for(i = 0; i < size; i++) {
+		r = addResultRow(r);
+		r = setResultCode(r, 0, getClientCode(si, clients[i]));
+		r = setResultCode(r, 1, "P");
+	}
+
+	FREE(clients);
+	return r;
+}
+
+RESULT getClientFavourites(SALESINDEX si, CLIENT c, int month) {
+	RESULT r;
+	int i, id, size, *products, *quant;
+
+	if ((id = getClientId(si, c)) == -1) return NULL;
+
+	r = initResult("ci");
+
+	size = countProductsByClient(si, id);
+	products = MALLOC(sizeof(int) * (size + 1));
+	quant = MALLOC(sizeof(int) * (size + 1));
+
+	size = getProductsByClientQuant(si, id, month, products, quant);
+	for(i = 0; i < size; i++) {
+		r = addResultRow(r);
+		r = setResultCode(r, 0, getProductCode(si, products[i]));
+		r = setResultInt(r, 1, quant[i]);
+	}
+
+	FREE(products);
+	FREE(quant);
+	return r;
+}
+
+RESULT getTopProducts(SALESINDEX si, int n) {
+	RESULT r = initResult("iicii");
+	SET s;
+	PRODUCTDATA pd;
+	char* product;
+	int i, branch;
+
+	for(branch = 0; branch < getSalesIndexBranches(si); branch++) {
+		s = listProductsByQuant(si, branch, n);
+
+		for(i = 0; i < getSetSize(s); i++) {
+			product = getSetHash(s, i);
+			pd = getSetData(s, i);
+
+			r = addResultRow(r);
+			r = setResultInt(r, 0, branch+1);
+			r = setResultInt(r, 1, i+1);
+			r = setResultCode(r, 2, product);
+			r = setResultInt(r, 3, getClientsFromData(pd));
+			r = setResultInt(r, 4, getQuantFromData(pd));
+			FREE(product);
+		}
+
+		freeSet(s);
+	}
+
+	return r;
+}
+
+RESULT getClientTopSpending(SALESINDEX si, CLIENT c, int n) {
+	RESULT r;
+	double* billed;
+	int i, id, size, *products;
+
+	if ((id = getClientId(si, c)) == -1) return NULL;
+
+	r = initResult("cd");
+
+	size = countProductsByClient(si, id);
+	products = MALLOC(sizeof(int) * (size + 1));
+	billed = MALLOC(sizeof(double) * (size + 1));
+
+	size = getProductsByClientBilled(si, id, products, billed);
+	for(i = 0; i < n && i < size; i++) {
+		r = addResultRow(r);
+		r = setResultCode(r, 0, getProductCode(si, products[i]));
+		r = setResultDouble(r, 1, billed[i]);
+	}
+
+	FREE(products);
+	FREE(billed);
+	return r;
+}
+
+RESULT getInactiveCounts(SALESINDEX si, FATGLOBAL fat) {
+	RESULT r = initResult("ii");
+	SET clients, products;
+
+	clients  = getClientsWhoNeverBought(si);
+	products = getProductsNotSold(fat);
+
+	r = addResultRow(r);
+	r = setResultInt(r, 0, getSetSize(clients));
+	r = setResultInt(r, 1, getSetSize(products));
+
+	freeSet(clients);
+	freeSet(products);
+
+	return r;
+}
+
+static bool addCode(char* code, void* content, RESULT* r) {
+	(void) content;
+
+	*r = addResultRow(*r);
+	*r = setResultCode(*r, 0, code);
+
+	return true;
+}
+
+static RESULT fillCodes(RESULT r, SET s) {
+	char* code;
+	int i;
+
+	for(i = 0; i < getSetSize(s); i++) {
+		code = getSetHash(s, i);
+		r = addResultRow(r);
+		r = setResultCode(r, 0, code);
+		FREE(code);
+	}
+
+	return r;
+}
@@ -0,0 +1,99 @@
+#ifndef __ENGINE__
+#define __ENGINE__
+
+#include "result.h"
+#include "salesindex.h"
+#include "fatglobal.h"
+#include "products.h"
+#include "clients.h"
+
+/*
+ * Cálculo das queries, independente da forma como os resultados são apresentados.
+ * Os meses e as filiais dos parâmetros começam em 0; nos resultados começam em 1.
+ * As funções que recebem um cliente ou um produto devolvem NULL se este não existir.
+ */
+
+/**
+ * Query 2: produtos começados por um prefixo (por exemplo, uma letra). O prefixo tem de
+ * começar por uma letra maiúscula.
+ * Colunas: código.
+ */
+RESULT getProductsByPrefix(PRODUCTCAT pcat, char* prefix);
+
+/**
+ * Query 3: vendas e faturação de um produto num mês, por filial.
+ * Colunas: filial, vendas N, vendas P, faturado N, faturado P.
+ */
+RESULT getProductRevenue(FATGLOBAL fat, PRODUCTCAT pcat, PRODUCT p, int month);
+
+/**
+ * Query 4: produtos que nunca foram comprados numa filial, ou em nenhuma filial se
+ * branch for -1.
+ * Colunas: código.
+ */
+RESULT getUnsoldProducts(FATGLOBAL fat, int branch);
+
+/**
+ * Query 4: produtos que nunca foram comprados em cada uma das filiais, ordenados por
+ * filial.
+ * Colunas: filial, código.
+ */
+RESULT getUnsoldProductsByBranch(FATGLOBAL fat);
+
+/**
+ * Query 5: quantidade comprada por um cliente em cada mês.
+ * Colunas: mês, seguido da quantidade em cada filial.
+ */
+RESULT getClientMonthlyQuant(SALESINDEX si, CLIENT c);
+
+/**
+ * Clientes que, somando todas as filiais, compraram num mês mais do que quant produtos,
+ * por ordem do código. Percorre a quantidade desse mês de todos os clientes de uma vez.
+ * Colunas: código, quantidade.
+ */
+RESULT getClientsAboveQuant(SALESINDEX si, int month, int quant);
+
+/**
+ * Query 6: vendas e faturação total num intervalo de meses.
+ * Colunas: vendas, faturado.
+ */
+RESULT getSalesInMonthRange(FATGLOBAL fat, int begin, int end);
+
+/**
+ * Query 7: clientes que compraram em todas as filiais.
+ * Colunas: código.
+ */
+RESULT getLoyalClients(SALESINDEX si);
+
+/**
+ * Query 8: clientes que compraram um produto numa filial. Os clientes que compraram em
+ * modo normal aparecem primeiro; um cliente que comprou nos dois modos aparece duas vezes.
+ * Colunas: código, modo ("N" ou "P").
+ */
+RESULT getProductBuyers(SALESINDEX si, PRODUCTCAT pcat, PRODUCT p, int branch);
+
+/**
+ * Query 9: produtos comprados por um cliente num mês, por ordem decrescente de quantidade.
+ * Colunas: código, quantidade.
+ */
+RESULT getClientFavourites(SALESINDEX si, CLIENT c, int month);
+
+/**
+ * Query 10: os n produtos mais vendidos de cada filial.
+ * Colunas: filial, posição, código, clientes, quantidade.
+ */
+RESULT getTopProducts(SALESINDEX si, int n);
+
+/**
+ * Query 11: os n produtos em que um cliente mais gastou.
+ * Colunas: código, gastos.
+ */
+RESULT getClientTopSpending(SALESINDEX si, CLIENT c, int n);
+
+/**
+ * Query 12: número de clientes sem compras e de produtos nunca vendidos.
+ * Colunas: clientes, produtos.
+ */
+RESULT getInactiveCounts(SALESINDEX si, FATGLOBAL fat);
+
+#endif
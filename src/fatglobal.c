@@ -3,8 +3,10 @@
 
 #include "catalog.h"
 #include "fatglobal.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_FATGLOBAL
 
-#define INDEX(p) (p[0] - 'A')
 #define BRANCHES(p) p->branches
 
 /* Dados de cada produto */
@@ -23,6 +25,39 @@ struct product_fat {
 struct faturacao {
 	CATALOG cat;
 	int branches;
+	THREADPOOL pool;
+};
+
+/* Número de produtos somados por cada pedaço do parallelFor nas somas por meses */
+#define RANGE_GRAIN 4096
+
+/* Códigos e receitas dos produtos pela ordem do catálogo, sem cópias: pertencem ao
+ * catálogo, pelo que só são válidos enquanto este não for alterado */
+struct revenues {
+	char **codes;
+	REVENUE *revs;
+	int size;
+	bool sold;   /* só os produtos com vendas */
+};
+
+/* Produtos não vendidos em cada filial, calculados em paralelo por filial */
+struct branch_unsold {
+	struct revenues *products;
+	SET *res;
+};
+
+/* Venda a acrescentar à receita de um produto, com updateCatContent */
+struct fat_sale {
+	SALE sale;
+	int branches;
+};
+
+/* Somas parciais de um intervalo de meses, uma por pedaço do set de produtos */
+struct month_range {
+	struct revenues *products;
+	int first, last;
+	int *sales;
+	double *billed;
 };
 
 static PRODUCTFAT newProductFat(int branches);
@@ -32,6 +67,7 @@ static void addProductFatSales(PRODUCTFAT pf, int branch, int normal, int promo)
 /* Set de funções que auxiliam a gestão do módulo */
 static REVENUE initRevenue  (int branches);
 static REVENUE addSaleToRev (REVENUE r, SALE s);
+static REVENUE updateRevenue(REVENUE r, struct fat_sale* fs);
 static REVENUE cloneRevenue (REVENUE r);
 static void    freeRevenue  (REVENUE r);
 
@@ -46,16 +82,33 @@ static int getSalesRev    (REVENUE r, int branch, int month, int* normal, int* p
 static int getBranchSales (REVENUE r, int branch, int *normal, int *promo);
 static int getMonthSales  (REVENUE r, int month,  int *normal, int *promo);
 
+static struct revenues listRevenues(FATGLOBAL fat, bool sold);
+static bool addToRevenues(char* code, REVENUE rev, struct revenues* rs);
+static void freeRevenues(struct revenues* rs);
+static void findUnsoldInBranches(struct branch_unsold* bu, int begin, int end);
+static SET findUnsold(struct revenues* rs, int branch);
+static void sumMonthRange(struct month_range* mr, int begin, int end);
+
 
 FATGLOBAL initFat(int branches){
-	FATGLOBAL new = malloc(sizeof(*new));
+	FATGLOBAL new = MALLOC(sizeof(*new));
 
 	new->cat = NULL;
 	new->branches = branches;
+	new->pool = NULL;
 
 	return new;
 }
 
+FATGLOBAL setFatPool (FATGLOBAL fat, THREADPOOL pool) {
+	fat->pool = pool;
+	return fat;
+}
+
+int getFatBranches (FATGLOBAL fat) {
+	return BRANCHES(fat);
+}
+
 FATGLOBAL fillFat (FATGLOBAL fat, PRODUCTCAT p) {
 	fat->cat = getProductCat(p);
 	fat->cat = changeCatalogOps(fat->cat, (clone_t) cloneRevenue, (free_t) freeRevenue);
@@ -68,7 +121,7 @@ FATGLOBAL addFat(FATGLOBAL fat, SALE s) {
 	MEMBER member = newMember();
 	char *prod = getProduct(s);
 
-	rev = getCatContent(fat->cat, INDEX(prod), prod, member);
+	rev = getCatContent(fat->cat, prod, member);
 
 	if (!rev)
 		rev = initRevenue(BRANCHES(fat));
@@ -77,26 +130,19 @@ FATGLOBAL addFat(FATGLOBAL fat, SALE s) {
 	updateMember(member, rev);	
 
 	freeMember(member);
-	free(prod);
 
 	return fat;
 }
 
 FATGLOBAL addSaleToFat(FATGLOBAL fat, SALE s) {
-	REVENUE rev;
-	MEMBER member = newMember();
+	struct fat_sale fs;
 	char *product = getProduct(s);
 
-	rev = getCatContent(fat->cat, INDEX(product), product, member);
+	fs.sale = s;
+	fs.branches = BRANCHES(fat);
 
-	if (!rev)
-		rev = initRevenue(BRANCHES(fat));
-
-	addSaleToRev(rev, s);
-	updateMember(member, rev);
-
-	freeMember(member);
-	free(product);
+	/* A receita é alterada com o índice do produto bloqueado, se o catálogo o pedir */
+	updateCatContent(fat->cat, product, (update_t) updateRevenue, &fs);
 	
 	return fat;
 }
@@ -108,10 +154,10 @@ PRODUCTFAT getProductDataByMonth(FATGLOBAL fat, PRODUCT p, int month) {
 	double billedN = 0, billedP = 0;
 	int branch, salesN = 0, salesP = 0;
 
-	rev = getCatContent(fat->cat, INDEX(product), product, NULL);
+	rev = getCatContent(fat->cat, product, NULL);
 
 	if (!rev){
-		free(product);
+		FREE(product);
 		return pf;
 	}
 
@@ -123,90 +169,158 @@ PRODUCTFAT getProductDataByMonth(FATGLOBAL fat, PRODUCT p, int month) {
 		addProductFatBilled(pf, branch, billedN, billedP);
 	}
 	
-	free(product);
+	FREE(product);
 	return pf;
 }
 
 double getBilledByMonthRange(FATGLOBAL fat, int initialMonth, int finalMonth) {
-	SET set;
-	REVENUE rev;
-	int i, month, size;
+	struct month_range mr;
+	struct revenues rs = listRevenues(fat, true);
+	int i, chunks = rs.size / RANGE_GRAIN + 1;
 	double res = 0;
 
-	set = initSet(countAllElems(fat->cat), (free_t) freeRevenue);
-
-	set = filterCat(fat->cat, set, (condition_t) isNotEmptyRev, NULL);
-	size = getSetSize(set);
+	mr.products = &rs;
+	mr.first = initialMonth;
+	mr.last = finalMonth;
+	mr.sales = NULL;
+	mr.billed = CALLOC(chunks, sizeof(double));
 
-	for(i = 0; i < size; i++){
-		rev = getSetData(set, i);
+	/* As somas parciais são juntadas por ordem, pelo que não dependem das threads */
+	parallelFor(fat->pool, 0, rs.size, RANGE_GRAIN, (range_t) sumMonthRange, &mr);
+	for(i = 0; i < chunks; i++)
+		res += mr.billed[i];
 
-		for(month = initialMonth; month <= finalMonth; month++)
-			res += getMonthBilled(rev, month, NULL, NULL);
-	}
-
-	freeSet(set);
+	FREE(mr.billed);
+	freeRevenues(&rs);
 	return res;
 }
 
 int getSalesByMonthRange(FATGLOBAL fat, int initialMonth, int finalMonth) {
-	SET set;
-	REVENUE rev;
-	int i, month, size, res = 0;
+	struct month_range mr;
+	struct revenues rs = listRevenues(fat, true);
+	int i, chunks = rs.size / RANGE_GRAIN + 1, res = 0;
+
+	mr.products = &rs;
+	mr.first = initialMonth;
+	mr.last = finalMonth;
+	mr.sales = CALLOC(chunks, sizeof(int));
+	mr.billed = NULL;
+
+	parallelFor(fat->pool, 0, rs.size, RANGE_GRAIN, (range_t) sumMonthRange, &mr);
+	for(i = 0; i < chunks; i++)
+		res += mr.sales[i];
 	
-	set = initSet(countAllElems(fat->cat), (free_t) freeRevenue);
-
-	set = filterCat(fat->cat, set, (condition_t) isNotEmptyRev, NULL);
-	size = getSetSize(set);
-
-	for(i = 0; i < size; i++){
-		rev = getSetData(set, i);
-
-		for(month = initialMonth; month <= finalMonth; month++)
-			res += getMonthSales(rev, month, NULL, NULL);
-	}
-	
-	freeSet(set);
+	FREE(mr.sales);
+	freeRevenues(&rs);
 	return res;
 }
 
 SET getProductsNotSold(FATGLOBAL fat) {
 	SET set = initSet(countAllElems(fat->cat), (free_t) freeRevenue);
 
-	set = filterCat(fat->cat, set, (condition_t) isEmptyRev, NULL);
+	set = filterCatParallel(fat->cat, set, (condition_t) isEmptyRev, NULL, fat->pool);
 
 	return set;
 }
 
 SET* getProductsNotSoldByBranch(FATGLOBAL fat) {
-	SET *res, set;
-	REVENUE rev;
-	int i, branch, size;
+	struct branch_unsold bu;
+	struct revenues rs = listRevenues(fat, false);
+	SET *res = MALLOC(sizeof(SET) * BRANCHES(fat));
+
+	/* As filiais são independentes, pelo que cada uma é calculada em paralelo */
+	bu.products = &rs;
+	bu.res = res;
+	parallelFor(fat->pool, 0, BRANCHES(fat), 1, (range_t) findUnsoldInBranches, &bu);
+
+	freeRevenues(&rs);
+	return res;
+}
+
+SET getProductsNotSoldInBranch(FATGLOBAL fat, int branch) {
+	struct revenues rs = listRevenues(fat, false);
+	SET set = findUnsold(&rs, branch);
+
+	freeRevenues(&rs);
+	return set;
+}
+
+/**
+ * Lista os códigos e as receitas dos produtos, pela ordem do catálogo, percorrendo-o
+ * uma só vez e sem copiar nenhuma receita.
+ * @param sold Se for true, só são listados os produtos com vendas
+ */
+static struct revenues listRevenues(FATGLOBAL fat, bool sold) {
+	struct revenues rs;
+	int size = countAllElems(fat->cat) + 1;
 
-	res = malloc(sizeof(SET) * BRANCHES(fat));
+	rs.codes = MALLOC(sizeof(char*) * size);
+	rs.revs = MALLOC(sizeof(REVENUE) * size);
+	rs.size = 0;
+	rs.sold = sold;
 
-	set = initSet(countAllElems(fat->cat), (free_t) freeRevenue);
-	set = fillAllSet(fat->cat, set);
-	size = getSetSize(set);
+	rangeScanCatalog(fat->cat, NULL, NULL, (visit_t) addToRevenues, &rs);
 
-	for(branch = 0; branch < BRANCHES(fat); branch++)
-		res[branch] = initSet(size, (free_t) freeRevenue);
+	return rs;
+}
+
+static bool addToRevenues(char* code, REVENUE rev, struct revenues* rs) {
+	if (!rs->sold || isNotEmptyRev(rev)) {
+		rs->codes[rs->size] = code;
+		rs->revs[rs->size++] = rev;
+	}
+
+	return true;
+}
+
+static void freeRevenues(struct revenues* rs) {
+	FREE(rs->codes);
+	FREE(rs->revs);
+}
 
-	for(i = 0; i < size; i++) {
-		for(branch = 0; branch < BRANCHES(fat); branch++){
-			rev = getSetData(set, i);
-			if (!getBranchSales(rev, branch, NULL, NULL))
-				datacpy(res[branch], set, i);
+static void findUnsoldInBranches(struct branch_unsold* bu, int begin, int end) {
+	int branch;
+
+	for(branch = begin; branch < end; branch++)
+		bu->res[branch] = findUnsold(bu->products, branch);
+}
+
+/**
+ * Determina os produtos da lista que nunca foram vendidos na filial dada.
+ */
+static SET findUnsold(struct revenues* rs, int branch) {
+	SET set = initSet(rs->size + 1, NULL);
+	int i;
+
+	for(i = 0; i < rs->size; i++)
+		if (!getBranchSales(rs->revs[i], branch, NULL, NULL))
+			set = insertElement(set, rs->codes[i], NULL);
+
+	return set;
+}
+
+static void sumMonthRange(struct month_range* mr, int begin, int end) {
+	REVENUE rev;
+	int i, month, sales = 0;
+	double billed = 0;
+
+	for(i = begin; i < end; i++) {
+		rev = mr->products->revs[i];
+
+		for(month = mr->first; month <= mr->last; month++) {
+			if (mr->billed) billed += getMonthBilled(rev, month, NULL, NULL);
+			else sales += getMonthSales(rev, month, NULL, NULL);
 		}
 	}
 
-	return res;
+	if (mr->billed) mr->billed[begin / RANGE_GRAIN] = billed;
+	else mr->sales[begin / RANGE_GRAIN] = sales;
 }
 
 void freeFat(FATGLOBAL fat) {
 	if (fat){
 		freeCatalog(fat->cat);
-		free(fat);
+		FREE(fat);
 	}
 }
 
@@ -214,11 +328,11 @@ void freeFat(FATGLOBAL fat) {
 
 static REVENUE initRevenue(int branches) {
 	REVENUE new;
-   	new = malloc(sizeof(*new));
+   	new = MALLOC(sizeof(*new));
 
 	new->branches = branches;
-	new->billed   = calloc(MONTHS*branches*SALEMODE, sizeof(double));
-	new->sales    = calloc(MONTHS*branches*SALEMODE, sizeof(int));
+	new->billed   = CALLOC(MONTHS*branches*SALEMODE, sizeof(double));
+	new->sales    = CALLOC(MONTHS*branches*SALEMODE, sizeof(int));
 
 	return new;
 }
@@ -236,11 +350,22 @@ static REVENUE addSaleToRev(REVENUE r, SALE s) {
 	return r;
 }
 
+/**
+ * Acrescenta uma venda à receita de um produto, criando-a se o produto ainda não tiver
+ * vendas.
+ */
+static REVENUE updateRevenue(REVENUE r, struct fat_sale* fs) {
+	if (!r)
+		r = initRevenue(fs->branches);
+
+	return addSaleToRev(r, fs->sale);
+}
+
 static REVENUE cloneRevenue(REVENUE r) {
-	REVENUE new = malloc(sizeof(*new));
+	REVENUE new = MALLOC(sizeof(*new));
 
-	new->sales = malloc(MONTHS*BRANCHES(r)*SALEMODE*sizeof(int));
-	new->billed = malloc(MONTHS*BRANCHES(r)*SALEMODE*sizeof(double));
+	new->sales = MALLOC(MONTHS*BRANCHES(r)*SALEMODE*sizeof(int));
+	new->billed = MALLOC(MONTHS*BRANCHES(r)*SALEMODE*sizeof(double));
 
 	memcpy(new->sales, r->sales, MONTHS*BRANCHES(r)*SALEMODE*sizeof(int));
 	memcpy(new->billed, r->billed, MONTHS*BRANCHES(r)*SALEMODE*sizeof(double));
@@ -341,17 +466,17 @@ static int getBranchSales(REVENUE r, int branch, int *normal, int *promo) {
 
 static void freeRevenue(REVENUE r) {
 	if (r) {
-		free(r->sales);
-		free(r->billed);
-		free(r);	
+		FREE(r->sales);
+		FREE(r->billed);
+		FREE(r);	
 	}
 }
 
 static PRODUCTFAT newProductFat(int branch) {
-	PRODUCTFAT new = malloc(sizeof(*new));
+	PRODUCTFAT new = MALLOC(sizeof(*new));
 	
-	new->sales = calloc(SALEMODE*branch, sizeof(int));
-	new->billed = calloc(SALEMODE*branch, sizeof(double));
+	new->sales = CALLOC(SALEMODE*branch, sizeof(int));
+	new->billed = CALLOC(SALEMODE*branch, sizeof(double));
 
 	return new;
 }
@@ -392,8 +517,8 @@ static void addProductFatSales(PRODUCTFAT pf, int branch, int normal, int promo)
 
 void freeProductFat(PRODUCTFAT pf) {
 	if (pf) {
-		free(pf->sales);
-		free(pf->billed);
-		free(pf);
+		FREE(pf->sales);
+		FREE(pf->billed);
+		FREE(pf);
 	}
 }
@@ -5,6 +5,7 @@
 #include "sales.h"
 #include "products.h"
 #include "set.h"
+#include "threadpool.h"
 
 typedef struct faturacao *FATGLOBAL;
 typedef struct product_fat *PRODUCTFAT;
@@ -17,6 +18,18 @@ typedef struct product_fat *PRODUCTFAT;
  */
 FATGLOBAL initFat (int branches);
 
+/**
+ * Devolve o número de filiais com que a faturação global foi iniciada.
+ */
+int getFatBranches (FATGLOBAL fat);
+
+/**
+ * Indica os trabalhadores a usar nas consultas que percorrem todos os produtos. O pool
+ * não passa a pertencer à faturação, pelo que tem de ser libertado por quem o criou.
+ * Sem pool (NULL, o valor inicial) as consultas são feitas sequencialmente.
+ */
+FATGLOBAL setFatPool (FATGLOBAL fat, THREADPOOL pool);
+
 /**
  * Adiciona à faturação global todos os produtos existentes no catálogo de produtos dado.
  */
@@ -73,6 +86,12 @@ SET getProductsNotSold(FATGLOBAL fat);
  */
 SET* getProductsNotSoldByBranch(FATGLOBAL);
 
+/**
+ * Calcula os produtos que nunca foram vendidos numa filial, percorrendo só essa filial.
+ * @return Set com os produtos, pela ordem do catálogo
+ */
+SET getProductsNotSoldInBranch(FATGLOBAL fat, int branch);
+
 /**
  *	Liberta toda a memória associada à faturação global.
  */
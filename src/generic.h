@@ -8,6 +8,8 @@ typedef void* (*clone_t)     (void*);
 typedef bool  (*condition_t) (void*, void*);
 typedef int   (*compare_t)   (void*, void*, void*);
 typedef void  (*free_t)      (void*);
+typedef bool  (*visit_t)     (char*, void*, void*);
+typedef void* (*update_t)    (void*, void*);
 
 #define true 1
 #define false 0
@@ -3,6 +3,9 @@
 
 #include "hashT.h"
 #include "set.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_HASHT
 
 #define KEY_SIZE 10
 #define BASE_CAPACITY 512
@@ -34,13 +37,17 @@ struct hasht {
 	free_t free;
 };
 
+/* Redimensionamentos feitos por todas as tabelas desde o início do programa */
+static long resizes = 0;
+
 static int Hash(char *key);
 static HASHT resizeHashT(HASHT ht);
+static HASHT placeEntry(HASHT ht, char* key, void* content);
 
 HASHT initHashT(int size, init_t init, add_t add, clone_t clone, free_t free) {
-	HASHT new = malloc(sizeof(*new));
+	HASHT new = MALLOC(sizeof(*new));
 
-	new->table    = calloc(size, sizeof(HASHTCNTT));
+	new->table    = CALLOC(size, sizeof(HASHTCNTT));
 	new->capacity = size;
 	new->size 	  = 0;
 	new->maxSize  = new->capacity * 0.8;
@@ -101,8 +108,8 @@ void freeHashT(HASHT ht) {
 				ht->free(CONTENT(i));
 	}
 
-	free(ht->table);
-	free(ht);
+	FREE(ht->table);
+	FREE(ht);
 }
 
 void* getHashTcontent(HASHT ht, char* key) {
@@ -130,10 +137,20 @@ int getHashTsize(HASHT ht){
 	return ht->size;
 }
 
+long getHashTResizes() {
+	return __sync_add_and_fetch(&resizes, 0);
+}
+
+void countHashTResize() {
+	__sync_add_and_fetch(&resizes, 1);
+}
+
 static HASHT resizeHashT(HASHT ht){
-	HASHT new = malloc(sizeof(*new));
+	HASHT new = MALLOC(sizeof(*new));
 	int i;
 
+	countHashTResize();
+
 	new->capacity = ht->capacity *2;
 	new->size 	  = ht->size;
 	new->maxSize  = new->capacity * 0.8;
@@ -142,12 +159,32 @@ static HASHT resizeHashT(HASHT ht){
 	new->add 	  = ht->add;
 	new->clone    = ht->clone;
 	
-	new->table    = calloc(new->capacity, sizeof(HASHTCNTT));
+	new->table    = CALLOC(new->capacity, sizeof(HASHTCNTT));
 
+	/* Os conteúdos passam para a nova tabela tal como estão, sem init nem add */
 	for(i=0; i < ht->capacity; i++)
 		if (STATUS(i) == BUSY) 
-			insertHashT(new, KEY(i), CONTENT(i));
+			new = placeEntry(new, KEY(i), CONTENT(i));
 
-	freeHashT(ht);
+	FREE(ht->table);
+	FREE(ht);
 	return new;
 }
+
+/**
+ * Coloca uma entrada, cuja chave ainda não existe na tabela, na primeira posição livre.
+ */
+static HASHT placeEntry(HASHT ht, char* key, void* content) {
+	int i, hash, p;
+
+	p = hash = Hash(key) & (CAPACITY - 1);
+
+	for (i=0; i < CAPACITY && STATUS(p) == BUSY; i++)
+		p = (hash + (i*i)) & (CAPACITY - 1);
+
+	STATUS(p) = BUSY;
+	strncpy(KEY(p), key, KEY_SIZE);
+	CONTENT(p) = content;
+
+	return ht;
+}
@@ -1,8 +1,11 @@
 #ifndef __HASHT__
 #define __HASHT__
 
+#include <string.h>
+
 #include "generic.h"
 #include "set.h"
+#include "memstat.h"
 
 typedef struct hasht *HASHT;
 
@@ -18,6 +21,12 @@ HASHT initHashT(int size, init_t init, add_t add, clone_t clone, free_t free);
  */
 int getHashTsize(HASHT ht);
 
+/**
+ * Devolve o número de vezes que uma tabela teve de crescer, somado por todas as tabelas
+ * desde o início do programa.
+ */
+long getHashTResizes();
+
 /**
  * Insere um dado conteúdo com uma certa chave na Tabela de Hash.
  * Caso a chave já existe, adidiciona o conteúdo novo ao conteúdo existente.
@@ -49,4 +58,113 @@ SET dumpHashT(HASHT ht, SET set);
  */
 void freeHashT(HASHT ht);
 
+/**
+ * Conta um redimensionamento em getHashTResizes. Usada pelas tabelas geradas com
+ * HASHT_OF.
+ */
+void countHashTResize();
+
+/* Número de conteúdos que cabem numa tabela gerada com HASHT_OF com a capacidade dada */
+#define HASHT_OF_LOAD(capacity) ((capacity) / 4 * 3)
+
+/**
+ * Gera uma tabela de hash especializada para chaves do tipo KEY e conteúdos do tipo
+ * VALUE. Ao contrário de HASHT, a função de hash e a comparação de chaves são expandidas
+ * no local, e os conteúdos ficam num array da própria tabela, pela ordem de inserção,
+ * em vez de cada um ser alocado, iniciado e atualizado através de init_t e add_t.
+ * As chaves são copiadas por atribuição. Gera o tipo struct NAME e as funções:
+ *
+ *     struct NAME* initNAME(int size)        size é uma potência de 2, pelo menos 4
+ *     VALUE* insertNAME(struct NAME* t, KEY key)
+ *     int getNAMESize(struct NAME* t)
+ *     VALUE* dumpNAME(struct NAME* t, VALUE* dest)
+ *     void freeNAME(struct NAME* t)
+ *
+ * insertNAME devolve o conteúdo da chave, a zeros se a chave for nova, que pode ser
+ * alterado até à inserção seguinte. dumpNAME copia os conteúdos para dest, pela ordem
+ * de inserção. A memória é atribuída a MEM_HASHT.
+ * @param HASH Macro ou função que calcula um unsigned a partir de uma chave
+ * @param EQUAL Macro ou função que compara duas chaves
+ */
+#define HASHT_OF(NAME, KEY, VALUE, HASH, EQUAL)                                        \
+struct NAME##Slot {                                                                    \
+	KEY key;                                                                           \
+	int value; /* posição do conteúdo em values mais 1, ou 0 se livre */               \
+};                                                                                     \
+                                                                                       \
+struct NAME {                                                                          \
+	struct NAME##Slot* slots;                                                          \
+	VALUE* values;                                                                     \
+	int size;                                                                          \
+	int capacity;                                                                      \
+};                                                                                     \
+                                                                                       \
+static int place##NAME(struct NAME##Slot* slots, int capacity, KEY key) {              \
+	int p = (HASH(key)) & (unsigned) (capacity - 1);                                   \
+                                                                                       \
+	while (slots[p].value && !(EQUAL(slots[p].key, key)))                              \
+		p = (p + 1) & (capacity - 1);                                                  \
+                                                                                       \
+	return p;                                                                          \
+}                                                                                      \
+                                                                                       \
+static struct NAME* init##NAME(int size) {                                             \
+	struct NAME* new = MALLOC_TAG(MEM_HASHT, sizeof(*new));                            \
+                                                                                       \
+	new->slots = CALLOC_TAG(MEM_HASHT, size, sizeof(struct NAME##Slot));               \
+	new->values = MALLOC_TAG(MEM_HASHT, HASHT_OF_LOAD(size) * sizeof(VALUE));          \
+	new->size = 0;                                                                     \
+	new->capacity = size;                                                              \
+                                                                                       \
+	return new;                                                                        \
+}                                                                                      \
+                                                                                       \
+static VALUE* insert##NAME(struct NAME* t, KEY key) {                                  \
+	struct NAME##Slot* old;                                                            \
+	int i, p = place##NAME(t->slots, t->capacity, key);                                \
+                                                                                       \
+	if (t->slots[p].value)                                                             \
+		return &t->values[t->slots[p].value - 1];                                      \
+                                                                                       \
+	/* Os conteúdos não mudam de posição em values, só as posições da tabela */        \
+	if (t->size == HASHT_OF_LOAD(t->capacity)) {                                       \
+		countHashTResize();                                                            \
+		old = t->slots;                                                                \
+		t->slots = CALLOC_TAG(MEM_HASHT, t->capacity * 2, sizeof(struct NAME##Slot));  \
+		t->values = REALLOC_TAG(MEM_HASHT, t->values,                                  \
+		                        HASHT_OF_LOAD(t->capacity * 2) * sizeof(VALUE));       \
+                                                                                       \
+		for(i = 0; i < t->capacity; i++)                                               \
+			if (old[i].value)                                                          \
+				t->slots[place##NAME(t->slots, t->capacity * 2, old[i].key)] = old[i]; \
+                                                                                       \
+		FREE(old);                                                                     \
+		t->capacity *= 2;                                                              \
+		p = place##NAME(t->slots, t->capacity, key);                                   \
+	}                                                                                  \
+                                                                                       \
+	t->slots[p].key = key;                                                             \
+	t->slots[p].value = ++t->size;                                                     \
+	memset(&t->values[t->size - 1], 0, sizeof(VALUE));                                 \
+                                                                                       \
+	return &t->values[t->size - 1];                                                    \
+}                                                                                      \
+                                                                                       \
+static int get##NAME##Size(struct NAME* t) {                                           \
+	return t->size;                                                                    \
+}                                                                                      \
+                                                                                       \
+static VALUE* dump##NAME(struct NAME* t, VALUE* dest) {                                \
+	memcpy(dest, t->values, t->size * sizeof(VALUE));                                  \
+	return dest;                                                                       \
+}                                                                                      \
+                                                                                       \
+static void free##NAME(struct NAME* t) {                                               \
+	if (t) {                                                                           \
+		FREE(t->slots);                                                                \
+		FREE(t->values);                                                               \
+		FREE(t);                                                                       \
+	}                                                                                  \
+}
+
 #endif
@@ -1,9 +1,9 @@
 #include <stdlib.h>
 #include <stdio.h>
-#include <time.h> /* <<---------- TIME.H */
 #include <string.h>
 
 #include "dataloader.h"
+#include "loadstats.h"
 #include "interpreter.h"
 #include "queries.h"
 
@@ -13,18 +13,15 @@
 #define STR_SIZE 128
 #define BUFF_SIZE 255
 
-#define SALES_PATH "Vendas_1M.txt"
-#define CLIENTS_PATH "Clientes.txt"
-#define PRODUCTS_PATH "Produtos.txt"
-
 static void printMainMenu();
 static void printLogo();
 static void presentQueryName(int i);
 
-int interpreter(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat) {
+int interpreter(SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat, CACHE cache) {
 	char answ[BUFF_SIZE];
 	int qnum;
 
+	cache = setCacheGeneration(cache, getSalesIndexGeneration(si));
 
 	printMainMenu();
 	printf("  Escolha uma opção : ");
@@ -53,25 +50,25 @@ int interpreter(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat)
 		case 1 : return LOAD;
 		case 2 : query2(pcat);
 				 break;
-		case 3 : query3(fat, pcat);
+		case 3 : query3(cache, fat, pcat);
 			 	 break;
-		case 4 : query4(fat);
+		case 4 : query4(cache, fat);
 				 break;
-		case 5 : query5(bs, ccat);
+		case 5 : query5(cache, si, ccat);
 		 		 break;
-		case 6 : query6(fat);
+		case 6 : query6(cache, fat);
 		  		 break;
-		case 7 : query7(bs);
+		case 7 : query7(cache, si);
 				 break;
-		case 8 : query8(bs, pcat);
+		case 8 : query8(cache, si, pcat);
 		 		 break;
-		case 9 : query9(bs, ccat); 
+		case 9 : query9(cache, si, ccat); 
 		 		 break;
-		case 10 : query10(bs);
+		case 10 : query10(cache, si);
 		 		  break;
-		case 11 : query11 (bs, ccat);
+		case 11 : query11(cache, si, ccat);
 		 		  break;
-		case 12 : query12 (bs, fat);
+		case 12 : query12(cache, si, fat);
 				  break;
 	}
 
@@ -79,13 +76,11 @@ int interpreter(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat)
 }
 
 
-void loader(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat ) {
-	int i, success, failed;
+void loader(SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat ) {
+	int success, failed;
 	char clientsPath[BUFF_SIZE], productsPath[BUFF_SIZE], salesPath[BUFF_SIZE];
 	FILE *clients, *products, *sales;
 
-	time_t inicio, fim;
-
 	printf("<enter> para escolher opção default.\n");
 
 	while(1) {
@@ -123,7 +118,7 @@ void loader(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat ) {
 
 	putchar('\n');
 
-	inicio = time(NULL);
+	resetLoadStats();
 	printf("A carregar clientes de %s... ", clientsPath);
 	fflush(stdout);
 	success = loadClients(clients, ccat);
@@ -140,16 +135,13 @@ void loader(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat ) {
 
 	printf("A carregar vendas de %s... ", salesPath);
 	fflush(stdout);
-	for(i=0; i < 3; i++)
-		bs[i] = fillBranchSales(bs[i], ccat, pcat);
-	fat = fillFat(fat, pcat);
-	success = loadSales(sales, fat, bs, pcat, ccat, &failed);
+	success = loadSales(sales, fat, si, pcat, ccat, &failed);
 	printf("\nVendas analisadas: %d\n", success+failed);
 	printf("Vendas corretas: %d\n", success);
 	printf("Vendas incorretas: %d\n", failed);
-	fim = time(NULL);
 
-	printf("Tudo carregado em %f segundos.\n", difftime(fim, inicio));
+	printf("Tudo carregado em %.3f segundos.\n", getPhaseTime(PHASES) / 1e9);
+	printLoadStats(stdout);
 	printf("Pressione qualquer tecla para continuar. ");
 	getchar();
 
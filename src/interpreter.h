@@ -1,10 +1,11 @@
 #ifndef __INTERPRETER_H__
 #define __INTERPRETER_H__
 
-#include "branchsales.h"
+#include "salesindex.h"
 #include "fatglobal.h"
 #include "products.h"
 #include "clients.h"
+#include "cache.h"
 
 #define KILL 0
 #define CONT 1
@@ -12,10 +13,15 @@
 
 typedef struct printset *PRINTSET;
 
-void loader (BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat);
+void loader (SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat);
 
 /* void present(PRODUCTSET ps); */
-int interpreter(BRANCHSALES* bs, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat);
+/**
+ * Apresenta o menu principal e executa a query escolhida. Os resultados das queries são
+ * guardados na cache dada enquanto os dados carregados não mudarem.
+ * @return KILL para sair, LOAD para carregar novos dados, CONT caso contrário
+ */
+int interpreter(SALESINDEX si, FATGLOBAL fat, PRODUCTCAT pcat, CLIENTCAT ccat, CACHE cache);
 
 /** 
  * Inicializa um novo PrintSet de tamanho n
@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "loadstats.h"
+#include "avl.h"
+#include "hashT.h"
+
+static long phases[PHASES];
+static long invalid[INVALID_REASONS];
+static long lines = 0;
+
+/* Contadores globais das AVL e das tabelas de hash no último resetLoadStats */
+static long rotations = 0;
+static long resizes = 0;
+
+static char* phaseNames[PHASES + 1] = {
+	"clients", "products", "clones", "parse", "validate", "fat", "index", "compact", "total"
+};
+
+static char* invalidNames[INVALID_REASONS] = {"branch", "product", "client"};
+
+static double linesPerSecond();
+
+void resetLoadStats() {
+	int i;
+
+	for(i = 0; i < PHASES; i++)
+		phases[i] = 0;
+
+	for(i = 0; i < INVALID_REASONS; i++)
+		invalid[i] = 0;
+
+	lines = 0;
+	rotations = getAVLRotations();
+	resizes = getHashTResizes();
+}
+
+long startPhase() {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000L + now.tv_nsec;
+}
+
+long endPhase(PHASE phase, long start) {
+	long now = startPhase();
+
+	phases[phase] += now - start;
+	return now;
+}
+
+void countLoadLine() {
+	lines++;
+}
+
+void countInvalidLine(INVALID reason) {
+	invalid[reason]++;
+}
+
+long getPhaseTime(PHASE phase) {
+	long total = 0;
+	int i;
+
+	if (phase != PHASES)
+		return phases[phase];
+
+	for(i = 0; i < PHASES; i++)
+		total += phases[i];
+
+	return total;
+}
+
+char* getPhaseName(PHASE phase) {
+	return phaseNames[phase];
+}
+
+long getLoadLines() {
+	return lines;
+}
+
+long getInvalidLines(INVALID reason) {
+	return invalid[reason];
+}
+
+void printLoadStats(FILE* out) {
+	int i;
+
+	fprintf(out, "Tempo por fase:\n");
+	for(i = 0; i <= PHASES; i++)
+		fprintf(out, "\t%-10s %10.3f ms\n", phaseNames[i], getPhaseTime(i) / 1e6);
+
+	fprintf(out, "Linhas de vendas: %ld (%.0f por segundo)\n", lines, linesPerSecond());
+	fprintf(out, "Linhas inválidas: filial %ld, produto %ld, cliente %ld\n",
+	        invalid[INVALID_BRANCH], invalid[INVALID_PRODUCT], invalid[INVALID_CLIENT]);
+	fprintf(out, "Redimensionamentos de tabelas de hash: %ld\n", getHashTResizes() - resizes);
+	fprintf(out, "Rotações de AVL: %ld\n", getAVLRotations() - rotations);
+}
+
+void printLoadStatsFields(FILE* out) {
+	int i;
+
+	for(i = 0; i <= PHASES; i++)
+		fprintf(out, "\t%s_ns=%ld", phaseNames[i], getPhaseTime(i));
+
+	fprintf(out, "\tlines=%ld\tlines_per_s=%.0f", lines, linesPerSecond());
+
+	for(i = 0; i < INVALID_REASONS; i++)
+		fprintf(out, "\tinvalid_%s=%ld", invalidNames[i], invalid[i]);
+
+	fprintf(out, "\thasht_resizes=%ld\tavl_rotations=%ld",
+	        getHashTResizes() - resizes, getAVLRotations() - rotations);
+}
+
+/**
+ * Linhas de vendas lidas por segundo, desde a cópia dos catálogos até à compactação.
+ */
+static double linesPerSecond() {
+	long ns = 0;
+	int i;
+
+	for(i = PHASE_CLONES; i <= PHASE_COMPACT; i++)
+		ns += phases[i];
+
+	return ns ? lines * 1e9 / ns : 0;
+}
@@ -0,0 +1,89 @@
+#ifndef __LOADSTATS__
+#define __LOADSTATS__
+
+#include <stdio.h>
+
+/**
+ * Tempos e contadores da leitura dos dados (ver dataloader.h), acumulados desde o último
+ * resetLoadStats. Os tempos são medidos com um relógio monotónico, em nanosegundos.
+ */
+
+/** Fases da leitura */
+typedef enum phase {
+	PHASE_CLIENTS,   /* catálogo de clientes */
+	PHASE_PRODUCTS,  /* catálogo de produtos */
+	PHASE_CLONES,    /* cópia dos catálogos para a faturação e o índice de vendas */
+	PHASE_PARSE,     /* leitura das linhas de vendas e separação dos campos */
+	PHASE_VALIDATE,  /* validação da filial, do produto e do cliente */
+	PHASE_FAT,       /* atualização da faturação global */
+	PHASE_INDEX,     /* atualização do índice de vendas por filial */
+	PHASE_COMPACT,   /* compactação do índice de vendas */
+	PHASES
+} PHASE;
+
+/** Motivos por que uma linha de vendas é inválida, pela ordem em que são verificados */
+typedef enum invalid {
+	INVALID_BRANCH,
+	INVALID_PRODUCT,
+	INVALID_CLIENT,
+	INVALID_REASONS
+} INVALID;
+
+/**
+ * Põe os tempos e os contadores a zero, antes de uma nova leitura.
+ */
+void resetLoadStats();
+
+/**
+ * Devolve o instante atual, a passar a endPhase no fim da fase.
+ */
+long startPhase();
+
+/**
+ * Acumula na fase dada o tempo decorrido desde start.
+ * @return Instante atual, que pode ser usado como início da fase seguinte
+ */
+long endPhase(PHASE phase, long start);
+
+/**
+ * Conta mais uma linha de vendas lida.
+ */
+void countLoadLine();
+
+/**
+ * Conta mais uma linha de vendas inválida pelo motivo dado.
+ */
+void countInvalidLine(INVALID reason);
+
+/**
+ * Devolve o tempo acumulado numa fase, ou em todas se phase for PHASES.
+ */
+long getPhaseTime(PHASE phase);
+
+/**
+ * Devolve o nome de uma fase, ou "total" para PHASES.
+ */
+char* getPhaseName(PHASE phase);
+
+/**
+ * Devolve o número de linhas de vendas lidas.
+ */
+long getLoadLines();
+
+/**
+ * Devolve o número de linhas de vendas inválidas por um dado motivo.
+ */
+long getInvalidLines(INVALID reason);
+
+/**
+ * Escreve um relatório dos tempos e contadores, para ser lido por pessoas.
+ */
+void printLoadStats(FILE* out);
+
+/**
+ * Escreve os tempos e contadores como campos "\tnome=valor", sem mudar de linha, no
+ * formato das linhas de resumo do modo batch (ver batch.h).
+ */
+void printLoadStatsFields(FILE* out);
+
+#endif
@@ -1,44 +1,166 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "interpreter.h"
 #include "dataloader.h"
-#include "branchsales.h"
+#include "batch.h"
+#include "salesindex.h"
 #include "fatglobal.h"
 #include "clients.h"
 #include "products.h"
+#include "threadpool.h"
+#include "memstat.h"
 
-#define BRANCHES 3
+#define DEFAULT_BRANCHES 3
+#define CACHE_BYTES (64L * 1024 * 1024)
 
-int main() {
+/* Filtros de Bloom dos catálogos, por omissão desligados (taxa 0 = sem filtro) e
+ * configuráveis com -bloom taxa [-bloomBytes bytes]. Rejeitam um código inválido em
+ * cerca de metade do tempo, mas atrasam os válidos: só compensam quando uma boa parte
+ * das vendas tem códigos inválidos, o que não é o caso dos ficheiros habituais */
+#define FILTER_FP_RATE 0
+#define FILTER_BYTES (4L * 1024 * 1024)
+
+static double filterRate = FILTER_FP_RATE;
+static long filterBytes = FILTER_BYTES;
+
+static int batchMode(char* commands, char** paths, int branches, THREADPOOL pool);
+static void freeData(FATGLOBAL fat, SALESINDEX si, PRODUCTCAT pcat, CLIENTCAT ccat);
+
+int main(int argc, char** argv) {
 	FATGLOBAL fat;
-	BRANCHSALES branchSales[3];
+	SALESINDEX salesIndex;
 	CLIENTCAT clientCat;
 	PRODUCTCAT productCat;
-	int i, running = 3;
+	CACHE cache;
+	THREADPOOL pool;
+	char *batch = NULL, *paths[3] = {CLIENTS_PATH, PRODUCTS_PATH, SALES_PATH};
+	int i, nPaths = 0, branches = DEFAULT_BRANCHES, running = 3;
+
+	for(i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-b") && i + 1 < argc && !batch)
+			batch = argv[++i];
+		else if (!strcmp(argv[i], "-bloom") && i + 1 < argc)
+			filterRate = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-bloomBytes") && i + 1 < argc)
+			filterBytes = atol(argv[++i]);
+		else if (batch && nPaths < 3)
+			paths[nPaths++] = argv[i];
+		else if (i == 1)
+			branches = atoi(argv[i]);
+		else
+			branches = 0;
+	}
+
+	if (branches < 1 || branches > MAX_BRANCHES ||
+	    filterRate < 0 || filterRate >= 1 || filterBytes < 0) {
+		fprintf(stderr, "Uso: %s [número de filiais (1-%d)] [-bloom taxa [-bloomBytes bytes]] "
+		                "[-b comandos [clientes produtos vendas]]\n", argv[0], MAX_BRANCHES);
+		return 1;
+	}
+
+	pool = initThreadPool(0);
+
+	if (batch) {
+		running = batchMode(batch, paths, branches, pool);
+		freeThreadPool(pool);
+		return running;
+	}
+
+	cache = initCache(CACHE_BYTES);
 
 	while(running != KILL) {
 
 		if (running != CONT) {
-			fat = initFat(BRANCHES);
-			clientCat = initClientCat();
-			productCat = initProductCat();
-			for(i=0; i < 3; i++)
-				 branchSales[i] = initBranchSales();
+			/* Cada carregamento tem a sua região, descartada de uma vez ao recarregar */
+			useRegion(initRegion(0));
+
+			fat = initFat(branches);
+			clientCat = setClientCatFilter(initClientCat(), filterRate, filterBytes);
+			productCat = setProductCatFilter(initProductCat(), filterRate, filterBytes);
+			salesIndex = initSalesIndex(branches);
+
+			fat = setFatPool(fat, pool);
+			salesIndex = setSalesIndexPool(salesIndex, pool);
 	
-			if(running == LOAD) loader(branchSales, fat, productCat, clientCat);
+			if(running == LOAD) loader(salesIndex, fat, productCat, clientCat);
+
+			/* O que as consultas alocam fica fora da região, que só guarda os dados */
+			closeRegion();
 		}
 		
-		running = interpreter(branchSales, fat, productCat, clientCat);
-
-		if (running != CONT) { 
-			freeFat(fat);
-			for (i=0; i < 3; i++)
-				freeBranchSales(branchSales[i]);
-			freeProductCat(productCat);
-			freeClientCat(clientCat);
-		}
+		running = interpreter(salesIndex, fat, productCat, clientCat, cache);
+
+		if (running != CONT)
+			freeData(fat, salesIndex, productCat, clientCat);
 	}
 
+	freeCache(cache);
+	freeThreadPool(pool);
 
 	return 0;
 }
+
+/**
+ * Carrega os dados e executa os comandos do ficheiro dado ("-" para o stdin), escrevendo
+ * os resultados no stdout, seguidos dos contadores do pool de trabalhadores.
+ * @return 0 se todos os comandos foram executados com sucesso, 1 caso contrário
+ */
+static int batchMode(char* commands, char** paths, int branches, THREADPOOL pool) {
+	FATGLOBAL fat;
+	SALESINDEX salesIndex;
+	CLIENTCAT clientCat;
+	PRODUCTCAT productCat;
+	FILE* in;
+	int failed;
+
+	in = strcmp(commands, "-") ? fopen(commands, "r") : stdin;
+	if (!in) {
+		fprintf(stderr, "Ficheiro %s inválido ou inexistente!\n", commands);
+		return 1;
+	}
+
+	useRegion(initRegion(0));
+
+	fat = initFat(branches);
+	clientCat = setClientCatFilter(initClientCat(), filterRate, filterBytes);
+	productCat = setProductCatFilter(initProductCat(), filterRate, filterBytes);
+	salesIndex = initSalesIndex(branches);
+
+	fat = setFatPool(fat, pool);
+	salesIndex = setSalesIndexPool(salesIndex, pool);
+
+	failed = batchLoad(stdout, paths, salesIndex, fat, productCat, clientCat);
+	closeRegion();
+
+	if (!failed)
+		failed = runBatch(in, stdout, salesIndex, fat, productCat, clientCat);
+
+	/* Contadores do escalonador, para afinar o paralelismo */
+	printf("=pool\tok\tworkers=%d\ttasks=%ld\tsteals=%ld\tidle_ns=%ld\n",
+	       getThreadPoolWorkers(pool), getThreadPoolTasks(pool),
+	       getThreadPoolSteals(pool), getThreadPoolIdleTime(pool));
+
+	freeData(fat, salesIndex, productCat, clientCat);
+
+	if (in != stdin) fclose(in);
+
+	return (failed != 0);
+}
+
+/**
+ * Descarta os dados carregados. Se estiverem todos numa região, esta é libertada de uma
+ * só vez; caso contrário (sem região, ou se a região encheu), as estruturas são
+ * percorridas e libertadas uma a uma, e só depois é libertada a região.
+ */
+static void freeData(FATGLOBAL fat, SALESINDEX si, PRODUCTCAT pcat, CLIENTCAT ccat) {
+	if (dropRegion()) return;
+
+	freeFat(fat);
+	freeSalesIndex(si);
+	freeProductCat(pcat);
+	freeClientCat(ccat);
+
+	releaseRegion();
+}
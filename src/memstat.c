@@ -0,0 +1,307 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "memstat.h"
+
+/* Contadores de um subsistema */
+struct counters {
+	long allocs;
+	long frees;
+	long bytes;
+	long liveBlocks;
+	long liveBytes;
+	long peakBytes;
+
+	/* Parte dos blocos e bytes por libertar que está na região */
+	long regionBlocks;
+	long regionBytes;
+};
+
+static struct counters counters[MEM_ALL + 1];
+
+static char* tagNames[MEM_ALL + 1] = {
+	"avl", "catalog", "hashT", "set", "fatglobal", "salesindex", "queries", "other", "all"
+};
+
+REGION memRegion = NULL;
+
+/* Se os dados ainda estão a ser carregados, e portanto alocados na região */
+bool memLoading = false;
+
+/* Se a região encheu e algum bloco do carregamento teve de vir do malloc. Os blocos são
+ * alocados por vários trabalhadores ao mesmo tempo, pelo que só é acedido atomicamente */
+static int overflow = 0;
+
+#define SET_OVERFLOW()   __sync_lock_test_and_set(&overflow, 1)
+#define CLEAR_OVERFLOW() __sync_lock_release(&overflow)
+#define OVERFLOWED()     __sync_add_and_fetch(&overflow, 0)
+
+static void* rawAlloc(MEMTAG tag, size_t size);
+static void* rawRealloc(MEMTAG tag, void* ptr, size_t size);
+static void rawFree(void* ptr);
+
+#ifdef MEMSTAT
+
+/* Os contadores podem ser atualizados por várias threads ao mesmo tempo (ver threadpool.h) */
+#define COUNT(counter, n) __sync_add_and_fetch(&(counter), (long) (n))
+
+/**
+ * Cabeçalho guardado antes de cada bloco, com o tamanho pedido, o subsistema dono e se
+ * o bloco está na região. A união garante que o bloco devolvido mantém o alinhamento
+ * de malloc.
+ */
+typedef union header {
+	struct {
+		size_t size;
+		MEMTAG tag;
+		bool held;
+	} block;
+	long double align;
+	void* ptr;
+} HEADER;
+
+static HEADER* setHeader(HEADER* h, MEMTAG tag, size_t size);
+static void countFree(HEADER* h);
+static void countLive(MEMTAG tag, long blocks, long bytes, bool held);
+
+void* tagMalloc(MEMTAG tag, size_t size) {
+	HEADER* h = rawAlloc(tag, sizeof(HEADER) + size);
+
+	return h ? setHeader(h, tag, size) + 1 : NULL;
+}
+
+void* tagCalloc(MEMTAG tag, size_t n, size_t size) {
+	void* ptr = tagMalloc(tag, n * size);
+
+	if (ptr) memset(ptr, 0, n * size);
+	return ptr;
+}
+
+void* tagRealloc(MEMTAG tag, void* ptr, size_t size) {
+	HEADER *h, *old = ptr ? (HEADER*) ptr - 1 : NULL;
+
+	if (!old) return tagMalloc(tag, size);
+
+	/* O bloco passa a pertencer ao subsistema que o realocou */
+	countLive(old->block.tag, -1, -(long) old->block.size, old->block.held);
+
+	if (!(h = rawRealloc(tag, old, sizeof(HEADER) + size))) {
+		countLive(old->block.tag, 1, old->block.size, old->block.held);
+		return NULL;
+	}
+
+	return setHeader(h, tag, size) + 1;
+}
+
+void tagFree(void* ptr) {
+	HEADER* h;
+
+	if (ptr) {
+		h = (HEADER*) ptr - 1;
+		countFree(h);
+		rawFree(h);
+	}
+}
+
+void releaseRegion() {
+	int i;
+
+	if (!memRegion) return;
+
+	/* Nenhuma outra thread pode estar a alocar enquanto a região é descartada */
+	for(i = 0; i < MEM_ALL; i++) {
+		counters[i].frees += counters[i].regionBlocks;
+		counters[i].liveBlocks -= counters[i].regionBlocks;
+		counters[i].liveBytes -= counters[i].regionBytes;
+
+		counters[MEM_ALL].frees += counters[i].regionBlocks;
+		counters[MEM_ALL].liveBlocks -= counters[i].regionBlocks;
+		counters[MEM_ALL].liveBytes -= counters[i].regionBytes;
+
+		counters[i].regionBlocks = counters[i].regionBytes = 0;
+	}
+
+	freeRegion(memRegion);
+	memRegion = NULL;
+	memLoading = false;
+	CLEAR_OVERFLOW();
+}
+
+static HEADER* setHeader(HEADER* h, MEMTAG tag, size_t size) {
+	h->block.size = size;
+	h->block.tag = tag;
+	h->block.held = memRegion && inRegion(memRegion, h);
+
+	COUNT(counters[tag].allocs, 1);
+	COUNT(counters[tag].bytes, size);
+	COUNT(counters[MEM_ALL].allocs, 1);
+	COUNT(counters[MEM_ALL].bytes, size);
+
+	countLive(tag, 1, size, h->block.held);
+
+	return h;
+}
+
+static void countFree(HEADER* h) {
+	COUNT(counters[h->block.tag].frees, 1);
+	COUNT(counters[MEM_ALL].frees, 1);
+
+	countLive(h->block.tag, -1, -(long) h->block.size, h->block.held);
+}
+
+/**
+ * Atualiza os blocos e os bytes por libertar de um subsistema e do total, e os
+ * respetivos máximos.
+ * @param held Se os blocos estão na região
+ */
+static void countLive(MEMTAG tag, long blocks, long bytes, bool held) {
+	struct counters* c[2];
+	long live, peak;
+	int i;
+
+	c[0] = &counters[tag];
+	c[1] = &counters[MEM_ALL];
+
+	if (held) {
+		COUNT(c[0]->regionBlocks, blocks);
+		COUNT(c[0]->regionBytes, bytes);
+	}
+
+	for(i = 0; i < 2; i++) {
+		COUNT(c[i]->liveBlocks, blocks);
+		live = COUNT(c[i]->liveBytes, bytes);
+
+		while((peak = COUNT(c[i]->peakBytes, 0)) < live &&
+		      !__sync_bool_compare_and_swap(&c[i]->peakBytes, peak, live));
+	}
+}
+
+#else
+
+void* tagMalloc(MEMTAG tag, size_t size) {
+	return rawAlloc(tag, size);
+}
+
+void* tagCalloc(MEMTAG tag, size_t n, size_t size) {
+	void* ptr;
+
+	if (!memRegion || !memLoading) return calloc(n, size);
+
+	if ((ptr = rawAlloc(tag, n * size))) memset(ptr, 0, n * size);
+	return ptr;
+}
+
+void* tagRealloc(MEMTAG tag, void* ptr, size_t size) {
+	return rawRealloc(tag, ptr, size);
+}
+
+void tagFree(void* ptr) {
+	rawFree(ptr);
+}
+
+void releaseRegion() {
+	freeRegion(memRegion);
+	memRegion = NULL;
+	memLoading = false;
+	CLEAR_OVERFLOW();
+}
+
+#endif
+
+void useRegion(REGION r) {
+	memRegion = r;
+	memLoading = (r != NULL);
+	CLEAR_OVERFLOW();
+}
+
+void closeRegion() {
+	memLoading = false;
+}
+
+bool dropRegion() {
+	if (!memRegion || OVERFLOWED()) return false;
+
+	releaseRegion();
+	return true;
+}
+
+/**
+ * Aloca na região os blocos pedidos durante o carregamento, e no malloc os restantes,
+ * bem como os que já não cabem na região.
+ */
+static void* rawAlloc(MEMTAG tag, size_t size) {
+	void* ptr;
+
+	(void) tag;
+
+	if (memRegion && memLoading) {
+		if ((ptr = regionAlloc(memRegion, size))) return ptr;
+		SET_OVERFLOW();
+	}
+
+	return malloc(size);
+}
+
+/**
+ * Muda o tamanho de um bloco sem o mudar de sítio: um bloco da região continua na
+ * região e um do malloc continua no malloc. Só se a região estiver cheia é que um bloco
+ * da região passa para o malloc.
+ */
+static void* rawRealloc(MEMTAG tag, void* ptr, size_t size) {
+	void* new;
+
+	if (!ptr) return rawAlloc(tag, size);
+
+	if (!memRegion || !inRegion(memRegion, ptr))
+		return realloc(ptr, size);
+
+	if ((new = regionRealloc(memRegion, ptr, size))) return new;
+
+	/* O bloco só não coube por ter crescido, pelo que todo o conteúdo cabe no novo */
+	if ((new = malloc(size))) {
+		SET_OVERFLOW();
+		memcpy(new, ptr, getRegionBlockSize(ptr));
+		regionFree(memRegion, ptr);
+	}
+
+	return new;
+}
+
+static void rawFree(void* ptr) {
+	if (memRegion && inRegion(memRegion, ptr))
+		regionFree(memRegion, ptr);
+	else
+		free(ptr);
+}
+
+long getAllocCount() {
+	return counters[MEM_ALL].allocs;
+}
+
+long getFreeCount() {
+	return counters[MEM_ALL].frees;
+}
+
+long getAllocBytes() {
+	return counters[MEM_ALL].bytes;
+}
+
+char* getMemTagName(MEMTAG tag) {
+	return tagNames[tag];
+}
+
+long getMemAllocs(MEMTAG tag) {
+	return counters[tag].allocs;
+}
+
+long getMemLiveBlocks(MEMTAG tag) {
+	return counters[tag].liveBlocks;
+}
+
+long getMemLiveBytes(MEMTAG tag) {
+	return counters[tag].liveBytes;
+}
+
+long getMemPeakBytes(MEMTAG tag) {
+	return counters[tag].peakBytes;
+}
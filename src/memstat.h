@@ -0,0 +1,150 @@
+#ifndef __MEMSTAT__
+#define __MEMSTAT__
+
+#include <stdlib.h>
+
+#include "generic.h"
+#include "region.h"
+
+/**
+ * Alocação e contabilidade da memória do programa, por subsistema. Os módulos alocam
+ * através das macros MALLOC, CALLOC, REALLOC e FREE, atribuindo a memória ao subsistema
+ * indicado por MEMSTAT_TAG, que cada módulo define depois de incluir este ficheiro:
+ *
+ *     #define MEMSTAT_TAG MEM_AVL
+ *
+ * Enquanto os dados são carregados, a memória pode ser alocada numa região (ver
+ * useRegion), descartada de uma só vez quando os dados deixam de ser precisos.
+ * A contabilidade só está ativa quando o programa é compilado com MEMSTAT; caso
+ * contrário os contadores devolvem sempre 0 e, fora do carregamento e sem região em
+ * uso, as macros limitam-se a chamar malloc, calloc, realloc e free. A memória obtida
+ * com estas macros só pode ser libertada com FREE, e as macros que recebem o
+ * subsistema (MALLOC_TAG, ...) servem o código que não define MEMSTAT_TAG.
+ */
+
+/** Subsistemas a que são atribuídas as alocações */
+typedef enum memtag {
+	MEM_AVL,
+	MEM_CATALOG,     /* catálogos, clientes e produtos */
+	MEM_HASHT,
+	MEM_SET,
+	MEM_FATGLOBAL,
+	MEM_SALESINDEX,  /* índice de vendas por filial e rankings */
+	MEM_QUERIES,     /* motor, resultados, cursores e cache */
+	MEM_OTHER,
+	MEM_ALL          /* todos os subsistemas; não pode ser usado em MEMSTAT_TAG */
+} MEMTAG;
+
+#define MALLOC(size)       MALLOC_TAG(MEMSTAT_TAG, size)
+#define CALLOC(n, size)    CALLOC_TAG(MEMSTAT_TAG, n, size)
+#define REALLOC(ptr, size) REALLOC_TAG(MEMSTAT_TAG, ptr, size)
+
+#ifdef MEMSTAT
+
+#define MALLOC_TAG(tag, size)       tagMalloc((tag), (size))
+#define CALLOC_TAG(tag, n, size)    tagCalloc((tag), (n), (size))
+#define REALLOC_TAG(tag, ptr, size) tagRealloc((tag), (ptr), (size))
+#define FREE(ptr)                   tagFree(ptr)
+
+#else
+
+/* Sem contabilidade, só se passa pelo memstat para alocar durante o carregamento ou
+ * para mexer em blocos que podem estar na região; de resto as macros são o próprio
+ * malloc, calloc, realloc e free */
+#define MALLOC_TAG(tag, size) \
+	(memLoading ? tagMalloc((tag), (size)) : malloc(size))
+#define CALLOC_TAG(tag, n, size) \
+	(memLoading ? tagCalloc((tag), (n), (size)) : calloc((n), (size)))
+#define REALLOC_TAG(tag, ptr, size) \
+	(memRegion ? tagRealloc((tag), (ptr), (size)) : realloc((ptr), (size)))
+#define FREE(ptr) \
+	(memRegion ? tagFree(ptr) : free(ptr))
+
+#endif
+
+/* Região em uso e se os dados estão a ser carregados, consultadas pelas macros; só
+ * devem ser alteradas através de useRegion, closeRegion, dropRegion e releaseRegion */
+extern REGION memRegion;
+extern bool memLoading;
+
+void* tagMalloc(MEMTAG tag, size_t size);
+void* tagCalloc(MEMTAG tag, size_t n, size_t size);
+void* tagRealloc(MEMTAG tag, void* ptr, size_t size);
+void  tagFree(void* ptr);
+
+/**
+ * Começa o carregamento dos dados: tudo o que for alocado até closeRegion vai para a
+ * região dada. Deve ser chamada antes de os dados serem criados. Os blocos da região
+ * podem ser libertados um a um com FREE até a região ser descartada com dropRegion.
+ * @param r Região a usar, ou NULL para usar sempre o malloc
+ */
+void useRegion(REGION r);
+
+/**
+ * Termina o carregamento dos dados: as alocações seguintes, feitas pelas consultas, vêm
+ * do malloc, mesmo as dos subsistemas dos dados. A região continua em uso até ser
+ * descartada, e os seus blocos continuam a poder ser realocados e libertados com FREE.
+ * As estruturas carregadas não devem guardar memória alocada depois desta chamada, que
+ * dropRegion não libertaria.
+ */
+void closeRegion();
+
+/**
+ * Liberta de uma só vez a região em uso e tudo o que lá foi alocado, sem percorrer as
+ * estruturas, e volta a usar o malloc. Os contadores passam a tratar os blocos da
+ * região como libertados.
+ * @return false se não havia nenhuma região em uso, ou se a região encheu e parte dos
+ * blocos do carregamento veio do malloc; nesse caso nada foi libertado, e as
+ * estruturas têm de ser libertadas uma a uma antes de releaseRegion
+ */
+bool dropRegion();
+
+/**
+ * Liberta a região em uso, mesmo que tenha enchido, e volta a usar o malloc. Os blocos
+ * do carregamento que vieram do malloc não são libertados.
+ */
+void releaseRegion();
+
+/**
+ * Devolve o número de alocações (MALLOC, CALLOC e REALLOC) feitas até ao momento.
+ */
+long getAllocCount();
+
+/**
+ * Devolve o número de blocos libertados até ao momento.
+ */
+long getFreeCount();
+
+/**
+ * Devolve o total de bytes pedidos em alocações até ao momento.
+ */
+long getAllocBytes();
+
+/**
+ * Devolve o nome de um subsistema, ou "all" para MEM_ALL.
+ */
+char* getMemTagName(MEMTAG tag);
+
+/**
+ * Devolve o número de alocações feitas por um subsistema até ao momento.
+ */
+long getMemAllocs(MEMTAG tag);
+
+/**
+ * Devolve o número de blocos de um subsistema ainda não libertados.
+ */
+long getMemLiveBlocks(MEMTAG tag);
+
+/**
+ * Devolve o número de bytes de um subsistema ainda não libertados.
+ */
+long getMemLiveBytes(MEMTAG tag);
+
+/**
+ * Devolve o máximo de bytes que um subsistema teve por libertar num dado instante.
+ * O máximo de MEM_ALL não é a soma dos máximos dos subsistemas, que podem ser atingidos
+ * em instantes diferentes.
+ */
+long getMemPeakBytes(MEMTAG tag);
+
+#endif
@@ -0,0 +1,267 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "perfecthash.h"
+#include "generic.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_CATALOG
+
+#define MASK 0xFFFFFFFFUL
+
+/* Número médio de chaves por balde */
+#define BUCKET_KEYS 2
+
+/* Uma posição livre por cada SPARE chaves; sem folga, os últimos baldes precisariam de
+ * muitas tentativas até encontrarem posições livres */
+#define SPARE 10
+
+/* Sementes tentadas antes de a construção desistir */
+#define SEEDS 8
+
+/*
+ * Posição de uma chave, dado o deslocamento k do seu balde. Os deslocamentos seguidos
+ * variam primeiro o múltiplo de f2, pelo que cada chave salta para posições dispersas em
+ * vez de avançar uma posição de cada vez.
+ */
+#define POSITION(ph, k, kh) \
+	(((kh).f1 + ((k) % (ph)->slots) * (kh).f2 + (k) / (ph)->slots) % (ph)->slots)
+
+struct perfecthash {
+	int n;
+	int slots;
+	int buckets;
+	unsigned long seed;
+
+	unsigned long *displacements;   /* deslocamento de cada balde */
+	int *ids;                       /* identificador da chave em cada posição, ou -1 */
+
+	/* Cópias das chaves, seguidas umas às outras, e o início de cada uma */
+	char *keys;
+	int used;
+	int capacity;
+	int *offsets;
+	int reserved;
+};
+
+/* Balde de uma chave e os dois termos que, com o deslocamento, dão a sua posição */
+struct key_hash {
+	unsigned long bucket;
+	unsigned long f1;
+	unsigned long f2;
+};
+
+static struct key_hash hashKey(PERFECTHASH ph, char* key);
+static unsigned long mix(unsigned long h);
+static bool placeKeys(PERFECTHASH ph);
+static bool placeBucket(PERFECTHASH ph, struct key_hash* kh, int* keys, int size, int b);
+
+PERFECTHASH initPerfectHash(int n) {
+	PERFECTHASH new = MALLOC(sizeof(*new));
+
+	new->n = 0;
+	new->slots = new->buckets = 0;
+	new->seed = 0;
+	new->displacements = NULL;
+	new->ids = NULL;
+
+	new->reserved = (n > 0) ? n : 1;
+	new->offsets = MALLOC(sizeof(int) * new->reserved);
+	new->capacity = new->reserved * 8;
+	new->keys = MALLOC(new->capacity);
+	new->used = 0;
+
+	return new;
+}
+
+PERFECTHASH addPerfectHashKey(PERFECTHASH ph, char* key) {
+	int size = strlen(key) + 1;
+
+	if (ph->n == ph->reserved) {
+		ph->reserved *= 2;
+		ph->offsets = REALLOC(ph->offsets, sizeof(int) * ph->reserved);
+	}
+
+	while (ph->used + size > ph->capacity) {
+		ph->capacity *= 2;
+		ph->keys = REALLOC(ph->keys, ph->capacity);
+	}
+
+	memcpy(ph->keys + ph->used, key, size);
+	ph->offsets[ph->n++] = ph->used;
+	ph->used += size;
+
+	return ph;
+}
+
+PERFECTHASH buildPerfectHash(PERFECTHASH ph) {
+	int i;
+
+	ph->slots = ph->n + ph->n / SPARE + 2;
+	ph->buckets = ph->n / BUCKET_KEYS + 1;
+	ph->displacements = MALLOC(sizeof(unsigned long) * ph->buckets);
+	ph->ids = MALLOC(sizeof(int) * ph->slots);
+
+	for(ph->seed = 0; ph->seed < SEEDS; ph->seed++) {
+		for(i = 0; i < ph->buckets; i++)
+			ph->displacements[i] = 0;
+		for(i = 0; i < ph->slots; i++)
+			ph->ids[i] = -1;
+
+		if (placeKeys(ph)) return ph;
+	}
+
+	freePerfectHash(ph);
+	return NULL;
+}
+
+int getPerfectHashId(PERFECTHASH ph, char* key) {
+	struct key_hash kh = hashKey(ph, key);
+	int id = ph->ids[POSITION(ph, ph->displacements[kh.bucket], kh)];
+
+	return (id >= 0 && !strcmp(ph->keys + ph->offsets[id], key)) ? id : -1;
+}
+
+int getPerfectHashSize(PERFECTHASH ph) {
+	return ph->n;
+}
+
+void freePerfectHash(PERFECTHASH ph) {
+	if (ph) {
+		FREE(ph->displacements);
+		FREE(ph->ids);
+		FREE(ph->keys);
+		FREE(ph->offsets);
+		FREE(ph);
+	}
+}
+
+/**
+ * Calcula, numa só passagem pela chave, duas hashes de 32 bits independentes, de onde
+ * são tirados o balde e os dois termos da posição.
+ */
+static struct key_hash hashKey(PERFECTHASH ph, char* key) {
+	struct key_hash kh;
+	unsigned long a = 2166136261UL ^ ph->seed, b = 0x9747b28cUL + ph->seed;
+	unsigned char c;
+
+	while ((c = *key++)) {
+		a = ((a ^ c) * 16777619UL) & MASK;
+		b = ((b ^ c) * 0x5bd1e995UL) & MASK;
+		b ^= b >> 15;
+	}
+
+	a = mix(a);
+	b = mix(b);
+
+	kh.bucket = a % ph->buckets;
+	kh.f1 = b % ph->slots;
+	kh.f2 = mix((a + b) & MASK) % (ph->slots - 1) + 1;
+
+	return kh;
+}
+
+/**
+ * Espalha os bits de uma hash de 32 bits (finalizador do MurmurHash3).
+ */
+static unsigned long mix(unsigned long h) {
+	h ^= h >> 16;
+	h = (h * 0x85ebca6bUL) & MASK;
+	h ^= h >> 13;
+	h = (h * 0xc2b2ae35UL) & MASK;
+	h ^= h >> 16;
+
+	return h;
+}
+
+/**
+ * Agrupa as chaves por balde e coloca os baldes do maior para o menor, enquanto ainda
+ * há muitas posições livres para os maiores.
+ * @return false se algum balde não puder ser colocado com a semente atual
+ */
+static bool placeKeys(PERFECTHASH ph) {
+	struct key_hash* kh = MALLOC(sizeof(struct key_hash) * ph->n);
+	int *first, *next, *keys, *sizes, *order;
+	int i, b, size, maxSize = 0;
+	bool placed = true;
+
+	first = CALLOC(ph->buckets + 1, sizeof(int));
+	next = MALLOC(sizeof(int) * (ph->buckets + 1));
+	keys = MALLOC(sizeof(int) * (ph->n + 1));
+
+	for(i = 0; i < ph->n; i++) {
+		kh[i] = hashKey(ph, ph->keys + ph->offsets[i]);
+		first[kh[i].bucket + 1]++;
+	}
+
+	for(b = 0; b < ph->buckets; b++) {
+		if (first[b + 1] > maxSize) maxSize = first[b + 1];
+		first[b + 1] += first[b];
+	}
+
+	memcpy(next, first, sizeof(int) * (ph->buckets + 1));
+	for(i = 0; i < ph->n; i++)
+		keys[next[kh[i].bucket]++] = i;
+
+	/* Baldes ordenados por tamanho decrescente, por contagem */
+	sizes = CALLOC(maxSize + 2, sizeof(int));
+	order = MALLOC(sizeof(int) * ph->buckets);
+
+	for(b = 0; b < ph->buckets; b++)
+		sizes[maxSize - (first[b + 1] - first[b]) + 1]++;
+	for(size = 0; size <= maxSize; size++)
+		sizes[size + 1] += sizes[size];
+	for(b = 0; b < ph->buckets; b++)
+		order[sizes[maxSize - (first[b + 1] - first[b])]++] = b;
+
+	for(i = 0; placed && i < ph->buckets; i++) {
+		b = order[i];
+		size = first[b + 1] - first[b];
+		if (size == 0) break;
+
+		placed = placeBucket(ph, kh, keys + first[b], size, b);
+	}
+
+	FREE(kh);
+	FREE(first);
+	FREE(next);
+	FREE(keys);
+	FREE(sizes);
+	FREE(order);
+
+	return placed;
+}
+
+/**
+ * Procura o primeiro deslocamento que leva todas as chaves do balde para posições
+ * livres e distintas, e ocupa-as.
+ */
+static bool placeBucket(PERFECTHASH ph, struct key_hash* kh, int* keys, int size, int b) {
+	unsigned long k, limit = (unsigned long) ph->slots * ph->slots;
+	int i, j, p;
+
+	/* Duas chaves com os mesmos termos ficariam sempre na mesma posição */
+	for(i = 0; i < size; i++)
+		for(j = i + 1; j < size; j++)
+			if (kh[keys[i]].f1 == kh[keys[j]].f1 && kh[keys[i]].f2 == kh[keys[j]].f2)
+				return false;
+
+	for(k = 0; k < limit; k++) {
+		for(i = 0; i < size; i++) {
+			p = POSITION(ph, k, kh[keys[i]]);
+			if (ph->ids[p] != -1) break;
+			ph->ids[p] = keys[i];
+		}
+
+		if (i == size) {
+			ph->displacements[b] = k;
+			return true;
+		}
+
+		/* Liberta as posições ocupadas por esta tentativa */
+		for(j = 0; j < i; j++)
+			ph->ids[POSITION(ph, k, kh[keys[j]])] = -1;
+	}
+
+	return false;
+}
@@ -0,0 +1,47 @@
+#ifndef __PERFECTHASH__
+#define __PERFECTHASH__
+
+typedef struct perfecthash *PERFECTHASH;
+
+/**
+ * Inicia uma função de hash perfeita (CHD, "compress, hash and displace") sobre um
+ * conjunto fixo de chaves, que atribui a cada chave um identificador denso, de 0 até
+ * ao número de chaves - 1, pela ordem em que as chaves foram adicionadas. As chaves são
+ * adicionadas com addPerfectHashKey e a função é construída com buildPerfectHash.
+ * @param n Número de chaves previsto (é só uma reserva inicial)
+ */
+PERFECTHASH initPerfectHash(int n);
+
+/**
+ * Adiciona uma cópia de uma chave, que não pode ter sido adicionada antes. Não pode ser
+ * usada depois de buildPerfectHash.
+ */
+PERFECTHASH addPerfectHashKey(PERFECTHASH ph, char* key);
+
+/**
+ * Constrói a função para as chaves adicionadas. Cada chave fica numa posição própria
+ * de uma tabela com pouco mais posições do que chaves, encontrada a partir do
+ * deslocamento do seu balde.
+ * @return A função construída, ou NULL se a construção falhar, caso em que ph é
+ * libertada
+ */
+PERFECTHASH buildPerfectHash(PERFECTHASH ph);
+
+/**
+ * Determina o identificador de uma chave, calculando uma hash e comparando uma única
+ * chave guardada.
+ * @return O identificador, ou -1 se a chave não for uma das chaves adicionadas
+ */
+int getPerfectHashId(PERFECTHASH ph, char* key);
+
+/**
+ * Devolve o número de chaves adicionadas.
+ */
+int getPerfectHashSize(PERFECTHASH ph);
+
+/**
+ * Liberta a função e as cópias das chaves.
+ */
+void freePerfectHash(PERFECTHASH ph);
+
+#endif
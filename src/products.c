@@ -1,10 +1,16 @@
 #include <string.h>
 #include <stdlib.h>
 #include "products.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_CATALOG
 
 #define CATALOG_SIZE 26
 
-#define INDEX(p) (p->str[0] - 'A')
+/* Número de produtos pretendido em cada índice do catálogo depois de carregado */
+#define SHARD_TARGET 1024
+
+#define VALID(str) ((str)[0] >= 'A' && (str)[0] <= 'Z')
 
 struct product{
 	char *str;
@@ -12,34 +18,94 @@ struct product{
 
 struct product_catalog {
 	CATALOG cat;
+	PERFECTHASH codes;   /* identificadores dos códigos, depois de balanceado */
+
+	/* Filtro dos códigos, construído ao balancear se filterRate for positiva */
+	BLOOM filter;
+	double filterRate;
+	long filterBytes;
 };
 
 PRODUCTCAT initProductCat(){
-	PRODUCTCAT productCat = malloc(sizeof(*productCat));
+	PRODUCTCAT productCat = MALLOC(sizeof(*productCat));
 
 	productCat->cat = initCatalog(CATALOG_SIZE, NULL, NULL);
+	productCat->codes = NULL;
+	productCat->filter = NULL;
+	productCat->filterRate = 0;
+	productCat->filterBytes = 0;
 
 	return productCat;
 }
 
 PRODUCTCAT insertProduct(PRODUCTCAT productCat, PRODUCT product) {
-	productCat->cat = insertCatalog(productCat->cat, INDEX(product), product->str, NULL);
+	productCat->cat = insertCatalog(productCat->cat, product->str, NULL);
+
+	/* Os identificadores deixam de corresponder ao catálogo até ser balanceado */
+	freePerfectHash(productCat->codes);
+	freeBloom(productCat->filter);
+	productCat->codes = NULL;
+	productCat->filter = NULL;
 
 	return productCat;
 }
 
 void freeProductCat(PRODUCTCAT productCat) {
 	freeCatalog(productCat->cat);
-	free(productCat);
+	freePerfectHash(productCat->codes);
+	freeBloom(productCat->filter);
+	FREE(productCat);
 }
 
 bool lookUpProduct(PRODUCTCAT productCat, PRODUCT product) {
-	if (INDEX(product) < 0 || INDEX(product) > 26) return false;
-	return lookUpCatalog(productCat->cat, INDEX(product), product->str);
+	return lookUpProductCode(productCat, product->str);
+}
+
+bool lookUpProductCode(PRODUCTCAT productCat, char* code) {
+	return getProductCodeId(productCat, code) >= 0;
+}
+
+int getProductCodeId(PRODUCTCAT productCat, char* code) {
+	if (!VALID(code)) return -1;
+
+	/* A maior parte dos códigos inexistentes é rejeitada com uma só linha de cache */
+	if (productCat->filter && !lookUpBloom(productCat->filter, code)) return -1;
+
+	if (productCat->codes)
+		return getPerfectHashId(productCat->codes, code);
+
+	return lookUpCatalog(productCat->cat, code) ? rankCatalog(productCat->cat, code) : -1;
 }
 
 int countProducts(PRODUCTCAT productCat, char index) {
-	return countPosElems(productCat->cat, index-'A');
+	char prefix[2];
+
+	prefix[0] = index;
+	prefix[1] = '\0';
+
+	return countPrefixElems(productCat->cat, prefix);
+}
+
+PRODUCTCAT balanceProductCat(PRODUCTCAT productCat) {
+	productCat->cat = balanceCatalog(productCat->cat, SHARD_TARGET);
+
+	freePerfectHash(productCat->codes);
+	productCat->codes = perfectHashCatalog(productCat->cat);
+
+	return setProductCatFilter(productCat, productCat->filterRate, productCat->filterBytes);
+}
+
+PRODUCTCAT setProductCatFilter(PRODUCTCAT productCat, double fpRate, long budget) {
+	productCat->filterRate = fpRate;
+	productCat->filterBytes = budget;
+
+	freeBloom(productCat->filter);
+	productCat->filter = NULL;
+
+	if (fpRate > 0 && !isEmptyCatalog(productCat->cat))
+		productCat->filter = bloomCatalog(productCat->cat, fpRate, budget);
+
+	return productCat;
 }
 
 bool isEmptyProductCat (PRODUCTCAT prodCatalog) {
@@ -51,7 +117,7 @@ CATALOG getProductCat (PRODUCTCAT productCat) {
 }
 
 PRODUCT newProduct() {
-	PRODUCT new = malloc(sizeof(struct product));
+	PRODUCT new = MALLOC(sizeof(struct product));
 	new->str = NULL;
 	
 	return new;
@@ -59,9 +125,9 @@ PRODUCT newProduct() {
 
 PRODUCT changeProductCode(PRODUCT product, char* str) {
 	if (product->str)
-		free(product->str);
+		FREE(product->str);
 
-	product->str = malloc(sizeof(char) * strlen(str) + 1);
+	product->str = MALLOC(sizeof(char) * strlen(str) + 1);
 	strcpy(product->str, str);
 
 	return product;
@@ -70,8 +136,8 @@ PRODUCT changeProductCode(PRODUCT product, char* str) {
 PRODUCT toProduct(char *str) {
 	PRODUCT new;
 
-	new = malloc(sizeof(*new));
-	new->str = malloc(sizeof(char) * strlen(str) + 1);
+	new = MALLOC(sizeof(*new));
+	new->str = MALLOC(sizeof(char) * strlen(str) + 1);
 
 	strcpy(new->str, str);
 
@@ -81,8 +147,8 @@ PRODUCT toProduct(char *str) {
 PRODUCT cloneProduct(PRODUCT product) {
 	PRODUCT new;
 
-	new = malloc(sizeof(*new));
-	new->str = malloc(sizeof(char) * strlen(product->str) + 1);
+	new = MALLOC(sizeof(*new));
+	new->str = MALLOC(sizeof(char) * strlen(product->str) + 1);
 
 	strcpy(new->str, product->str);
 
@@ -90,7 +156,7 @@ PRODUCT cloneProduct(PRODUCT product) {
 }
 
 char* fromProduct(PRODUCT product) {
-	char *str = malloc(sizeof(char) * strlen(product->str) + 1);
+	char *str = MALLOC(sizeof(char) * strlen(product->str) + 1);
 	strcpy(str, product->str);
 
 	return str;
@@ -102,15 +168,27 @@ bool isEmptyProduct(PRODUCT p) {
 
 void freeProduct(PRODUCT product) {
 	if (product->str)
-		free(product->str);
+		FREE(product->str);
+
+	FREE(product);
+}
 
-	free(product);
+CURSOR getProductCursor(PRODUCTCAT productCat, char* prefix) {
+	return initPrefixCursor(productCat->cat, prefix);
+}
+
+bool scanProductsByPrefix(PRODUCTCAT productCat, char* prefix, visit_t visit, void* arg) {
+	return prefixScanCatalog(productCat->cat, prefix, visit, arg);
 }
 
 SET fillProductSet(PRODUCTCAT productCat, char index) {
 	SET set = initSet(countAllElems(productCat->cat), NULL);
+	char prefix[2];
+
+	prefix[0] = index;
+	prefix[1] = '\0';
 
-	set = fillSet(productCat->cat, set, index - 'A');
+	set = fillPrefixSet(productCat->cat, set, prefix);
 
 	return set;
 }
@@ -19,6 +19,21 @@ PRODUCTCAT initProductCat ();
  */
 PRODUCTCAT insertProduct (PRODUCTCAT catalog, PRODUCT product);
 
+/**
+ * Redistribui os produtos pelos índices do catálogo de acordo com os códigos já
+ * inseridos, para que nenhum índice fique demasiado grande (ver balanceCatalog).
+ */
+PRODUCTCAT balanceProductCat (PRODUCTCAT catalog);
+
+/**
+ * Configura o filtro de Bloom consultado por getProductCodeId antes do catálogo, que é
+ * construído sempre que o catálogo é balanceado. Se o catálogo não estiver vazio, o
+ * filtro é construído logo.
+ * @param fpRate Taxa de falsos positivos pretendida, ou 0 para não usar filtro
+ * @param budget Número máximo de bytes do filtro, ou 0 para não haver limite
+ */
+PRODUCTCAT setProductCatFilter (PRODUCTCAT catalog, double fpRate, long budget);
+
 /**
  * Liberta todo o espaço ocupado por um catálogo de produtos.
  */
@@ -29,6 +44,19 @@ void freeProductCat (PRODUCTCAT catalog);
  */
 bool lookUpProduct (PRODUCTCAT catalog, PRODUCT product);
 
+/**
+ * Verifica se o código dado é de um produto do catálogo, sem o copiar.
+ */
+bool lookUpProductCode (PRODUCTCAT catalog, char* code);
+
+/**
+ * Determina o identificador denso de um código do catálogo, isto é, a sua posição por
+ * ordem do catálogo. Depois de o catálogo ser balanceado, basta uma hash e uma
+ * comparação.
+ * @return O identificador, ou -1 se o código não existir no catálogo
+ */
+int getProductCodeId (PRODUCTCAT catalog, char* code);
+
 /**
  * Calcula o número de produtos começados por uma dada letra existentes no catálogo.
  */
@@ -86,4 +114,20 @@ void freeProduct (PRODUCT p);
  */
 SET fillProductSet (PRODUCTCAT cat, char index);
 
+/**
+ * Cria um cursor sobre os produtos começados pelo prefixo dado, por ordem alfabética,
+ * que lê cada página diretamente do catálogo. O prefixo tem de começar por uma letra
+ * maiúscula.
+ */
+CURSOR getProductCursor (PRODUCTCAT cat, char* prefix);
+
+/**
+ * Visita, por ordem alfabética, os códigos dos produtos começados pelo prefixo dado,
+ * sem percorrer o resto do catálogo. O prefixo tem de começar por uma letra maiúscula.
+ * @param visit Função chamada com o código, NULL e arg; se devolver false o percurso
+ * termina
+ * @return false se o percurso foi terminado por visit
+ */
+bool scanProductsByPrefix (PRODUCTCAT cat, char* prefix, visit_t visit, void* arg);
+
 #endif
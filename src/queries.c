@@ -4,13 +4,27 @@
 #include "queries.h"
 #include <time.h>
 
-#include "set.h"
+#include "engine.h"
+#include "cache.h"
+#include "cursor.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_QUERIES
 
 #define UPPER(a) (('a' <= (a) && (a) <= 'z') ? ((a - 'a') + 'A') : (a))
 #define MAX_SIZE 128
-#define BRANCHES 3
 #define NP 2
 #define LINE_NUMS 20
+#define LINE_SIZE (MAX_SIZE + MAX_BRANCHES * 32)
+
+/* Posição e número de produtos de cada filial no resultado da query 10 */
+struct ranks {
+	int branches;
+	int starts[MAX_BRANCHES];
+	int sizes[MAX_BRANCHES];
+};
+
+typedef void (*format_t)(char* line, RESULT r, int row, void* arg);
 
 struct page{
 	char* header;
@@ -24,58 +38,58 @@ struct page{
 
 static PAGE createPage(char* header, int linesNum,int page, int totalPage);
 static PAGE addLineToPage(PAGE p, char* line);
-static PAGE getPage(PAGE p, SET lines); 
+static PAGE getResultPage(PAGE p, RESULT rows, format_t format, void* arg);
+static void presentCursor(char* title, char* header, CURSOR c, format_t format, void* arg);
+static void presentResult(char* title, char* header, RESULT r, int first, int rows,
+                          format_t format, void* arg);
+static RESULT rankTable(RESULT r, struct ranks* ranks, int size);
 static PAGE resetReadPage(PAGE page); 
 static int presentList(char* title, PAGE page, char* onav);
 static void printHelp();
 static void freePage(PAGE p);
+static void formatCode(char* line, RESULT r, int row, int* col);
+static void formatRank(char* line, RESULT r, int rank, int* branches);
 
 static int askClientMode(int n, int p); 
 static CLIENT askClient(CLIENTCAT ccat); 
 static PRODUCT askProduct(PRODUCTCAT pcat);
 static int askMode();
-static int askBranch();
-static int askBranchPrev(int p1, int p2, int p3);
+static int askBranch(int branches);
+static int askBranchPrev(int* sizes, int branches);
 static int askMonth();
 static int askMonthRange(int* begin, int* end);
 
 void query2(PRODUCTCAT pcat) {
-	PAGE page;
-	SET s;
+	CURSOR c;
 	char aux[MAX_SIZE], title[MAX_SIZE];
-	int size, newPage;
 
 	do {
-		printf("Letra: ");
+		printf("Letra ou prefixo: ");
 		fgets(aux, MAX_SIZE, stdin);
 		if (aux[0] == 'q') return;
 	} while(aux[0] < 'A' || aux[0] > 'Z');
 
-	s = fillProductSet(pcat, aux[0]);
+	strtok(aux, "\n\r");
 
-	size = getSetSize(s);
-	size = size / LINE_NUMS + ((size % LINE_NUMS != 0) ? 1 : 0);
+	/* As páginas são lidas diretamente do catálogo, pelo que não é preciso guardá-las */
+	c = getProductCursor(pcat, aux);
 
-	sprintf(title, "Query 2  ➤  Produtos com a letra %c (%d).", aux[0], getSetSize(s));
-	strcpy(aux, "\n");
-	newPage = 1;
-	while(newPage != -1) {
-		page = createPage("",LINE_NUMS, newPage, size);
-		page = getPage(page, s);
-		newPage = presentList(title, page, aux);
-		freePage(page);
-	}
+	if (aux[1])
+		sprintf(title, "Query 2  ➤  Produtos começados por %.32s (%d).", aux, getCursorSize(c));
+	else
+		sprintf(title, "Query 2  ➤  Produtos com a letra %c (%d).", aux[0], getCursorSize(c));
+	presentCursor(title, "", c, (format_t) formatCode, NULL);
 
-	freeSet(s);
+	freeCursor(c);
 }
 
-void query3(FATGLOBAL fat, PRODUCTCAT pcat) {
+void query3(CACHE cache, FATGLOBAL fat, PRODUCTCAT pcat) {
 	PAGE page;
 	PRODUCT product;
-	PRODUCTFAT pfat;
-	char answ[MAX_SIZE], oldCmd[MAX_SIZE], *pstr;
-	int i, month, mode, newPage=1, quantAux[NP], quantT[NP], qtt[BRANCHES][NP];
-	double billedAux[NP], billedT[NP], billed[BRANCHES][NP];
+	RESULT r;
+	char answ[LINE_SIZE], oldCmd[MAX_SIZE], key[MAX_SIZE], *pstr;
+	int i, len, branches, month, mode, newPage=1, quantT[NP];
+	double billedT[NP];
 
 	product = askProduct(pcat);
 	if (!product) return;
@@ -84,7 +98,11 @@ void query3(FATGLOBAL fat, PRODUCTCAT pcat) {
 	month = askMonth();
 	if (month == -1) {freeProduct(product); return;}
 
-	pfat = getProductDataByMonth(fat, product, month);
+	pstr = fromProduct(product);	
+	sprintf(key, "q3 %s %d", pstr, month);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getProductRevenue(fat, pcat, product, month));
+	branches = getResultRows(r);
 
 	if (mode == 1) {
 		quantT[0] = 0;
@@ -94,13 +112,11 @@ void query3(FATGLOBAL fat, PRODUCTCAT pcat) {
 
 		page = createPage("\t\t\tNORMAL\t\tPROMOÇÃO", 2, 1,1);
 
-		for (i=0; i < BRANCHES; i++) {
-			getProductFatSales(pfat, i, &quantAux[0], &quantAux[1]);
-	   		getProductFatBilled(pfat, i, &billedAux[0], &billedAux[1]);
-			quantT[0] += quantAux[0];
-			quantT[1] += quantAux[1];
-			billedT[0] += billedAux[0];
-			billedT[1] += billedAux[1];
+		for (i=0; i < branches; i++) {
+			quantT[0] += getResultInt(r, i, 1);
+			quantT[1] += getResultInt(r, i, 2);
+			billedT[0] += getResultDouble(r, i, 3);
+			billedT[1] += getResultDouble(r, i, 4);
 		}
 		sprintf(answ, "Total de Vendas:\t%3d\t\t%3d", quantT[0], quantT[1]);
 		page = addLineToPage(page, answ);
@@ -108,109 +124,121 @@ void query3(FATGLOBAL fat, PRODUCTCAT pcat) {
 		page = addLineToPage(page, answ);
 
 	} else {
-		page = createPage("\t\tFilial 1\tFilial 2\tFilial 3", 5, 1,1);
+		len = sprintf(answ, "\t");
+		for(i=0; i < branches; i++)
+			len += sprintf(answ + len, "\tFilial %d", i+1);
 
-		for(i=0; i < BRANCHES; i++) {
-			getProductFatSales(pfat, i, &qtt[i][0], &qtt[i][1]);
-			getProductFatBilled(pfat, i, &billed[i][0], &billed[i][1]);
-		}
+		page = createPage(answ, 5, 1,1);
 
-		sprintf(answ, "Vendas N\t %d\t\t %d\t\t %d", qtt[0][0], qtt[1][0], qtt[2][0]);
+		len = sprintf(answ, "Vendas N");
+		for(i=0; i < branches; i++)
+			len += sprintf(answ + len, (i) ? "\t\t %d" : "\t %d", getResultInt(r, i, 1));
 		page = addLineToPage(page, answ);
 
-		sprintf(answ, "Vendas P\t %d\t\t %d\t\t %d", qtt[0][1], qtt[1][1], qtt[2][1]);
+		len = sprintf(answ, "Vendas P");
+		for(i=0; i < branches; i++)
+			len += sprintf(answ + len, (i) ? "\t\t %d" : "\t %d", getResultInt(r, i, 2));
 		page = addLineToPage(page, answ);
 
 
 		page = addLineToPage(page, "");
 
 
-		sprintf(answ, "Faturado N\t %6.2f\t %6.2f\t %6.2f", 
-								billed[0][0], billed[1][0], billed[2][0]);
+		len = sprintf(answ, "Faturado N");
+		for(i=0; i < branches; i++)
+			len += sprintf(answ + len, "\t %6.2f", getResultDouble(r, i, 3));
 		page = addLineToPage(page, answ);
 
-		sprintf(answ, "Faturado P\t %6.2f\t %6.2f\t %6.2f",
-			   					billed[0][1], billed[1][1], billed[2][1]);
+		len = sprintf(answ, "Faturado P");
+		for(i=0; i < branches; i++)
+			len += sprintf(answ + len, "\t %6.2f", getResultDouble(r, i, 4));
 		page = addLineToPage(page, answ);
 	}
 	
-	pstr = fromProduct(product);	
 	sprintf(answ, "Query 3  ➤  Receita de %s no mês %d", pstr, month+1);
 	strcpy(oldCmd, "\n");
 	while (newPage != -1)
 		newPage = presentList(answ, page, oldCmd);
 
-	free(pstr);
+	FREE(pstr);
 	freeProduct(product);
-	freeProductFat(pfat);
+	freeResult(r);
 	freePage(page);
 }
 
-void query4(FATGLOBAL fat) {
-	PAGE page;
-	SET *pgroupB, pgroup;
-	char oldCmd[MAX_SIZE], title[MAX_SIZE];
-	int mode, size, sizes[BRANCHES], newPage;
+void query4(CACHE cache, FATGLOBAL fat) {
+	RESULT r;
+	char title[MAX_SIZE], key[MAX_SIZE];
+	int i, mode, branches, col = 1, sizes[MAX_BRANCHES], starts[MAX_BRANCHES];
 
 	mode = askMode();
 	if (mode == -1) return;
 
-
 	if (mode == 1) {
-		pgroup = getProductsNotSold(fat);
-		size  = getSetSize(pgroup);
-		sprintf(title, "Query 4  ➤  Produtos não comprados (%d).", size);
-	} else {
-		pgroupB = getProductsNotSoldByBranch(fat);
-
-		sizes[0] = getSetSize(pgroupB[0]);
-		sizes[1] = getSetSize(pgroupB[1]);
-		sizes[2] = getSetSize(pgroupB[2]);
+		strcpy(key, "q4");
+		if (!(r = getCachedResult(cache, key)))
+			r = cacheResult(cache, key, getUnsoldProducts(fat, -1));
+		sprintf(title, "Query 4  ➤  Produtos não comprados (%d).", getResultRows(r));
+		presentResult(title, "", r, 0, getResultRows(r), (format_t) formatCode, NULL);
+		freeResult(r);
+		return;
+	}
 
-		mode = askBranchPrev(sizes[0], sizes[1], sizes[2]);
-		
-		if (mode == -1)	return;
+	strcpy(key, "q4 filiais");
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getUnsoldProductsByBranch(fat));
+	branches = getFatBranches(fat);
 
-		size =  sizes[mode];
-		pgroup = pgroupB[mode];
-		sprintf(title, "Query 4  ➤  Produtos não comprados da filial %d (%d).", mode+1, size);
+	for(i = 0; i < branches; i++)
+		sizes[i] = starts[i] = 0;
+	for(i = getResultRows(r) - 1; i >= 0; i--) {
+		sizes[getResultInt(r, i, 0) - 1]++;
+		starts[getResultInt(r, i, 0) - 1] = i;
 	}
 
-	size = size / LINE_NUMS + ((size % LINE_NUMS != 0) ? 1 : 0);
-	strcpy(oldCmd, "\n");
-	newPage=1;
-	while(newPage != -1) {
-		page = createPage("", LINE_NUMS, newPage, size);
-		page = getPage(page, pgroup);
-		if (page) newPage = presentList(title, page, oldCmd);
-		else newPage = -1;
-		freePage(page);
+	mode = askBranchPrev(sizes, branches);
+
+	if (mode != -1) {
+		sprintf(title, "Query 4  ➤  Produtos não comprados da filial %d (%d).", mode+1, 
+		                                                                   sizes[mode]);
+		presentResult(title, "", r, starts[mode], sizes[mode], (format_t) formatCode, &col);
 	}
 
-	freeSet(pgroup);
+	freeResult(r);
 }
 
-void query5(BRANCHSALES* bs, CLIENTCAT ccat) {
+void query5(CACHE cache, SALESINDEX si, CLIENTCAT ccat) {
 	CLIENT client;
 	PAGE page;
-	char str[MAX_SIZE], title[MAX_SIZE], *cstr;
-	int *quantity1, *quantity2, *quantity3, i, newPage;
+	RESULT r;
+	char str[LINE_SIZE], title[MAX_SIZE], key[MAX_SIZE], *cstr;
+	int i, len, branch, branches, newPage;
 
 	client = askClient(ccat);
 	if (!client) return;
 
-	quantity1 = getClientQuantByMonth(bs[0], client);
-	quantity2 = getClientQuantByMonth(bs[1], client);
-	quantity3 = getClientQuantByMonth(bs[2], client);
+	cstr = fromClient(client);
+	sprintf(key, "q5 %s", cstr);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getClientMonthlyQuant(si, client));
+	if (!r) {FREE(cstr); freeClient(client); return;}
+
+	branches = getResultCols(r) - 1;
+
+	len = sprintf(str, "\tMÊS");
+	for(branch = 0; branch < branches; branch++)
+		len += sprintf(str + len, "\tFILIAL %d", branch+1);
 
-	page = createPage("\tMÊS\tFILIAL 1\tFILIAL 2\tFILIAL 3", 12, 1, 1);
+	page = createPage(str, 12, 1, 1);
 
-	for(i=0; i < 12; i++) {
-		sprintf(str, "\t%2d\t  %3d\t\t  %3d\t\t  %3d", i+1, quantity1[i], quantity2[i], quantity3[i]);
+	for(i=0; i < getResultRows(r); i++) {
+		len = sprintf(str, "\t%2d", getResultInt(r, i, 0));
+		for(branch = 0; branch < branches; branch++)
+			len += sprintf(str + len, (branch) ? "\t\t  %3d" : "\t  %3d",
+			                                    getResultInt(r, i, branch+1));
 		page = addLineToPage(page, str);
 	}
 
-	cstr = fromClient(client);
 	sprintf(title, "Query 5  ➤  Gastos de %s", cstr);
 	strcpy(str, "\n");
 	newPage = 1;
@@ -220,29 +248,29 @@ void query5(BRANCHSALES* bs, CLIENTCAT ccat) {
 
 	freePage(page);
 	freeClient(client);
-	free(quantity1); 
-	free(quantity2); 
-	free(quantity3); 
-	free(cstr);
+	freeResult(r);
+	FREE(cstr);
 }
 
-void query6(FATGLOBAL fat) {
+void query6(CACHE cache, FATGLOBAL fat) {
 	PAGE page;
-	double billed;
-	int sales, init, final, newPage;
-	char buff[MAX_SIZE], title[MAX_SIZE];
+	RESULT r;
+	int init, final, newPage;
+	char buff[MAX_SIZE], title[MAX_SIZE], key[MAX_SIZE];
 
 	newPage = askMonthRange(&init, &final);
 	if (newPage == -1) return;
 
 	page = createPage("", 2, 1, 1);
 
-	sales  = getSalesByMonthRange(fat, init, final);
-	billed = getBilledByMonthRange(fat, init, final);
-	sprintf(buff, "Vendas:\t%d", sales);
+	sprintf(key, "q6 %d %d", init, final);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getSalesInMonthRange(fat, init, final));
+	sprintf(buff, "Vendas:\t%d", getResultInt(r, 0, 0));
 	page = addLineToPage(page, buff);
-	sprintf(buff, "Faturado:\t%.2f", billed);
+	sprintf(buff, "Faturado:\t%.2f", getResultDouble(r, 0, 1));
 	page = addLineToPage(page, buff);
+	freeResult(r);
 	
 	sprintf(title, "Query 6  ➤  Vendas entre %d e %d", init+1, final+1);
 	strcpy(buff, "\n");
@@ -254,84 +282,57 @@ void query6(FATGLOBAL fat) {
 	freePage(page);
 }
 
-void query7(BRANCHSALES* bs) {
-	PAGE page;
-	SET setB[BRANCHES], tSet, auxSet;
-	char ocmd[MAX_SIZE], title[MAX_SIZE];
-	int i, size;
-
-
-
-	setB[0] = getClientsWhoBought(bs[0]);
-	setB[1] = getClientsWhoBought(bs[1]);
-	setB[2] = getClientsWhoBought(bs[2]);
-
-	auxSet = intersectSet(setB[0], setB[1]);
-	tSet   = intersectSet(auxSet, setB[2]);
+void query7(CACHE cache, SALESINDEX si) {
+	RESULT r;
+	char title[MAX_SIZE], key[MAX_SIZE];
 
+	strcpy(key, "q7");
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getLoyalClients(si));
 	
-	size = getSetSize(tSet);
-	sprintf(title, "Query 7  ➤  Clientes que compram em todas as filiais (%d).", size);
-	size = size / LINE_NUMS + ((size % LINE_NUMS != 0) ? 1 : 0);
-	strcpy(ocmd, "\n");
-	i = 1;
-	while(i != -1) {
-		page = createPage("", LINE_NUMS, i, size);
-		page = getPage(page, tSet);
-		i    = presentList(title, page, ocmd);
-		freePage(page);
-	}
+	sprintf(title, "Query 7  ➤  Clientes que compram em todas as filiais (%d).", 
+	                                                            getResultRows(r));
+	presentResult(title, "", r, 0, getResultRows(r), (format_t) formatCode, NULL);
 
-	for(i = 0; i < BRANCHES; i++)
-		freeSet(setB[i]);
-	freeSet(auxSet);
-	freeSet(tSet);
+	freeResult(r);
 }
 
-void query8(BRANCHSALES* bs, PRODUCTCAT pcat) {
-	PAGE page;
-	SET n, p, toPrint;
+void query8(CACHE cache, SALESINDEX si, PRODUCTCAT pcat) {
 	PRODUCT product;
-	char buff[MAX_SIZE], title[MAX_SIZE], *pstr;
-	int branch, mode, newPage, size;
+	RESULT r;
+	char title[MAX_SIZE], key[MAX_SIZE], *pstr;
+	int branch, mode, n;
 	
 	product = askProduct(pcat);
 	if (!product) return;
-	branch = askBranch();
+	branch = askBranch(getSalesIndexBranches(si));
 	if (branch == -1) {freeProduct(product); return;} 
 
-	getClientsByProduct(bs[branch], product, &n, &p);
-	
-	mode = askClientMode(getSetSize(n), getSetSize(p));
-	if (mode == -1) {freeProduct(product); freeSet(n); freeSet(p); return; }
+	pstr = fromProduct(product);
+	sprintf(key, "q8 %s %d", pstr, branch);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getProductBuyers(si, pcat, product, branch));
 
-	toPrint = (mode == 1) ? n : p;
-	size = getSetSize(toPrint);
-	size = size / LINE_NUMS + ((size % LINE_NUMS != 0) ? 1 : 0);
+	for(n = 0; n < getResultRows(r) && getResultCode(r, n, 1)[0] == 'N'; n++);
+	
+	mode = askClientMode(n, getResultRows(r) - n);
 
-	pstr = fromProduct(product);
-	sprintf(title, "Query 8  ➤  Clientes que compraram %s na filial %d", pstr, branch+1);
-	newPage = 1;
-	while (newPage != -1) {
-		page = createPage("", LINE_NUMS, newPage, size); 
-		page = getPage(page, toPrint);	
-		if (page) newPage = presentList(title, page, buff);
-		else newPage = -1;
-		freePage(page);
+	if (mode != -1) {
+		sprintf(title, "Query 8  ➤  Clientes que compraram %s na filial %d", pstr, branch+1);
+		if (mode == 1) presentResult(title, "", r, 0, n, (format_t) formatCode, NULL);
+		else presentResult(title, "", r, n, getResultRows(r) - n, (format_t) formatCode, NULL);
 	}
 
-	free(pstr);
-	freeSet(n);
-	freeSet(p);
+	FREE(pstr);
+	freeResult(r);
 	freeProduct(product);
 }
 
-void query9(BRANCHSALES* bs, CLIENTCAT ccat) {
-	PAGE page;
-	SET setB[BRANCHES], setT, auxSet, toPrint;
+void query9(CACHE cache, SALESINDEX si, CLIENTCAT ccat) {
 	CLIENT client;
-	int i, month, newPage, size;
-	char ocmd[MAX_SIZE], title[MAX_SIZE], *line, *cstr;
+	RESULT r;
+	int month;
+	char title[MAX_SIZE], key[MAX_SIZE], *cstr;
 
 
 	client = askClient(ccat);
@@ -339,53 +340,26 @@ void query9(BRANCHSALES* bs, CLIENTCAT ccat) {
 	month  = askMonth();
 	if (month == -1) {freeClient(client); return;} 
 	
-	setB[0] = getProductsByClient(bs[0], client);
-	setB[1] = getProductsByClient(bs[1], client);
-	setB[2] = getProductsByClient(bs[2], client);
-	
-	auxSet = unionSets(setB[0], setB[1]);
-	setT   = unionSets(auxSet, setB[2]);
-
-	sortProductListByQuant(setT, month);
-
-	size = getSetSize(setT);
-
-	toPrint = initSet(size, NULL);
-	for(i = 0; getClientSetQuantByMonth(setT, i, month) != 0; i++) {
-		line    = getSetHash(setT, i);
-		toPrint = insertElement(toPrint, line, NULL);
-		free(line);
-	}
-
-	size = getSetSize(toPrint);
-
 	cstr = fromClient(client);
-	sprintf(title, "Query 9  ➤  %d produtos mais comprado por %s no mês %d", size, cstr, month+1);	
-	size = size / LINE_NUMS + ((size % LINE_NUMS != 0) ? 1 : 0);
+	sprintf(key, "q9 %s %d", cstr, month);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getClientFavourites(si, client, month));
+	if (!r) {FREE(cstr); freeClient(client); return;}
 
-	strcpy(ocmd, "\n");
-	newPage = 1;
-	while (newPage != -1) {
-		page = createPage("", LINE_NUMS, newPage, size);
-		page = getPage(page, toPrint);
-		newPage = presentList(title, page, ocmd);
-		freePage(page);
-	}
+	sprintf(title, "Query 9  ➤  %d produtos mais comprado por %s no mês %d", 
+	                                        getResultRows(r), cstr, month+1);	
+	presentResult(title, "", r, 0, getResultRows(r), (format_t) formatCode, NULL);
 
-	free(cstr);
+	FREE(cstr);
 	freeClient(client);
-	freeSet(auxSet);
-	freeSet(setT);
-	freeSet(toPrint);
+	freeResult(r);
 }
 
-void query10(BRANCHSALES* bs) {
-	PAGE page;
-	PRODUCTDATA pdata;
-	SET s[BRANCHES], l;
-	char buff[MAX_SIZE], title[MAX_SIZE], *product;
-	char header[]="\t\t\tFILIAL 1\t\tFILIAL 2\t\tFILIAL 3\n\t\t\t PRODUTO C   Q\t|  PRODUTO\t C   Q\t|  PRODUTO\t C   Q";
-	int i, j, n=0, size, nClients, nQuant;
+void query10(CACHE cache, SALESINDEX si) {
+	RESULT r, table;
+	struct ranks ranks;
+	char buff[LINE_SIZE], header[LINE_SIZE], title[MAX_SIZE], key[MAX_SIZE];
+	int i, j, n=0, len, size, branch;
 
 	while(n <= 0) {
 		printf("Número de produtos: ");
@@ -394,106 +368,90 @@ void query10(BRANCHSALES* bs) {
 		if (buff[0] == '\n') return;
 	}
 
-	s[0] = listProductsByQuant(bs[0]);
-	s[1] = listProductsByQuant(bs[1]);
-	s[2] = listProductsByQuant(bs[2]);
+	sprintf(key, "q10 %d", n);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getTopProducts(si, n));
 
+	ranks.branches = getSalesIndexBranches(si);
+	for (j = 0; j < ranks.branches; j++)
+		ranks.starts[j] = ranks.sizes[j] = 0;
 
-	size = getSetSize(s[0]);
-	size = (size > getSetSize(s[1])) ? size : getSetSize(s[1]);
-	size = (size > getSetSize(s[2])) ? size : getSetSize(s[2]);
-
+	for (i = getResultRows(r) - 1; i >= 0; i--) {
+		branch = getResultInt(r, i, 0) - 1;
+		ranks.sizes[branch]++;
+		ranks.starts[branch] = i;
+	}
 
-	n = (n > size) ? size : n;
+	size = 0;
+	for (j = 0; j < ranks.branches; j++)
+		size = (size > ranks.sizes[j]) ? size : ranks.sizes[j];
 
-	l = initSet(n, NULL);
+	len = sprintf(header, "\t");
+	for (j = 0; j < ranks.branches; j++)
+		len += sprintf(header + len, "\t\tFILIAL %d\t", j+1);
+	len += sprintf(header + len, "\n\t\t");
+	for (j = 0; j < ranks.branches; j++)
+		len += sprintf(header + len, "%s PRODUTO\t C   Q\t", (j) ? "|" : "");
 
-	for(i = 0; i < n; i++) {
-		sprintf(buff, "%5dº  ", i+1);
-		for (j = 0; j < BRANCHES; j++) {
-			product  = getSetHash(s[j], i);
-			if (!product) { sprintf(buff, "%s\t\t", buff); 	continue;}
-			pdata    = getSetData(s[j], i);
-			nClients = getClientsFromData(pdata);
-			nQuant   = getQuantFromData(pdata);
-			
-			sprintf(buff, "%s\t%s %3d %6d", buff, product, nClients, nQuant);
-			free(product);
-		}
-		l = insertElement(l, buff, NULL);
-	}
+	table = rankTable(r, &ranks, size);
 
-	size = n / LINE_NUMS + ((n % LINE_NUMS != 0) ? 1 : 0);
+	sprintf(title, "Query 10  ➤  %d produtos mais vendidos em todo o ano.", size);	
+	presentResult(title, header, table, 0, size, (format_t) formatRank, &ranks.branches);
 
-	sprintf(title, "Query 10  ➤  %d produtos mais vendidos em todo o ano.", n);	
-	i = 1;	
-	while(i != -1) {
-		page = createPage(header, LINE_NUMS, i, size);
-		page = getPage(page, l);		
-		i = presentList(title, page, buff);	
-		freePage(page);
-	}
+	freeResult(table);
+	freeResult(r);
 }
 
-void query11 (BRANCHSALES* bs, CLIENTCAT ccat) {
+void query11 (CACHE cache, SALESINDEX si, CLIENTCAT ccat) {
 	PAGE page;
-	SET setB[3], setT, auxSet;
 	CLIENT client;
+	RESULT r;
 	int i;
-	char line[MAX_SIZE], title[MAX_SIZE], *product, *cstr;
-	double costs;
+	char line[MAX_SIZE], title[MAX_SIZE], key[MAX_SIZE], *cstr;
 
 
 	client = askClient(ccat);
 	if (!client) return;
 
-	setB[0] = getProductsByClient(bs[0], client);
-	setB[1] = getProductsByClient(bs[1], client);
-	setB[2] = getProductsByClient(bs[2], client);
-
-	auxSet = unionSets(setB[0], setB[1]);
-	setT   = unionSets(auxSet, setB[2]);
-	
-	sortProductListByBilled(setT);
+	cstr = fromClient(client);
+	sprintf(key, "q11 %s", cstr);
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getClientTopSpending(si, client, 3));
+	if (!r) {FREE(cstr); freeClient(client); return;}
 	
 	page = createPage("\tPRODUTO\t\tGASTOS\n", 3, 1, 1);
-	for(i = 0; i < 3; i++) {
-		product = getSetHash(setT, i);
-		costs = getClientCosts(setT, i);
-		sprintf(line, "\t%s\t\t%6.2f", product, costs );
+	for(i = 0; i < getResultRows(r); i++) {
+		sprintf(line, "\t%s\t\t%6.2f", getResultCode(r, i, 0), getResultDouble(r, i, 1));
 		page = addLineToPage(page, line);
-		free(product);
 	}
 
-	cstr = fromClient(client);
 	sprintf(title, "Query 11  ➤  3 produtos em que %s mais gastou dinheiro.", cstr);
 	strcpy(line, "\n");
 	i = 1;
 	while(i != -1) 	i = presentList(title, page, line);
 
 
+	FREE(cstr);
+	freeClient(client);
+	freeResult(r);
 	freePage(page);
 }
 
-void query12 (BRANCHSALES* bs, FATGLOBAL fat) {
+void query12 (CACHE cache, SALESINDEX si, FATGLOBAL fat) {
 	PAGE page;
-	SET clients[3], products, auxSet, clientTSet;
-	char line[MAX_SIZE], title[MAX_SIZE] ;
+	RESULT r;
+	char line[MAX_SIZE], title[MAX_SIZE], key[MAX_SIZE];
 	int i;
 
 
-	clients[0] = getClientsWhoHaveNotBought(bs[0]);
-	clients[1] = getClientsWhoHaveNotBought(bs[1]);
-	clients[2] = getClientsWhoHaveNotBought(bs[2]);
-	products   = getProductsNotSold(fat);
-
-	auxSet     = intersectSet(clients[0], clients[1]);
-	clientTSet = intersectSet(auxSet, clients[2]);
+	strcpy(key, "q12");
+	if (!(r = getCachedResult(cache, key)))
+		r = cacheResult(cache, key, getInactiveCounts(si, fat));
 
 	page = createPage("", 2, 1, 1);
-	sprintf(line,"Nº de clientes sem compras:  %6d", getSetSize(clientTSet) );
+	sprintf(line,"Nº de clientes sem compras:  %6d", getResultInt(r, 0, 0));
 	page = addLineToPage(page, line);
-	sprintf(line,"Nº de produtos não vendidos: %6d", getSetSize(products) );
+	sprintf(line,"Nº de produtos não vendidos: %6d", getResultInt(r, 0, 1));
 	page = addLineToPage(page, line);
 
 	sprintf(title, "Query 12  ➤  Clientes sem compras e Produtos não vendidos.");
@@ -504,20 +462,16 @@ void query12 (BRANCHSALES* bs, FATGLOBAL fat) {
 
 	
 	freePage(page);
-	for(i = 0; i < BRANCHES; i++)
-		freeSet(clients[i]);
-	freeSet(products);
-	freeSet(auxSet);
-	freeSet(clientTSet);
+	freeResult(r);
 }
 
 	/*====================== FUNÇÕES DO PRINTSET ===================*/
 
 static PAGE createPage(char* header, int linesNum, int page, int totalPage) {
-	PAGE new = malloc (sizeof(*new));
+	PAGE new = MALLOC (sizeof(*new));
 
-	new->header 	= malloc((strlen(header) + 1) * sizeof(char));
-	new->list   	= calloc(linesNum, sizeof(char *));
+	new->header 	= MALLOC((strlen(header) + 1) * sizeof(char));
+	new->list   	= CALLOC(linesNum, sizeof(char *));
 	new->linesNum 	= linesNum;
 	new->page   	= page;
 	new->totalPages = totalPage;
@@ -529,27 +483,115 @@ static PAGE createPage(char* header, int linesNum, int page, int totalPage) {
 	return new;
 }
 
-static PAGE getPage(PAGE p, SET lines) {
-	int i, index;
-	char str[MAX_SIZE], *line = NULL;
-
-	index = (p->page-1) * p->linesNum;
+/**
+ * Acrescenta à página as linhas lidas de um cursor, formatadas pela função dada.
+ */
+static PAGE getResultPage(PAGE p, RESULT rows, format_t format, void* arg) {
+	char line[LINE_SIZE];
+	int i;
 
-	for(i=0; i < p->linesNum; i++) {
-		line = getSetHash(lines, i + index);
-		sprintf(str, "\t%s", line);
-		if (line) addLineToPage(p,str);
-	   	free(line);
+	for(i = 0; i < p->linesNum && i < getResultRows(rows); i++) {
+		format(line, rows, i, arg);
+		addLineToPage(p, line);
 	}
 
 	return p;
 }
 
+/**
+ * Apresenta as linhas de um cursor página a página. Em cada página só são lidas e
+ * formatadas as linhas visíveis.
+ */
+static void presentCursor(char* title, char* header, CURSOR c, format_t format, void* arg) {
+	PAGE page;
+	RESULT rows;
+	char cmd[MAX_SIZE];
+	int newPage = 1, size = getCursorSize(c);
+	int pages = size / LINE_NUMS + ((size % LINE_NUMS != 0) ? 1 : 0);
+
+	strcpy(cmd, "\n");
+	while(newPage != -1) {
+		page = createPage(header, LINE_NUMS, newPage, pages);
+
+		c = seekCursor(c, (newPage - 1) * LINE_NUMS);
+		rows = readCursor(c, LINE_NUMS);
+		page = getResultPage(page, rows, format, arg);
+		freeResult(rows);
+
+		newPage = presentList(title, page, cmd);
+		freePage(page);
+	}
+}
+
+static void presentResult(char* title, char* header, RESULT r, int first, int rows,
+                          format_t format, void* arg) {
+	CURSOR c = initResultCursor(r, first, rows);
+
+	presentCursor(title, header, c, format, arg);
+	freeCursor(c);
+}
+
+/**
+ * Reorganiza o resultado da query 10 numa tabela com uma linha por posição, onde cada
+ * filial ocupa três colunas: produto, clientes e quantidade. Uma filial com menos
+ * produtos do que a posição fica com o código vazio.
+ */
+static RESULT rankTable(RESULT r, struct ranks* ranks, int size) {
+	RESULT table;
+	char types[1 + 3 * MAX_BRANCHES + 1];
+	int j, rank, row;
+
+	types[0] = COL_INT;
+	for(j = 0; j < ranks->branches; j++) {
+		types[1 + 3*j] = COL_CODE;
+		types[2 + 3*j] = COL_INT;
+		types[3 + 3*j] = COL_INT;
+	}
+	types[1 + 3 * ranks->branches] = '\0';
+
+	table = initResult(types);
+
+	for(rank = 0; rank < size; rank++) {
+		table = addResultRow(table);
+		table = setResultInt(table, 0, rank+1);
+
+		for(j = 0; j < ranks->branches; j++) {
+			if (rank >= ranks->sizes[j]) continue;
+
+			row = ranks->starts[j] + rank;
+			table = setResultCode(table, 1 + 3*j, getResultCode(r, row, 2));
+			table = setResultInt(table, 2 + 3*j, getResultInt(r, row, 3));
+			table = setResultInt(table, 3 + 3*j, getResultInt(r, row, 4));
+		}
+	}
+
+	return table;
+}
+
+static void formatCode(char* line, RESULT r, int row, int* col) {
+	sprintf(line, "\t%s", getResultCode(r, row, (col) ? *col : 0));
+}
+
+static void formatRank(char* line, RESULT r, int row, int* branches) {
+	char* code;
+	int j, len;
+
+	len = sprintf(line, "\t%5dº  ", getResultInt(r, row, 0));
+
+	for (j = 0; j < *branches; j++) {
+		code = getResultCode(r, row, 1 + 3*j);
+		if (!code[0]) { len += sprintf(line + len, "\t\t"); continue; }
+
+		len += sprintf(line + len, "\t%s %3d %6d", code, getResultInt(r, row, 2 + 3*j),
+		               getResultInt(r, row, 3 + 3*j));
+	}
+}
+
 static PAGE addLineToPage(PAGE p, char* line) {
 
 	if (p->writeH < p->linesNum - 1) {
 		p->writeH++;
-		p->list[p->writeH] = calloc(strlen(line) + 1, sizeof(char));
+		p->list[p->writeH] = CALLOC(strlen(line) + 1, sizeof(char));
 		strcpy(p->list[p->writeH], line);
 	}
 
@@ -563,7 +605,7 @@ static char* getNextLine(PAGE p) {
 		p->readH++;
 		original = p->list[p->readH];
 
-		line = malloc((strlen(original)+1) * sizeof(char));
+		line = MALLOC((strlen(original)+1) * sizeof(char));
 		strcpy(line, original);
 	}
 
@@ -579,12 +621,12 @@ static void freePage(PAGE p) {
 	int i;
 
 	if (p) {
-		free(p->header);
+		FREE(p->header);
 
 		for(i=0; i <= p->writeH; i++)
-			free(p->list[i]);
-		free(p->list);
-		free(p);
+			FREE(p->list[i]);
+		FREE(p->list);
+		FREE(p);
 	}
 }
 
@@ -612,7 +654,7 @@ static int presentList(char* title, PAGE p, char *ocmd) {
 		buff = getNextLine(p);
 		if(!buff) break; 
 		printf("  %s\n", buff);
-		free(buff);
+		FREE(buff);
 	}
 	p = resetReadPage(p);
 
@@ -659,35 +701,34 @@ static void printHelp() {
 /* ================ ASKS ===================== */
 
 /* devolve -1 se o utilizador sair */
-static int askBranch() {
+static int askBranch(int branches) {
 	char buff[MAX_SIZE];
 	int r=0;
 	
 	while(1) {
-		printf("  Filial(1-3): ");
+		printf("  Filial(1-%d): ", branches);
 		fgets(buff, MAX_SIZE, stdin);
 		r = atoi(buff);
-		if (buff[0] == 'q' || (r >= 1 && r <= 3)) break;
-		printf("A filial deve estar entre 1 e 3.\n");
+		if (buff[0] == 'q' || (r >= 1 && r <= branches)) break;
+		printf("A filial deve estar entre 1 e %d.\n", branches);
 	}
 
 	return r-1;
 }
 
-static int askBranchPrev(int p1, int p2, int p3) {
+static int askBranchPrev(int* sizes, int branches) {
 	char buff[MAX_SIZE];
-	int r=0;
+	int i, r=0;
 
 	printf("\n  ::::::::::::::::::::::::::::::\n");
-	printf("\t1• Filial 1 (%d)\n", p1);
-	printf("\t2• Filial 2 (%d)\n", p2);
-	printf("\t3• Filial 3 (%d)\n", p3);
+	for(i = 0; i < branches; i++)
+		printf("\t%d• Filial %d (%d)\n", i+1, i+1, sizes[i]);
 	printf("  ::::::::::::::::::::::::::::::\n");
 	do {
 		printf("  Escolha uma filial: ");
 		fgets(buff, MAX_SIZE, stdin);
 		r = atoi(buff);
-	} while(buff[0] != 'q' && (r < 1 || r > 3));
+	} while(buff[0] != 'q' && (r < 1 || r > branches));
 
 	return r-1;
 
@@ -3,20 +3,21 @@
 
 #include "interpreter.h"
 #include "fatglobal.h"
-#include "branchsales.h"
+#include "salesindex.h"
+#include "cache.h"
 
 typedef struct page *PAGE;
 
 void query2(PRODUCTCAT pcat);
-void query3(FATGLOBAL fat, PRODUCTCAT pcat);
-void query4(FATGLOBAL fat);
-void query5(BRANCHSALES* bs, CLIENTCAT ccat);
-void query6(FATGLOBAL fat);
-void query7(BRANCHSALES* bs); 
-void query8(BRANCHSALES* bs, PRODUCTCAT pcat);
-void query9(BRANCHSALES* bs, CLIENTCAT ccat); 
-void query10(BRANCHSALES* bs);
-void query11 (BRANCHSALES* bs, CLIENTCAT ccat); 
-void query12 (BRANCHSALES* bs, FATGLOBAL fat);
+void query3(CACHE cache, FATGLOBAL fat, PRODUCTCAT pcat);
+void query4(CACHE cache, FATGLOBAL fat);
+void query5(CACHE cache, SALESINDEX si, CLIENTCAT ccat);
+void query6(CACHE cache, FATGLOBAL fat);
+void query7(CACHE cache, SALESINDEX si); 
+void query8(CACHE cache, SALESINDEX si, PRODUCTCAT pcat);
+void query9(CACHE cache, SALESINDEX si, CLIENTCAT ccat); 
+void query10(CACHE cache, SALESINDEX si);
+void query11(CACHE cache, SALESINDEX si, CLIENTCAT ccat); 
+void query12(CACHE cache, SALESINDEX si, FATGLOBAL fat);
 
 #endif
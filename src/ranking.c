@@ -0,0 +1,108 @@
+#include <stdlib.h>
+
+#include "ranking.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_SALESINDEX
+
+#define QUANT(r, i) (r)->quant[(r)->order[i]]
+
+/*
+ * A classificação é um array de identificadores ordenado por quantidade decrescente,
+ * acompanhado da posição de cada identificador nesse array. Os elementos com a mesma
+ * quantidade formam um bloco contíguo; para subir um elemento basta trocá-lo com o
+ * primeiro elemento de cada bloco que ultrapassa.
+ */
+struct ranking {
+	int *order;
+	int *pos;
+	int *quant;
+	int size;
+	int used;
+};
+
+static int bucketHead(RANKING r, int last);
+static void swapRanking(RANKING r, int i, int j);
+
+RANKING initRanking(int size) {
+	RANKING new = MALLOC(sizeof(*new));
+	int i;
+
+	new->order = MALLOC(sizeof(int) * size);
+	new->pos   = MALLOC(sizeof(int) * size);
+	new->quant = CALLOC(size, sizeof(int));
+	new->size  = size;
+	new->used  = 0;
+
+	for(i = 0; i < size; i++)
+		new->order[i] = new->pos[i] = i;
+
+	return new;
+}
+
+RANKING addToRanking(RANKING r, int id, int quant) {
+	int p, head;
+
+	if (quant <= 0 || id < 0 || id >= r->size)
+		return r;
+
+	if (r->quant[id] == 0) r->used++;
+	r->quant[id] += quant;
+
+	p = r->pos[id];
+
+	while(p > 0 && QUANT(r, p-1) < r->quant[id]) {
+		head = bucketHead(r, p-1);
+		swapRanking(r, head, p);
+		p = head;
+	}
+
+	return r;
+}
+
+int getRankingSize(RANKING r) {
+	return r->used;
+}
+
+int getRankingId(RANKING r, int pos) {
+	return (pos >= 0 && pos < r->used) ? r->order[pos] : -1;
+}
+
+int getRankingQuant(RANKING r, int id) {
+	return r->quant[id];
+}
+
+void freeRanking(RANKING r) {
+	if (r) {
+		FREE(r->order);
+		FREE(r->pos);
+		FREE(r->quant);
+		FREE(r);
+	}
+}
+
+/**
+ * Procura, por pesquisa binária, a primeira posição do bloco a que pertence a
+ * posição last.
+ */
+static int bucketHead(RANKING r, int last) {
+	int lo = 0, hi = last, mid, quant = QUANT(r, last);
+
+	while(lo < hi) {
+		mid = (lo + hi) / 2;
+		if (QUANT(r, mid) > quant) lo = mid + 1;
+		else hi = mid;
+	}
+
+	return lo;
+}
+
+static void swapRanking(RANKING r, int i, int j) {
+	int tmp = r->order[i];
+
+	r->order[i] = r->order[j];
+	r->order[j] = tmp;
+
+	r->pos[r->order[i]] = i;
+	r->pos[r->order[j]] = j;
+}
@@ -0,0 +1,45 @@
+#ifndef __RANKING__
+#define __RANKING__
+
+typedef struct ranking *RANKING;
+
+/**
+ * Inicializa uma classificação de elementos identificados por 0 até size-1, ordenados
+ * de forma decrescente pela quantidade acumulada de cada um. A ordem é mantida a cada
+ * inserção, pelo que consultar as primeiras posições não obriga a ordenar.
+ */
+RANKING initRanking(int size);
+
+/**
+ * Acumula uma quantidade ao elemento dado e atualiza a sua posição na classificação.
+ * Quantidades não positivas são ignoradas.
+ * @param r Classificação a atualizar
+ * @param id Identificador do elemento
+ * @param quant Quantidade a acumular
+ * @return Classificação atualizada
+ */
+RANKING addToRanking(RANKING r, int id, int quant);
+
+/**
+ * Determina o número de elementos com quantidade positiva, isto é, o número de
+ * posições ocupadas na classificação.
+ */
+int getRankingSize(RANKING r);
+
+/**
+ * Devolve o identificador do elemento numa dada posição da classificação (a começar
+ * em 0), ou -1 caso a posição não esteja ocupada.
+ */
+int getRankingId(RANKING r, int pos);
+
+/**
+ * Devolve a quantidade acumulada por um elemento.
+ */
+int getRankingQuant(RANKING r, int id);
+
+/**
+ * Liberta a memória ocupada por uma classificação.
+ */
+void freeRanking(RANKING r);
+
+#endif
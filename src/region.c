@@ -0,0 +1,205 @@
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "region.h"
+
+/* Memória virtual reservada: tenta-se a maior e vai-se reduzindo até à menor */
+#define RESERVE_MAX (1UL << 36)
+#define RESERVE_MIN (1UL << 30)
+
+#define ALIGN 16
+#define ROUND(n, m) (((n) + (m) - 1) / (m) * (m))
+
+/* Blocos mais pequenos do que isto são reaproveitados por classes de tamanho */
+#define SMALL_MAX 16384
+#define CLASSES (SMALL_MAX / ALIGN)
+
+/**
+ * Cabeçalho de cada bloco, com o tamanho total (incluindo o cabeçalho) e, enquanto o
+ * bloco estiver livre, o bloco livre seguinte da mesma lista.
+ */
+typedef union header {
+	struct {
+		size_t size;
+		union header* next;
+	} block;
+	long double align;
+} HEADER;
+
+/**
+ * Os blocos pequenos crescem a partir do início do intervalo reservado e os grandes, que
+ * ocupam páginas inteiras, a partir do fim. A região enche quando os dois se encontram.
+ */
+struct region {
+	char* base;
+	size_t reserved;
+	size_t low;
+	size_t high;
+	size_t page;
+
+	HEADER* small[CLASSES];
+	HEADER* large;
+
+	pthread_mutex_t lock;
+};
+
+static HEADER* allocSmall(REGION r, size_t size);
+static HEADER* allocLarge(REGION r, size_t size);
+
+REGION initRegion(size_t size) {
+	REGION r;
+	size_t reserve, min, page = sysconf(_SC_PAGESIZE);
+	void* base = MAP_FAILED;
+	int i;
+
+	/* Os blocos grandes ocupam páginas inteiras a partir do fim */
+	reserve = size ? ROUND(size, page) : RESERVE_MAX;
+	min = size ? reserve : RESERVE_MIN;
+
+	for(; reserve >= min; reserve /= 2) {
+		base = mmap(NULL, reserve, PROT_READ | PROT_WRITE,
+		            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (base != MAP_FAILED) break;
+	}
+
+	if (base == MAP_FAILED) return NULL;
+
+	r = malloc(sizeof(*r));
+	r->base = base;
+	r->reserved = reserve;
+	r->low = r->high = 0;
+	r->page = page;
+	r->large = NULL;
+
+	for(i = 0; i < CLASSES; i++)
+		r->small[i] = NULL;
+
+	pthread_mutex_init(&r->lock, NULL);
+
+	return r;
+}
+
+void* regionAlloc(REGION r, size_t size) {
+	HEADER* h;
+
+	size = sizeof(HEADER) + ROUND(size, ALIGN);
+
+	pthread_mutex_lock(&r->lock);
+	h = (size < SMALL_MAX) ? allocSmall(r, size) : allocLarge(r, ROUND(size, r->page));
+	pthread_mutex_unlock(&r->lock);
+
+	return h ? h + 1 : NULL;
+}
+
+void* regionRealloc(REGION r, void* ptr, size_t size) {
+	HEADER* h;
+	void* new;
+	size_t old;
+
+	if (!ptr) return regionAlloc(r, size);
+
+	h = (HEADER*) ptr - 1;
+	old = h->block.size - sizeof(HEADER);
+
+	if (size <= old) return ptr;
+
+	if ((new = regionAlloc(r, size))) {
+		memcpy(new, ptr, old);
+		regionFree(r, ptr);
+	}
+
+	return new;
+}
+
+void regionFree(REGION r, void* ptr) {
+	HEADER* h;
+
+	if (!ptr) return;
+
+	h = (HEADER*) ptr - 1;
+
+	/* Só a primeira página de um bloco grande fica ocupada, para o manter na lista */
+	if (h->block.size >= SMALL_MAX)
+		madvise((char*) h + r->page, h->block.size - r->page, MADV_DONTNEED);
+
+	pthread_mutex_lock(&r->lock);
+
+	if (h->block.size < SMALL_MAX) {
+		h->block.next = r->small[h->block.size / ALIGN];
+		r->small[h->block.size / ALIGN] = h;
+	} else {
+		h->block.next = r->large;
+		r->large = h;
+	}
+
+	pthread_mutex_unlock(&r->lock);
+}
+
+size_t getRegionBlockSize(void* ptr) {
+	return ((HEADER*) ptr - 1)->block.size - sizeof(HEADER);
+}
+
+bool inRegion(REGION r, void* ptr) {
+	return (char*) ptr >= r->base && (char*) ptr < r->base + r->reserved;
+}
+
+long getRegionBytes(REGION r) {
+	long bytes;
+
+	pthread_mutex_lock(&r->lock);
+	bytes = r->low + r->high;
+	pthread_mutex_unlock(&r->lock);
+
+	return bytes;
+}
+
+void freeRegion(REGION r) {
+	if (r) {
+		munmap(r->base, r->reserved);
+		pthread_mutex_destroy(&r->lock);
+		free(r);
+	}
+}
+
+static HEADER* allocSmall(REGION r, size_t size) {
+	HEADER* h = r->small[size / ALIGN];
+
+	if (h)
+		r->small[size / ALIGN] = h->block.next;
+	else if (r->low + r->high + size <= r->reserved) {
+		h = (HEADER*) (r->base + r->low);
+		h->block.size = size;
+		r->low += size;
+	}
+
+	return h;
+}
+
+/**
+ * Reaproveita o primeiro bloco grande livre com o tamanho pedido, sem desperdiçar mais
+ * de metade, ou ocupa novas páginas no fim da região.
+ */
+static HEADER* allocLarge(REGION r, size_t size) {
+	HEADER *h, **prev;
+
+	for(prev = &r->large; *prev; prev = &(*prev)->block.next) {
+		h = *prev;
+		if (h->block.size >= size && h->block.size / 2 <= size) {
+			*prev = h->block.next;
+			return h;
+		}
+	}
+
+	if (r->low + r->high + size > r->reserved) return NULL;
+
+	r->high += size;
+	h = (HEADER*) (r->base + r->reserved - r->high);
+	h->block.size = size;
+
+	return h;
+}
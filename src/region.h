@@ -0,0 +1,60 @@
+#ifndef __REGION__
+#define __REGION__
+
+#include <stdlib.h>
+
+#include "generic.h"
+
+typedef struct region *REGION;
+
+/**
+ * Inicia uma região: um intervalo de memória virtual reservado de uma só vez, de onde
+ * são alocados blocos que podem ser libertados um a um ou todos juntos com freeRegion.
+ * As páginas só passam a ocupar memória quando são usadas. Pode ser usada por várias
+ * threads ao mesmo tempo.
+ * @param size Número de bytes a reservar. Se for 0 é reservado o maior intervalo que o
+ * sistema permitir, entre 1GB e 64GB
+ * @return A região, ou NULL se o sistema não permitir reservar memória suficiente
+ */
+REGION initRegion(size_t size);
+
+/**
+ * Aloca um bloco da região, com o alinhamento de malloc.
+ * @return O bloco, ou NULL se a região estiver cheia
+ */
+void* regionAlloc(REGION r, size_t size);
+
+/**
+ * Muda o tamanho de um bloco da região, tal como realloc.
+ * @return O novo bloco, ou NULL se a região estiver cheia, mantendo-se o antigo
+ */
+void* regionRealloc(REGION r, void* ptr, size_t size);
+
+/**
+ * Liberta um bloco da região, que fica disponível para novas alocações. A memória dos
+ * blocos grandes é devolvida logo ao sistema.
+ */
+void regionFree(REGION r, void* ptr);
+
+/**
+ * Devolve o número de bytes que um bloco da região pode ocupar, que é pelo menos o
+ * número pedido.
+ */
+size_t getRegionBlockSize(void* ptr);
+
+/**
+ * Verifica se um endereço pertence à região.
+ */
+bool inRegion(REGION r, void* ptr);
+
+/**
+ * Determina o número de bytes da região já entregues em blocos, libertados ou não.
+ */
+long getRegionBytes(REGION r);
+
+/**
+ * Liberta a região e todos os blocos que ainda lá estejam, sem os percorrer.
+ */
+void freeRegion(REGION r);
+
+#endif
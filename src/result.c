@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "result.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_QUERIES
+
+#define BASE_ROWS 16
+#define BASE_STRINGS 256
+
+/*
+ * Cada coluna é um array contíguo. As colunas de códigos guardam o deslocamento do
+ * código no array strings, partilhado por todas as colunas.
+ */
+struct result {
+	char* types;
+	void** columns;
+	int cols;
+	int rows;
+	int capacity;
+	int refs;
+
+	char* strings;
+	int used;
+	int size;
+};
+
+static size_t colSize(char type);
+
+RESULT initResult(char* types) {
+	RESULT new = MALLOC(sizeof(*new));
+	int i;
+
+	new->cols     = strlen(types);
+	new->types    = MALLOC(new->cols + 1);
+	new->columns  = MALLOC(sizeof(void*) * (new->cols + 1));
+	new->rows     = 0;
+	new->capacity = BASE_ROWS;
+	new->refs     = 1;
+
+	strcpy(new->types, types);
+	for(i = 0; i < new->cols; i++)
+		new->columns[i] = MALLOC(colSize(types[i]) * new->capacity);
+
+	new->strings = MALLOC(BASE_STRINGS);
+	new->used    = 0;
+	new->size    = BASE_STRINGS;
+
+	return new;
+}
+
+RESULT addResultRow(RESULT r) {
+	int i;
+
+	if (r->rows == r->capacity) {
+		r->capacity *= 2;
+		for(i = 0; i < r->cols; i++)
+			r->columns[i] = REALLOC(r->columns[i], colSize(r->types[i]) * r->capacity);
+	}
+
+	for(i = 0; i < r->cols; i++) {
+		if (r->types[i] == COL_DOUBLE)
+			((double*) r->columns[i])[r->rows] = 0;
+		else
+			((int*) r->columns[i])[r->rows] = (r->types[i] == COL_CODE) ? -1 : 0;
+	}
+
+	r->rows++;
+
+	return r;
+}
+
+RESULT setResultCode(RESULT r, int col, char* code) {
+	int len = strlen(code) + 1;
+
+	while (r->used + len > r->size) {
+		r->size *= 2;
+		r->strings = REALLOC(r->strings, r->size);
+	}
+
+	strcpy(r->strings + r->used, code);
+	((int*) r->columns[col])[r->rows - 1] = r->used;
+	r->used += len;
+
+	return r;
+}
+
+RESULT setResultInt(RESULT r, int col, int value) {
+	((int*) r->columns[col])[r->rows - 1] = value;
+	return r;
+}
+
+RESULT setResultDouble(RESULT r, int col, double value) {
+	((double*) r->columns[col])[r->rows - 1] = value;
+	return r;
+}
+
+RESULT copyResultRow(RESULT r, RESULT src, int row) {
+	int i;
+
+	r = addResultRow(r);
+
+	for(i = 0; i < r->cols; i++) {
+		if (r->types[i] == COL_CODE)
+			r = setResultCode(r, i, getResultCode(src, row, i));
+		else if (r->types[i] == COL_INT)
+			r = setResultInt(r, i, getResultInt(src, row, i));
+		else
+			r = setResultDouble(r, i, getResultDouble(src, row, i));
+	}
+
+	return r;
+}
+
+int getResultRows(RESULT r) {
+	return r->rows;
+}
+
+int getResultCols(RESULT r) {
+	return r->cols;
+}
+
+char getResultColType(RESULT r, int col) {
+	return r->types[col];
+}
+
+char* getResultCode(RESULT r, int row, int col) {
+	int offset = ((int*) r->columns[col])[row];
+
+	return (offset < 0) ? "" : r->strings + offset;
+}
+
+int getResultInt(RESULT r, int row, int col) {
+	return ((int*) r->columns[col])[row];
+}
+
+double getResultDouble(RESULT r, int row, int col) {
+	return ((double*) r->columns[col])[row];
+}
+
+long getResultBytes(RESULT r) {
+	long bytes = sizeof(*r) + r->cols + 1 + sizeof(void*) * (r->cols + 1) + r->size;
+	int i;
+
+	for(i = 0; i < r->cols; i++)
+		bytes += colSize(r->types[i]) * r->capacity;
+
+	return bytes;
+}
+
+RESULT retainResult(RESULT r) {
+	r->refs++;
+	return r;
+}
+
+void freeResult(RESULT r) {
+	int i;
+
+	if (r && --r->refs == 0) {
+		for(i = 0; i < r->cols; i++)
+			FREE(r->columns[i]);
+
+		FREE(r->columns);
+		FREE(r->types);
+		FREE(r->strings);
+		FREE(r);
+	}
+}
+
+static size_t colSize(char type) {
+	return (type == COL_DOUBLE) ? sizeof(double) : sizeof(int);
+}
@@ -0,0 +1,92 @@
+#ifndef __RESULT__
+#define __RESULT__
+
+typedef struct result *RESULT;
+
+/** Tipos das colunas de um resultado */
+#define COL_CODE   'c'
+#define COL_INT    'i'
+#define COL_DOUBLE 'd'
+
+/**
+ * Inicializa um resultado vazio, guardado por colunas. Cada carácter de types indica o
+ * tipo de uma coluna: COL_CODE para códigos, COL_INT para inteiros e COL_DOUBLE para
+ * valores reais.
+ */
+RESULT initResult(char* types);
+
+/**
+ * Acrescenta ao resultado uma linha com todos os campos a zero. Os campos são depois
+ * preenchidos com as funções setResult*, que alteram sempre a última linha.
+ */
+RESULT addResultRow(RESULT r);
+
+/**
+ * Altera um código da última linha. O código é copiado para o resultado.
+ */
+RESULT setResultCode(RESULT r, int col, char* code);
+
+/**
+ * Altera um inteiro da última linha.
+ */
+RESULT setResultInt(RESULT r, int col, int value);
+
+/**
+ * Altera um valor real da última linha.
+ */
+RESULT setResultDouble(RESULT r, int col, double value);
+
+/**
+ * Acrescenta ao resultado uma cópia de uma linha de outro resultado, com os mesmos
+ * tipos de colunas.
+ */
+RESULT copyResultRow(RESULT r, RESULT src, int row);
+
+/**
+ * Determina o número de linhas do resultado.
+ */
+int getResultRows(RESULT r);
+
+/**
+ * Determina o número de colunas do resultado.
+ */
+int getResultCols(RESULT r);
+
+/**
+ * Devolve o tipo de uma coluna (COL_CODE, COL_INT ou COL_DOUBLE).
+ */
+char getResultColType(RESULT r, int col);
+
+/**
+ * Devolve o código numa dada linha e coluna. A string pertence ao resultado, pelo que
+ * não deve ser libertada.
+ */
+char* getResultCode(RESULT r, int row, int col);
+
+/**
+ * Devolve o inteiro numa dada linha e coluna.
+ */
+int getResultInt(RESULT r, int row, int col);
+
+/**
+ * Devolve o valor real numa dada linha e coluna.
+ */
+double getResultDouble(RESULT r, int row, int col);
+
+/**
+ * Determina a memória ocupada por um resultado, em bytes.
+ */
+long getResultBytes(RESULT r);
+
+/**
+ * Regista mais um dono do resultado, que passa a ter de o libertar com freeResult.
+ * Permite partilhar o mesmo resultado, por exemplo entre uma cache e quem o apresenta.
+ */
+RESULT retainResult(RESULT r);
+
+/**
+ * Liberta um resultado. A memória só é libertada quando todos os donos o libertarem.
+ */
+void freeResult(RESULT r);
+
+#endif
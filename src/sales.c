@@ -1,69 +1,54 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <string.h>
 
 #include "sales.h"
 
 #define MONTHS 12
-#define BRANCHES 3
 #define PROMO 2
 
-struct sale {
-	PRODUCT prod; 
-	CLIENT client;
-	double price; 
-	int quantity; 
-	int month;     
-	int branch;     
-	int mode;       
-};
-
-static SALE updateSale (SALE s, PRODUCT p, CLIENT c, double price, int quant, int month,
+static SALE updateSale (SALE s, char* p, char* c, double price, int quant, int month,
                         int branch, int mode);
 
-SALE initSale() {
-	return malloc(sizeof(struct sale));
-}
-
-SALE readSale(SALE s, PRODUCT p, CLIENT c, char *line) {
-	char *token;
+SALE readSale(SALE s, char *line) {
+	char *token, *p, *c, *save;
 	double price;
 	int quant, month, branch, mode;
 
-	token = strtok(line, " ");
-	p = changeProductCode(p, token);
+	p = strtok_r(line, " ", &save);
 	
-	token = strtok(NULL, " ");
+	token = strtok_r(NULL, " ", &save);
 	price = atof(token);
 
-	token = strtok(NULL, " ");
+	token = strtok_r(NULL, " ", &save);
 	quant = atoi(token);
 
-	token = strtok(NULL, " ");
+	token = strtok_r(NULL, " ", &save);
 	mode = strcmp(token, "N") ? 1 : 0;
 
-	token = strtok(NULL, " ");
-	c = changeClientCode(c, token);
+	c = strtok_r(NULL, " ", &save);
 
-	token = strtok(NULL, " ");
+	token = strtok_r(NULL, " ", &save);
 	month = atoi(token);
 
-	token = strtok(NULL, " ");
+	token = strtok_r(NULL, " ", &save);
 	branch = atoi(token);
 
 	return updateSale(s, p, c, price, quant, month-1, branch-1, mode);	
 }
 
 bool isSale(SALE sale, PRODUCTCAT prodCat, CLIENTCAT clientCat) {
-	return (lookUpProduct(prodCat, sale->prod) && 
-	  	 lookUpClient(clientCat, sale->client));
+	return (lookUpProductCode(prodCat, sale->prod) && 
+	  	 lookUpClientCode(clientCat, sale->client));
 }
 
 char* getProduct(SALE s) {
-	return fromProduct(s->prod);
+	return s->prod;
 }
 
 char* getClient(SALE s) {
-	return fromClient(s->client);
+	return s->client;
 }
 
 double getPrice(SALE s) {
@@ -86,11 +71,7 @@ int getMode(SALE s) {
 	return s->mode;
 }
 
-void freeSale(SALE s) {
-	free(s);
-}
-
-static SALE updateSale(SALE s, PRODUCT p, CLIENT c, double price, int quant, int month, 
+static SALE updateSale(SALE s, char* p, char* c, double price, int quant, int month, 
                                                                   int branch, int mode)
  {
 	s->prod = p;
@@ -12,20 +12,29 @@ typedef struct revenue *REVENUE;
 #define MODE_P 1
 
 /**
- * Aloca memória para uma SALE. Esta estrutura de dados descreve todos os elementos
- * envolvidos numa transação.
+ * Descreve todos os elementos envolvidos numa transação. A estrutura só é pública para
+ * que cada venda lida possa ficar na stack de quem a lê; os campos devem ser acedidos
+ * através das funções deste módulo. Os códigos do produto e do cliente apontam para a
+ * linha de onde a venda foi lida, pelo que só são válidos enquanto a linha o for.
  */
-SALE initSale ();
+struct sale {
+	char* prod;
+	char* client;
+	double price;
+	int quantity;
+	int month;
+	int branch;
+	int mode;
+};
 
 /**
- * Dado uma string correspondente a uma venda, extrai toda a sua informação para uma SALE.
+ * Dado uma string correspondente a uma venda, extrai toda a sua informação para uma SALE,
+ * sem alocar memória. Pode ser chamada por várias threads ao mesmo tempo.
  * @param s SALE que receberá os dados lidos
- * @param p Estrutura para onde serão extraidos os dados sobre o produto vendido
- * @param c Estrutura para onde serão extraidos os dados sobre o cliente que realizaou
- * a transação
+ * @param line Linha com a venda, que é alterada e à qual a SALE fica a apontar
  * @return SALE com os dados lidos
  */
-SALE readSale (SALE s, PRODUCT p, CLIENT c, char *line);
+SALE readSale (SALE s, char *line);
 
 /**
  * Verifica se todos os dados e uma transação são válidos.
@@ -33,12 +42,14 @@ SALE readSale (SALE s, PRODUCT p, CLIENT c, char *line);
 bool isSale (SALE sale, PRODUCTCAT prodCat, CLIENTCAT clientCat);
 
 /**
- * Devolve o produto vendido na transação dada.
+ * Devolve o código do produto vendido na transação dada. O código pertence à linha
+ * lida e não deve ser alterado nem libertado.
  */
 char* getProduct (SALE s);
 
 /**
- * Devolve o cliente que participou na transação dada.
+ * Devolve o código do cliente que participou na transação dada. O código pertence à
+ * linha lida e não deve ser alterado nem libertado.
  */
 char* getClient (SALE s);
 
@@ -68,9 +79,4 @@ int getBranch (SALE s);
  */
 int getMode (SALE s);
 
-/**
- * Liberta todo o espaço reservado para descrever uma venda.
- */
-void freeSale (SALE s);
-
 #endif
@@ -0,0 +1,648 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "salesindex.h"
+#include "catalog.h"
+#include "hashT.h"
+#include "ranking.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_SALESINDEX
+
+#define PRODUCTS_BY_CLIENT 32
+#define MONTHS 12
+
+/* Número de clientes compactados por cada pedaço do parallelFor */
+#define COMPACT_GRAIN 256
+
+#define SALE_N  1
+#define SALE_P  2
+#define SALE_NP 3
+
+/* Cada filial ocupa dois bits do tipo de venda de um PRODUCTUNIT, que é sem sinal para
+ * a última das MAX_BRANCHES filiais poder usar o bit de topo */
+#define SALETYPE(t, branch) (((t) >> (2 * (branch))) & SALE_NP)
+
+/* Tipo de venda da aresta e, guardado com dois bits por aresta */
+#define EDGEMODE(modes, e) (((modes)[(e) >> 2] >> (((e) & 3) * 2)) & SALE_NP)
+#define MODEBYTES(edges) (((edges) + 3) >> 2)
+
+/* Número de índices compactados até ao momento, usado para numerar as gerações */
+static int generations = 0;
+
+struct salesindex {
+	CATALOG clients;
+	CATALOG products;
+	int branches;
+	int generation;
+	THREADPOOL pool;
+
+	/* Identificadores densos, atribuídos por ordem alfabética */
+	int nClients;
+	int nProducts;
+	char **clientCodes;
+	char **productCodes;
+	struct client_sale **clientRecords;
+	struct product_sale **productRecords;
+
+	/* Quantidades compradas por cada cliente, indexadas por [cliente][filial][mês] */
+	int *clientQuant;
+
+	/* Produtos de cada filial ordenados pela quantidade vendida */
+	RANKING *rankings;
+
+	/* Adjacências construídas no fim do carregamento (CSR) */
+	int *clientOffsets;
+	struct product_unit *cpUnits;
+	int *productOffsets;   /* indexado por (produto * filiais + filial) */
+	int *pcClients;
+	unsigned char *pcModes;
+};
+
+typedef struct product_unit {
+	double billed[MONTHS];
+	int quant[MONTHS];
+	unsigned int saletype;
+	int product;
+}*PRODUCTUNIT;
+
+/* Produtos comprados por um cliente durante o carregamento, pelo id do produto */
+#define UNIT_HASH(id) (((unsigned) (id) * 2654435761U) >> 8)
+#define UNIT_EQUAL(id1, id2) ((id1) == (id2))
+#define UNIT_LESS(pu1, pu2) ((pu1).product < (pu2).product)
+
+HASHT_OF(UnitTable, int, struct product_unit, UNIT_HASH, UNIT_EQUAL)
+SORT_OF(sortUnitsById, struct product_unit, UNIT_LESS)
+
+typedef struct client_sale {
+	struct UnitTable* products;
+	int bought;
+	int id;
+}*CLIENTSALE ;
+
+typedef struct product_sale {
+	int *buyers;
+	int id;
+}*PRODUCTSALE;
+
+struct product_data {
+	int quantity;
+	int clients;
+};
+
+static void sortByKey(int* pos, double* key, int begin, int end);
+static bool clientBoughtInAll(CLIENTSALE cs, int* all);
+static bool clientNeverBought(CLIENTSALE cs);
+static CLIENTSALE addSaleToClientSale(CLIENTSALE cs, SALE s, int product);
+static void freeProductSale(PRODUCTSALE ps);
+static PRODUCTSALE initProductSale(int id, int branches);
+static PRODUCTUNIT addToProductUnit(PRODUCTUNIT product, SALE s, int id);
+static double getTotalBilled(PRODUCTUNIT pu);
+static CLIENTSALE initClientSale(int id, int branches);
+static void freeClientSale(CLIENTSALE cs);
+static char** fillRecords(CATALOG cat, void** records, void* (*init)(int, int), int branches);
+static void compactClients(SALESINDEX si, int begin, int end);
+
+SALESINDEX initSalesIndex(int branches) {
+	SALESINDEX new = MALLOC(sizeof(*new));
+
+	new->products = NULL;
+	new->clients = NULL;
+	new->branches = branches;
+	new->generation = 0;
+	new->pool = NULL;
+
+	new->nClients = new->nProducts = 0;
+	new->clientCodes = new->productCodes = NULL;
+	new->clientRecords = NULL;
+	new->productRecords = NULL;
+	new->clientQuant = NULL;
+	new->rankings = NULL;
+
+	new->clientOffsets = new->productOffsets = NULL;
+	new->cpUnits = NULL;
+	new->pcClients = NULL;
+	new->pcModes = NULL;
+
+	return new;
+}
+
+SALESINDEX setSalesIndexPool(SALESINDEX si, THREADPOOL pool) {
+	si->pool = pool;
+	return si;
+}
+
+THREADPOOL getSalesIndexPool(SALESINDEX si) {
+	return si->pool;
+}
+
+SALESINDEX fillSalesIndex(SALESINDEX si, CLIENTCAT cc, PRODUCTCAT pc) {
+	int i;
+
+	si->clients = getClientCat(cc);
+	si->products = getProductCat(pc);
+
+	si->clients = changeCatalogOps(si->clients, NULL, (free_t) freeClientSale);
+	si->products = changeCatalogOps(si->products, NULL, (free_t) freeProductSale);
+
+	si->nClients = countAllElems(si->clients);
+	si->nProducts = countAllElems(si->products);
+
+	si->clientRecords = MALLOC(sizeof(CLIENTSALE) * si->nClients);
+	si->productRecords = MALLOC(sizeof(PRODUCTSALE) * si->nProducts);
+	si->clientQuant = CALLOC(si->nClients * si->branches * MONTHS, sizeof(int));
+
+	si->rankings = MALLOC(sizeof(RANKING) * si->branches);
+	for(i = 0; i < si->branches; i++)
+		si->rankings[i] = initRanking(si->nProducts);
+
+	si->clientCodes = fillRecords(si->clients, (void**) si->clientRecords,
+	                              (void* (*)(int, int)) initClientSale, si->branches);
+	si->productCodes = fillRecords(si->products, (void**) si->productRecords,
+	                               (void* (*)(int, int)) initProductSale, si->branches);
+
+	return si;
+}
+
+SALESINDEX compactSalesIndex(SALESINDEX si) {
+	CLIENTSALE cs;
+	int i, j, size, edges, slices, slice, branch, mode, *next;
+
+	si->clientOffsets = MALLOC(sizeof(int) * (si->nClients + 1));
+	si->clientOffsets[0] = 0;
+
+	for(i = 0; i < si->nClients; i++) {
+		cs = si->clientRecords[i];
+		size = (cs->products) ? getUnitTableSize(cs->products) : 0;
+		si->clientOffsets[i+1] = si->clientOffsets[i] + size;
+	}
+
+	edges = si->clientOffsets[si->nClients];
+	si->cpUnits = MALLOC(sizeof(struct product_unit) * edges);
+
+	/*
+	 * Cliente → produtos. Cada cliente escreve na sua parte de cpUnits, pelo que são
+	 * compactados em paralelo; o número de produtos por cliente varia muito, daí o
+	 * parallelFor, que equilibra a carga.
+	 */
+	si->pool = parallelFor(si->pool, 0, si->nClients, COMPACT_GRAIN,
+	                       (range_t) compactClients, si);
+
+	/* Produto → clientes de cada filial, obtido por transposição das arestas anteriores */
+	slices = si->nProducts * si->branches;
+	si->productOffsets = CALLOC(slices + 1, sizeof(int));
+
+	for(i = 0; i < edges; i++)
+		for(branch = 0; branch < si->branches; branch++)
+			if (SALETYPE(si->cpUnits[i].saletype, branch))
+				si->productOffsets[si->cpUnits[i].product * si->branches + branch + 1]++;
+
+	for(i = 0; i < si->nProducts; i++)
+		for(branch = 0; branch < si->branches; branch++) {
+			slice = i * si->branches + branch;
+			si->productRecords[i]->buyers[branch] = si->productOffsets[slice + 1];
+			si->productOffsets[slice + 1] += si->productOffsets[slice];
+		}
+
+	next = MALLOC(sizeof(int) * (slices + 1));
+	memcpy(next, si->productOffsets, sizeof(int) * (slices + 1));
+
+	edges = si->productOffsets[slices];
+	si->pcClients = MALLOC(sizeof(int) * edges);
+	si->pcModes = CALLOC(MODEBYTES(edges), sizeof(unsigned char));
+
+	for(i = 0; i < si->nClients; i++) {
+		for(j = si->clientOffsets[i]; j < si->clientOffsets[i+1]; j++) {
+			for(branch = 0; branch < si->branches; branch++) {
+				mode = SALETYPE(si->cpUnits[j].saletype, branch);
+				if (!mode) continue;
+
+				size = next[si->cpUnits[j].product * si->branches + branch]++;
+				si->pcClients[size] = i;
+				si->pcModes[size >> 2] |= mode << ((size & 3) * 2);
+			}
+		}
+	}
+
+	FREE(next);
+
+	si->generation = ++generations;
+	return si;
+}
+
+int getSalesIndexBranches(SALESINDEX si) {
+	return si->branches;
+}
+
+int getSalesIndexGeneration(SALESINDEX si) {
+	return si->generation;
+}
+
+int getSalesIndexClients(SALESINDEX si) {
+	return si->nClients;
+}
+
+int getClientId(SALESINDEX si, CLIENT c) {
+	CLIENTSALE cs;
+	char* client;
+
+	client = fromClient(c);
+	cs = getCatContent(si->clients, client, NULL);
+	FREE(client);
+
+	return (cs) ? cs->id : -1;
+}
+
+int* getClientQuantByMonth(SALESINDEX si, int id) {
+	return si->clientQuant + id * si->branches * MONTHS;
+}
+
+int getClientsByMonthQuant(SALESINDEX si, int month, int quant, int* clients) {
+	int i, branch, total, *row, size = 0;
+
+	for(i = 0; i < si->nClients; i++) {
+		row = si->clientQuant + i * si->branches * MONTHS + month;
+		total = 0;
+
+		for(branch = 0; branch < si->branches; branch++)
+			total += row[branch * MONTHS];
+
+		if (total > quant)
+			clients[size++] = i;
+	}
+
+	return size;
+}
+
+SET getClientsWhoBoughtInAll(SALESINDEX si) {
+	SET s = initSet(countAllElems(si->clients), NULL);
+	int all = (1 << si->branches) - 1;
+
+	s = filterCatParallel(si->clients, s, (condition_t) clientBoughtInAll, &all, si->pool);
+
+	return s;
+}
+
+SET getClientsWhoNeverBought(SALESINDEX si) {
+	SET s = initSet(countAllElems(si->clients), NULL);
+
+	s = filterCatParallel(si->clients, s, (condition_t) clientNeverBought, NULL, si->pool);
+
+	return s;
+}
+
+void countClientsByProduct(SALESINDEX si, PRODUCT prod, int branch, int *normal,
+                                                                        int *promo) {
+	PRODUCTSALE ps;
+	char* product;
+	int i, slice, mode;
+
+	*normal = *promo = 0;
+
+	product = fromProduct(prod);
+	ps = getCatContent(si->products, product, NULL);
+	FREE(product);
+
+	if (!ps || !si->productOffsets)
+		return;
+
+	slice = ps->id * si->branches + branch;
+
+	for(i = si->productOffsets[slice]; i < si->productOffsets[slice + 1]; i++) {
+		mode = EDGEMODE(si->pcModes, i);
+		if (mode & SALE_N) (*normal)++;
+		if (mode & SALE_P) (*promo)++;
+	}
+}
+
+int getClientsByProduct(SALESINDEX si, PRODUCT prod, int branch, int mode, int* clients) {
+	PRODUCTSALE ps;
+	char* product;
+	int i, slice, size = 0;
+
+	product = fromProduct(prod);
+	ps = getCatContent(si->products, product, NULL);
+	FREE(product);
+
+	if (!ps || !si->productOffsets)
+		return 0;
+
+	slice = ps->id * si->branches + branch;
+	mode = (mode == MODE_N) ? SALE_N : SALE_P;
+
+	for(i = si->productOffsets[slice]; i < si->productOffsets[slice + 1]; i++)
+		if (EDGEMODE(si->pcModes, i) & mode)
+			clients[size++] = si->pcClients[i];
+
+	return size;
+}
+
+char* getClientCode(SALESINDEX si, int id) {
+	return si->clientCodes[id];
+}
+
+char* getProductCode(SALESINDEX si, int id) {
+	return si->productCodes[id];
+}
+
+int countProductsByClient(SALESINDEX si, int id) {
+	return (si->clientOffsets) ? si->clientOffsets[id + 1] - si->clientOffsets[id] : 0;
+}
+
+int getProductsByClientQuant(SALESINDEX si, int id, int month, int* products, int* quant) {
+	PRODUCTUNIT units;
+	double* key;
+	int i, size, n = countProductsByClient(si, id);
+
+	if (n == 0) return 0;
+
+	units = si->cpUnits + si->clientOffsets[id];
+	key = MALLOC(sizeof(double) * n);
+
+	for(i = 0; i < n; i++) {
+		products[i] = i;
+		key[i] = units[i].quant[month];
+	}
+
+	sortByKey(products, key, 0, n - 1);
+
+	/* Os produtos que não foram comprados no mês ficam todos no fim */
+	for(size = 0; size < n && units[products[size]].quant[month] != 0; size++) {
+		quant[size] = units[products[size]].quant[month];
+		products[size] = units[products[size]].product;
+	}
+
+	FREE(key);
+	return size;
+}
+
+int getProductsByClientBilled(SALESINDEX si, int id, int* products, double* billed) {
+	PRODUCTUNIT units;
+	double* key;
+	int i, month, n = countProductsByClient(si, id);
+
+	if (n == 0) return 0;
+
+	units = si->cpUnits + si->clientOffsets[id];
+	key = MALLOC(sizeof(double) * n);
+
+	for(i = 0; i < n; i++) {
+		products[i] = i;
+		for(key[i] = 0, month = 0; month < MONTHS; month++)
+			key[i] += units[i].billed[month];
+	}
+
+	sortByKey(products, key, 0, n - 1);
+
+	for(i = 0; i < n; i++) {
+		billed[i] = getTotalBilled(&units[products[i]]);
+		products[i] = units[products[i]].product;
+	}
+
+	FREE(key);
+	return n;
+}
+
+SET listProductsByQuant(SALESINDEX si, int branch, int n) {
+	SET s;
+	PRODUCTDATA pd;
+	int i, id;
+
+	n = (n < getRankingSize(si->rankings[branch])) ? n : getRankingSize(si->rankings[branch]);
+	s = initSet((n > 0) ? n : 1, (free_t) freeProductData);
+
+	for(i = 0; i < n; i++) {
+		id = getRankingId(si->rankings[branch], i);
+
+		pd = MALLOC(sizeof(*pd));
+		pd->clients  = si->productRecords[id]->buyers[branch];
+		pd->quantity = getRankingQuant(si->rankings[branch], id);
+
+		s = insertElement(s, si->productCodes[id], pd);
+	}
+
+	return s;
+}
+
+void freeSalesIndex(SALESINDEX si) {
+	int i;
+
+	if (si) {
+		freeCatalog(si->products);
+		freeCatalog(si->clients);
+
+		for(i = 0; i < si->nClients; i++)
+			FREE(si->clientCodes[i]);
+		for(i = 0; i < si->nProducts; i++)
+			FREE(si->productCodes[i]);
+
+		FREE(si->clientCodes);
+		FREE(si->productCodes);
+		FREE(si->clientRecords);
+		FREE(si->productRecords);
+		FREE(si->clientQuant);
+
+		for(i = 0; si->rankings && i < si->branches; i++)
+			freeRanking(si->rankings[i]);
+		FREE(si->rankings);
+
+		FREE(si->clientOffsets);
+		FREE(si->cpUnits);
+		FREE(si->productOffsets);
+		FREE(si->pcClients);
+		FREE(si->pcModes);
+		FREE(si);
+	}
+}
+
+SALESINDEX addSaleToIndex(SALESINDEX si, SALE s, int product, int client) {
+	CLIENTSALE cs;
+
+	si->rankings[getBranch(s)] = addToRanking(si->rankings[getBranch(s)], product, getQuant(s));
+
+	cs = si->clientRecords[client];
+	cs = addSaleToClientSale(cs, s, product);
+
+	si->clientQuant[(cs->id * si->branches + getBranch(s)) * MONTHS + getMonth(s)] += getQuant(s);
+
+	return si;
+}
+
+/**
+ * Copia os produtos comprados por cada cliente do intervalo dado para cpUnits,
+ * ordenados pelo id (e portanto pelo código) do produto, libertando a tabela de hash
+ * usada durante o carregamento.
+ */
+static void compactClients(SALESINDEX si, int begin, int end) {
+	CLIENTSALE cs;
+	PRODUCTUNIT units;
+	int i;
+
+	for(i = begin; i < end; i++) {
+		cs = si->clientRecords[i];
+		if (!cs->products) continue;
+
+		units = dumpUnitTable(cs->products, si->cpUnits + si->clientOffsets[i]);
+		sortUnitsById(units, 0, getUnitTableSize(cs->products) - 1);
+
+		freeUnitTable(cs->products);
+		cs->products = NULL;
+	}
+}
+
+/**
+ * Cria um registo, com o respetivo identificador denso, para cada elemento do catálogo.
+ * Como os índices do catálogo estão ordenados, os identificadores seguem a ordem
+ * alfabética dos códigos.
+ * @return Array com o código correspondente a cada identificador
+ */
+static char** fillRecords(CATALOG cat, void** records, void* (*init)(int, int), int branches) {
+	SET set;
+	MEMBER member;
+	char **codes, *code;
+	int i, size;
+
+	set = initSet(countAllElems(cat), NULL);
+	set = fillAllSet(cat, set);
+	size = getSetSize(set);
+
+	codes = MALLOC(sizeof(char*) * size);
+	member = newMember();
+
+	for(i = 0; i < size; i++) {
+		code = getSetHash(set, i);
+		getCatContent(cat, code, member);
+
+		records[i] = init(i, branches);
+		updateMember(member, records[i]);
+		codes[i] = code;
+	}
+
+	freeMember(member);
+	freeSet(set);
+
+	return codes;
+}
+
+static PRODUCTSALE initProductSale(int id, int branches) {
+	PRODUCTSALE new = MALLOC(sizeof(*new));
+
+	new->buyers = CALLOC(branches, sizeof(int));
+	new->id = id;
+
+	return new;
+}
+
+void freeProductData(PRODUCTDATA pd) {
+	FREE(pd);
+}
+
+int getClientsFromData(PRODUCTDATA pd) {
+	return pd->clients;
+}
+
+int getQuantFromData(PRODUCTDATA pd) {
+	return pd->quantity;
+}
+
+static void freeProductSale(PRODUCTSALE ps) {
+	if (ps) {
+		FREE(ps->buyers);
+		FREE(ps);
+	}
+}
+
+static CLIENTSALE initClientSale(int id, int branches) {
+	CLIENTSALE new = MALLOC(sizeof(*new));
+
+	/* As quantidades por filial estão na matriz do índice */
+	(void) branches;
+
+	new->products = NULL;
+	new->bought = 0;
+	new->id = id;
+
+	return new;
+}
+
+static bool clientBoughtInAll(CLIENTSALE cs, int* all) {
+	return (cs->bought == *all);
+}
+
+static bool clientNeverBought(CLIENTSALE cs) {
+	return (cs->bought == 0);
+}
+
+static CLIENTSALE addSaleToClientSale(CLIENTSALE cs, SALE s, int product) {
+	if (!cs->products)
+		cs->products = initUnitTable(PRODUCTS_BY_CLIENT);
+
+	cs->bought |= 1 << getBranch(s);
+	addToProductUnit(insertUnitTable(cs->products, product), s, product);
+
+	return cs;
+}
+
+static void freeClientSale(CLIENTSALE cs) {
+	if (cs) {
+		freeUnitTable(cs->products);
+		FREE(cs);
+	}
+}
+
+static PRODUCTUNIT addToProductUnit(PRODUCTUNIT product, SALE s, int id) {
+	int month = getMonth(s);
+	int quant = getQuant(s);
+	int billed = quant*getPrice(s);
+	unsigned int mode = (getMode(s) == MODE_N) ? SALE_N : SALE_P;
+
+	product->billed[month] += billed;
+	product->quant[month] += quant;
+	product->saletype |= mode << (2 * getBranch(s));
+	product->product = id;
+
+	return product;
+}
+
+/**
+ * Ordena as posições de pos[begin..end] por ordem decrescente de key[pos[i]]. As
+ * diferenças são truncadas para inteiro, pelo que faturações a menos de uma unidade
+ * contam como empate, e a partição é a de sortSet, para que os empates fiquem pela
+ * mesma ordem que tinham as listas de produtos de cada cliente.
+ */
+static void sortByKey(int* pos, double* key, int begin, int end) {
+	double pivot;
+	int i, lim, tmp;
+
+	while (begin < end) {
+		pivot = key[pos[end]];
+
+		for(lim = begin - 1, i = begin; i < end; i++)
+			if ((int) (key[pos[i]] - pivot) >= 0) {
+				lim++;
+				tmp = pos[lim]; pos[lim] = pos[i]; pos[i] = tmp;
+			}
+
+		lim++;
+		tmp = pos[lim]; pos[lim] = pos[end]; pos[end] = tmp;
+
+		/* Só a parte menor é ordenada recursivamente, o que limita a pilha a log n */
+		if (lim - begin < end - lim) {
+			sortByKey(pos, key, begin, lim - 1);
+			begin = lim + 1;
+		} else {
+			sortByKey(pos, key, lim + 1, end);
+			end = lim - 1;
+		}
+	}
+}
+
+static double getTotalBilled(PRODUCTUNIT pu) {
+	int i, r = 0;
+
+	for(i = 0; i < MONTHS; i++)
+		r += pu->billed[i];
+
+	return r;
+
+}
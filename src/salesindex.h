@@ -0,0 +1,210 @@
+#ifndef __SALESINDEX__
+#define __SALESINDEX__
+
+#include "products.h"
+#include "clients.h"
+#include "sales.h"
+#include "threadpool.h"
+
+typedef struct salesindex *SALESINDEX;
+typedef struct product_data *PRODUCTDATA;
+
+/** Número máximo de filiais que um índice de vendas consegue distinguir */
+#define MAX_BRANCHES 16
+
+/**
+ * Inicia um índice de vendas com o número de filiais dado. Esta estrutura relaciona
+ * os clientes e os produtos com as compras efetuadas em todas as filiais, guardando em
+ * cada registo a informação de cada uma das filiais.
+ */
+SALESINDEX initSalesIndex(int branches);
+
+/**
+ * Indica os trabalhadores a usar no carregamento e nas consultas que percorrem todos os
+ * clientes. O pool não passa a pertencer ao índice, pelo que tem de ser libertado por
+ * quem o criou. Sem pool (NULL, o valor inicial) tudo é feito sequencialmente.
+ */
+SALESINDEX setSalesIndexPool(SALESINDEX si, THREADPOOL pool);
+
+/**
+ * Devolve o pool indicado com setSalesIndexPool, ou NULL se não houver nenhum.
+ */
+THREADPOOL getSalesIndexPool(SALESINDEX si);
+
+/**
+ * Adiciona ao índice todos os clientes e produtos presentes nos catálogos dados.
+ */
+SALESINDEX fillSalesIndex(SALESINDEX si, CLIENTCAT cc, PRODUCTCAT pc);
+
+/**
+ * Compacta o índice depois de todas as vendas terem sido carregadas. As relações entre
+ * clientes e produtos passam a ser guardadas em arrays contíguos (CSR), nos dois
+ * sentidos, e as tabelas de hash usadas durante o carregamento são libertadas.
+ * Depois de compactado, o índice não aceita novas vendas.
+ */
+SALESINDEX compactSalesIndex(SALESINDEX si);
+
+/**
+ * Adiciona os dados da compra aos registos do cliente e do produto envolvidos.
+ * @param si Índice de vendas
+ * @param s Dados acerca da compra efetuada
+ * @param product Identificador do produto (ver getProductCodeId)
+ * @param client Identificador do cliente (ver getClientCodeId)
+ */
+SALESINDEX addSaleToIndex(SALESINDEX si, SALE s, int product, int client);
+
+/**
+ * Devolve o número de filiais com que o índice foi iniciado.
+ */
+int getSalesIndexBranches(SALESINDEX si);
+
+/**
+ * Devolve a geração dos dados do índice: um número diferente para cada índice
+ * compactado, ou 0 se o índice ainda não foi carregado. Permite saber se resultados
+ * calculados anteriormente ainda correspondem aos dados atuais.
+ */
+int getSalesIndexGeneration(SALESINDEX si);
+
+/**
+ * Devolve o número de clientes presentes no índice.
+ */
+int getSalesIndexClients(SALESINDEX si);
+
+/**
+ * Devolve o identificador denso de um cliente, ou -1 se este não existir no índice.
+ * Os identificadores vão de 0 ao número de clientes, pela ordem dos códigos.
+ */
+int getClientId(SALESINDEX si, CLIENT c);
+
+/**
+ * Determina a quantidade de produtos comprados por um cliente ao longo do ano em
+ * cada uma das filiais.
+ * @param si Índice de vendas
+ * @param id Identificador do cliente, obtido com getClientId
+ * @return Array com a quantidade comprada em cada mês de cada filial, indexado por
+ * (filial * 12 + mês). O array pertence ao índice, pelo que não deve ser libertado
+ */
+int* getClientQuantByMonth(SALESINDEX si, int id);
+
+/**
+ * Determina os clientes que, somando todas as filiais, compraram num mês mais do que
+ * uma dada quantidade de produtos.
+ * @param si Índice de vendas
+ * @param month Mês a ser analizado
+ * @param quant Quantidade a ser excedida
+ * @param clients Array onde são escritos os identificadores dos clientes. Deve ter
+ * espaço para o número de clientes do índice
+ * @return Número de clientes escritos
+ */
+int getClientsByMonthQuant(SALESINDEX si, int month, int quant, int* clients);
+
+/**
+ * Determina os clientes que realizaram compras em todas as filiais.
+ */
+SET getClientsWhoBoughtInAll(SALESINDEX si);
+
+/**
+ * Determina os clientes que nunca realizaram compras em nenhuma filial.
+ */
+SET getClientsWhoNeverBought(SALESINDEX si);
+
+/**
+ * Conta os clientes de uma dada filial que compraram um dado produto, distinguindo
+ * se esta compra foi efetuada quando o produto se encontrava em promoção ou não.
+ * Um cliente que comprou nos dois modos é contado em ambos.
+ * @param si Índice de vendas
+ * @param prod Produto a ser verificado
+ * @param branch Filial a ser analizada
+ * @param normal Número de clientes que compraram em modo normal
+ * @param promo Número de clientes que compraram em modo promoção
+ */
+void countClientsByProduct(SALESINDEX si, PRODUCT prod, int branch, int *normal, int *promo);
+
+/**
+ * Determina os clientes de uma dada filial que compraram um dado produto num dado modo.
+ * @param si Índice de vendas
+ * @param prod Produto a ser verificado
+ * @param branch Filial a ser analizada
+ * @param mode Modo de compra (MODE_N ou MODE_P)
+ * @param clients Array onde são escritos os identificadores dos clientes, por ordem
+ * do seu código. Deve ter espaço para o valor obtido com countClientsByProduct
+ * @return Número de clientes escritos
+ */
+int getClientsByProduct(SALESINDEX si, PRODUCT prod, int branch, int mode, int* clients);
+
+/**
+ * Devolve o código do cliente com o identificador dado. A string pertence ao índice,
+ * pelo que não deve ser libertada.
+ */
+char* getClientCode(SALESINDEX si, int id);
+
+/**
+ * Devolve o código do produto com o identificador dado. A string pertence ao índice,
+ * pelo que não deve ser libertada.
+ */
+char* getProductCode(SALESINDEX si, int id);
+
+/**
+ * Devolve o número de produtos diferentes comprados por um cliente em todas as filiais.
+ * @param si Índice de vendas
+ * @param id Identificador do cliente, obtido com getClientId
+ */
+int countProductsByClient(SALESINDEX si, int id);
+
+/**
+ * Determina os produtos comprados por um cliente num dado mês, por ordem decrescente da
+ * quantidade comprada, percorrendo só as arestas desse cliente.
+ * @param si Índice de vendas
+ * @param id Identificador do cliente, obtido com getClientId
+ * @param month Mês a ser analizado
+ * @param products Array onde são escritos os identificadores dos produtos. Deve ter
+ * espaço para o valor obtido com countProductsByClient
+ * @param quant Array onde é escrita a quantidade comprada de cada produto
+ * @return Número de produtos escritos
+ */
+int getProductsByClientQuant(SALESINDEX si, int id, int month, int* products, int* quant);
+
+/**
+ * Determina os produtos comprados por um cliente ao longo do ano, por ordem decrescente
+ * da faturação, percorrendo só as arestas desse cliente.
+ * @param si Índice de vendas
+ * @param id Identificador do cliente, obtido com getClientId
+ * @param products Array onde são escritos os identificadores dos produtos. Deve ter
+ * espaço para o valor obtido com countProductsByClient
+ * @param billed Array onde é escrito o valor gasto em cada produto
+ * @return Número de produtos escritos
+ */
+int getProductsByClientBilled(SALESINDEX si, int id, int* products, double* billed);
+
+/**
+ * Determina os produtos mais vendidos numa filial, ordenados por quantidade. A ordem é
+ * mantida durante o carregamento das vendas, pelo que não é feita nenhuma ordenação.
+ * O conteúdo dos elementos da lista são do tipo PRODUCTDATA podendo ser acedidos para
+ * obter informação acerca do produto.
+ * @param si Índice de vendas
+ * @param branch Filial a ser analizada
+ * @param n Número máximo de produtos na lista
+ */
+SET listProductsByQuant(SALESINDEX si, int branch, int n);
+
+/**
+ * Calcula o número de clientes que compraram um produto.
+ */
+int getClientsFromData(PRODUCTDATA pd);
+
+/**
+ * Calcula o número de unidades compradas de um produto.
+ */
+int getQuantFromData(PRODUCTDATA pd);
+
+/**
+ * Liberta toda a memória associada à cópia do conjunto de informações de um produto.
+ */
+void freeProductData(PRODUCTDATA pd);
+
+/**
+ * Liberta toda a memória usada pelo índice de vendas.
+ */
+void freeSalesIndex(SALESINDEX si);
+
+#endif
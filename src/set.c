@@ -2,6 +2,9 @@
 #include <string.h>
 
 #include "set.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_SET
 
 #define HASH(s,i) s->list[i]->hash
 #define CONTENT(s,i) s->list[i]->content
@@ -23,6 +26,7 @@ static ELEMENT newElement (char* hash, void* content);
 
 static int partitionByName (SET set, int begin, int end);
 static void quicksortByName (SET set, int begin, int end);
+static void pivotByName (SET set, int begin, int end);
 
 static void quicksort (SET set, int begin, int end, compare_t comparator, void* arg);
 static int partition (SET set, int begin, int end, compare_t comparator, void* arg);
@@ -31,9 +35,9 @@ static void swapData (SET set, int i, int j);
 
 
 SET initSet(int capacity, free_t free) {
-	SET new = malloc(sizeof(*new));
+	SET new = MALLOC(sizeof(*new));
 
-	new->list = malloc(sizeof(ELEMENT) * capacity);
+	new->list = MALLOC(sizeof(ELEMENT) * capacity);
 	new->size = 0;
 	new->capacity = capacity;
 	new->free = free;
@@ -47,7 +51,7 @@ SET insertElement(SET s, char* hash, void* content) {
 
 	if (size == s->capacity) {
 		s->capacity *= 2;
-		s->list = realloc(s->list, s->capacity * sizeof(ELEMENT));
+		s->list = REALLOC(s->list, s->capacity * sizeof(ELEMENT));
 	}
 
 	s->list[size] = new;
@@ -68,7 +72,7 @@ char* getSetHash(SET s, int pos) {
 	if (pos < 0 || pos >= s->size)
 		return NULL;
 	
-	str = malloc(sizeof(char) * strlen(HASH(s, pos)) + 1);
+	str = MALLOC(sizeof(char) * strlen(HASH(s, pos)) + 1);
 	strcpy(str, s->list[pos]->hash);
 
 	return str;
@@ -199,25 +203,42 @@ SET intersectSet(SET s1, SET s2) {
 	return new;
 }
 
+SET appendSet(SET dest, SET src) {
+	int i;
+
+	if (dest->size + src->size > dest->capacity) {
+		dest->capacity = dest->size + src->size;
+		dest->list = REALLOC(dest->list, dest->capacity * sizeof(ELEMENT));
+	}
+
+	for(i = 0; i < src->size; i++)
+		dest->list[dest->size++] = src->list[i];
+
+	FREE(src->list);
+	FREE(src);
+
+	return dest;
+}
+
 void freeSet(SET s) {
 	int i;
 
 	if (s) {
 			for(i = 0; i < SIZE(s); i++){
-				free(HASH(s,i));
+				FREE(HASH(s,i));
 				if (s->free) s->free(CONTENT(s,i));
-				free(s->list[i]);
+				FREE(s->list[i]);
 			}
 
-		free(s->list);
-		free(s);
+		FREE(s->list);
+		FREE(s);
 	}
 }
 
 static ELEMENT newElement(char* hash, void* content) {
-	ELEMENT new = malloc(sizeof(*new));
+	ELEMENT new = MALLOC(sizeof(*new));
 
-	new->hash = malloc(sizeof(char) * strlen(hash) + 1);
+	new->hash = MALLOC(sizeof(char) * strlen(hash) + 1);
 	strcpy(new->hash, hash);
 	new->content = content;
 
@@ -277,10 +298,31 @@ static void quicksort(SET set, int begin, int end, compare_t comparator, void* a
 static void quicksortByName(SET set, int begin, int end) {
 	int lim;
 
-	if (begin < end) {
+	while (begin < end) {
+		pivotByName(set, begin, end);
 		lim = partitionByName(set, begin, end);
 		
-		quicksortByName(set, begin, lim-1);
-		quicksortByName(set, lim+1, end);
+		/* Só a parte menor é ordenada recursivamente, o que limita a pilha a log n */
+		if (lim - begin < end - lim) {
+			quicksortByName(set, begin, lim-1);
+			begin = lim+1;
+		} else {
+			quicksortByName(set, lim+1, end);
+			end = lim-1;
+		}
 	}
 }
+
+/**
+ * Coloca no fim do intervalo a mediana do primeiro, do último e do elemento do meio,
+ * para que sets já ordenados não levem a partições com um só elemento.
+ */
+static void pivotByName(SET set, int begin, int end) {
+	int mid = begin + (end - begin) / 2;
+
+	if (strcmp(HASH(set, mid), HASH(set, begin)) < 0) swapData(set, mid, begin);
+	if (strcmp(HASH(set, end), HASH(set, begin)) < 0) swapData(set, end, begin);
+	if (strcmp(HASH(set, end), HASH(set, mid)) < 0) swapData(set, end, mid);
+
+	swapData(set, mid, end);
+}
@@ -82,6 +82,12 @@ SET diffSets(SET s1, SET s2);
  */
 SET intersectSet(SET s1, SET s2);
 
+/**
+ * Move todos os elementos de src para o fim de dest, mantendo a ordem, e liberta src.
+ * O conteúdo dos elementos passa a ser libertado pela função free de dest.
+ */
+SET appendSet(SET dest, SET src);
+
 /**
  * Liberta toda a memória associada a um conjunto de dados. Se o set tiver sido 
  * inicializado com uma função free válida, o conteúdo de cada elemente será também
@@ -89,4 +95,56 @@ SET intersectSet(SET s1, SET s2);
  */
 void freeSet(SET s);
 
+/* Intervalos com menos elementos do que isto são ordenados por inserção em SORT_OF */
+#define SORT_OF_SMALL 16
+#define SORT_OF_SWAP(v, i, j, tmp) { tmp = v[i]; v[i] = v[j]; v[j] = tmp; }
+
+/**
+ * Gera uma função static void NAME(TYPE* v, int begin, int end), que ordena por ordem
+ * crescente os elementos de v entre as posições begin e end, inclusive. É a versão de
+ * sortSet para arrays de um tipo conhecido: LESS(a, b), que recebe dois elementos e
+ * verifica se a deve ficar antes de b, é expandida no local em vez de ser chamada
+ * através de um compare_t, e os elementos são trocados por valor.
+ */
+#define SORT_OF(NAME, TYPE, LESS)                                                      \
+static void NAME(TYPE* v, int begin, int end) {                                        \
+	TYPE tmp;                                                                          \
+	int i, j, mid, lim;                                                                \
+                                                                                       \
+	while (end - begin >= SORT_OF_SMALL) {                                             \
+		mid = begin + (end - begin) / 2;                                               \
+                                                                                       \
+		/* Mediana do primeiro, do último e do elemento do meio como pivot, no fim */  \
+		if (LESS(v[mid], v[begin])) SORT_OF_SWAP(v, mid, begin, tmp);                  \
+		if (LESS(v[end], v[begin])) SORT_OF_SWAP(v, end, begin, tmp);                  \
+		if (LESS(v[end], v[mid])) SORT_OF_SWAP(v, end, mid, tmp);                      \
+		SORT_OF_SWAP(v, mid, end, tmp);                                                \
+                                                                                       \
+		for(lim = begin - 1, i = begin; i < end; i++)                                  \
+			if (!(LESS(v[end], v[i]))) {                                               \
+				lim++;                                                                 \
+				SORT_OF_SWAP(v, lim, i, tmp);                                          \
+			}                                                                          \
+                                                                                       \
+		SORT_OF_SWAP(v, lim + 1, end, tmp);                                            \
+		lim++;                                                                         \
+                                                                                       \
+		/* Só a parte menor é ordenada recursivamente, o que limita a pilha a log n */ \
+		if (lim - begin < end - lim) {                                                 \
+			NAME(v, begin, lim - 1);                                                   \
+			begin = lim + 1;                                                           \
+		} else {                                                                       \
+			NAME(v, lim + 1, end);                                                     \
+			end = lim - 1;                                                             \
+		}                                                                              \
+	}                                                                                  \
+                                                                                       \
+	for(i = begin + 1; i <= end; i++) {                                                \
+		tmp = v[i];                                                                    \
+		for(j = i; j > begin && LESS(tmp, v[j - 1]); j--)                              \
+			v[j] = v[j - 1];                                                           \
+		v[j] = tmp;                                                                    \
+	}                                                                                  \
+}
+
 #endif
@@ -0,0 +1,467 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "threadpool.h"
+#include "memstat.h"
+
+#define MEMSTAT_TAG MEM_OTHER
+
+#define BASE_DEQUE 64
+
+/* Contadores partilhados pelos trabalhadores, atualizados sem o lock do conjunto */
+#define ATOMIC_ADD(counter, n) __sync_add_and_fetch(&(counter), (n))
+#define ATOMIC_GET(counter) __sync_add_and_fetch(&(counter), 0)
+
+/* Um parallelFor em curso; as suas tarefas cobrem intervalos de pedaços */
+typedef struct range_job {
+	range_t body;
+	void* arg;
+	int begin, end, grain;
+}*RANGEJOB;
+
+/*
+ * Uma tarefa é uma função submetida com submitTask ou, se job não for NULL, os pedaços
+ * [first, last) de um parallelFor.
+ */
+typedef struct task {
+	task_t run;
+	void* arg;
+	RANGEJOB job;
+	int first, last;
+}*TASK;
+
+/*
+ * Fila de tarefas de um trabalhador, num array circular. O dono coloca e retira
+ * tarefas no fim (bottom); os outros roubam do início (top), onde estão as tarefas
+ * mais antigas e, nos parallelFor, os maiores intervalos.
+ */
+typedef struct deque {
+	TASK *tasks;
+	int top, bottom;
+	int capacity;
+	pthread_mutex_t lock;
+}*DEQUE;
+
+/* Argumento de cada trabalhador */
+struct worker_arg {
+	THREADPOOL pool;
+	int id;
+};
+
+struct threadpool {
+	pthread_t *threads;
+	struct worker_arg *args;
+	int workers;
+
+	/* Uma fila por trabalhador, mais uma (a última) para quem submete e espera */
+	struct deque *deques;
+	int ndeques;
+
+	long queued;    /* tarefas nas filas */
+	long pending;   /* tarefas submetidas que ainda não terminaram */
+	long tasks;
+	long steals;
+	long idle;      /* tempo parado enquanto havia tarefas por terminar */
+	int stop;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work;   /* sinalizada quando há tarefas nas filas ou pending chega a 0 */
+	pthread_cond_t done;   /* sinalizada quando pending chega a 0 */
+};
+
+static void* worker(void* arg);
+static TASK newTask(task_t run, void* arg, RANGEJOB job, int first, int last);
+static void pushTask(THREADPOOL pool, int id, TASK task);
+static TASK takeTask(THREADPOOL pool, int id);
+static void runTask(THREADPOOL pool, int id, TASK task);
+static void runRange(THREADPOOL pool, int id, RANGEJOB job, int first, int last);
+static void initDeque(DEQUE d);
+static void pushBottom(DEQUE d, TASK task);
+static TASK popBottom(DEQUE d);
+static TASK popTop(DEQUE d);
+static void freeDeque(DEQUE d);
+static long now();
+static int countProcessors();
+
+THREADPOOL initThreadPool(int workers) {
+	THREADPOOL new = MALLOC(sizeof(*new));
+	int i;
+
+	if (workers < 1) workers = countProcessors();
+	if (workers > MAX_WORKERS) workers = MAX_WORKERS;
+
+	new->threads = MALLOC(sizeof(pthread_t) * workers);
+	new->args = MALLOC(sizeof(struct worker_arg) * workers);
+	new->ndeques = workers + 1;
+	new->deques = MALLOC(sizeof(struct deque) * new->ndeques);
+	new->queued = new->pending = 0;
+	new->tasks = new->steals = new->idle = 0;
+	new->stop = 0;
+
+	for(i = 0; i < new->ndeques; i++)
+		initDeque(&new->deques[i]);
+
+	pthread_mutex_init(&new->lock, NULL);
+	pthread_cond_init(&new->work, NULL);
+	pthread_cond_init(&new->done, NULL);
+
+	/*
+	 * Se não for possível criar algum trabalhador, fica-se com os que foram criados. As
+	 * filas dos que faltam ficam sempre vazias.
+	 */
+	/* Os argumentos pertencem ao conjunto: um trabalhador que ainda esteja a arrancar
+	 * não liberta memória, pelo que não concorre com quem muda a região em uso */
+	for(i = 0; i < workers; i++) {
+		new->args[i].pool = new;
+		new->args[i].id = i;
+
+		if (pthread_create(&new->threads[i], NULL, worker, &new->args[i]))
+			break;
+	}
+
+	new->workers = i;
+
+	return new;
+}
+
+THREADPOOL submitTask(THREADPOOL pool, task_t task, void* arg) {
+	if (pool->workers == 0) {
+		task(arg);
+		ATOMIC_ADD(pool->tasks, 1);
+		return pool;
+	}
+
+	pushTask(pool, pool->ndeques - 1, newTask(task, arg, NULL, 0, 0));
+
+	return pool;
+}
+
+THREADPOOL waitThreadPool(THREADPOOL pool) {
+	TASK task;
+	int id = pool->ndeques - 1;
+
+	while(1) {
+		if ((task = takeTask(pool, id))) {
+			runTask(pool, id, task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+
+		if (ATOMIC_GET(pool->pending) == 0) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+
+		/* As tarefas que faltam estão a ser executadas pelos trabalhadores */
+		if (ATOMIC_GET(pool->queued) == 0)
+			pthread_cond_wait(&pool->done, &pool->lock);
+
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return pool;
+}
+
+THREADPOOL parallelFor(THREADPOOL pool, int begin, int end, int grain, range_t body,
+                                                                       void* arg) {
+	struct range_job job;
+	int chunks, i;
+
+	if (grain < 1) grain = 1;
+	if (end <= begin) return pool;
+
+	if (!pool || pool->workers == 0) {
+		for(i = begin; i < end; i += grain)
+			body(arg, i, (end - i > grain) ? i + grain : end);
+
+		if (pool) ATOMIC_ADD(pool->tasks, (end - begin + grain - 1) / grain);
+		return pool;
+	}
+
+	job.body = body;
+	job.arg = arg;
+	job.begin = begin;
+	job.end = end;
+	job.grain = grain;
+	chunks = (end - begin + grain - 1) / grain;
+
+	pushTask(pool, pool->ndeques - 1, newTask(NULL, NULL, &job, 0, chunks));
+
+	return waitThreadPool(pool);
+}
+
+int getThreadPoolWorkers(THREADPOOL pool) {
+	return pool->workers;
+}
+
+long getThreadPoolTasks(THREADPOOL pool) {
+	return ATOMIC_GET(pool->tasks);
+}
+
+long getThreadPoolSteals(THREADPOOL pool) {
+	return ATOMIC_GET(pool->steals);
+}
+
+long getThreadPoolIdleTime(THREADPOOL pool) {
+	long idle;
+
+	pthread_mutex_lock(&pool->lock);
+	idle = pool->idle;
+	pthread_mutex_unlock(&pool->lock);
+
+	return idle;
+}
+
+void freeThreadPool(THREADPOOL pool) {
+	int i;
+
+	if (pool) {
+		waitThreadPool(pool);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->stop = 1;
+		pthread_cond_broadcast(&pool->work);
+		pthread_mutex_unlock(&pool->lock);
+
+		for(i = 0; i < pool->workers; i++)
+			pthread_join(pool->threads[i], NULL);
+
+		for(i = 0; i < pool->ndeques; i++)
+			freeDeque(&pool->deques[i]);
+
+		pthread_mutex_destroy(&pool->lock);
+		pthread_cond_destroy(&pool->work);
+		pthread_cond_destroy(&pool->done);
+
+		FREE(pool->deques);
+		FREE(pool->threads);
+		FREE(pool->args);
+		FREE(pool);
+	}
+}
+
+/**
+ * Ciclo de cada trabalhador: executa tarefas da sua fila ou roubadas das outras, e
+ * fica parado quando não há nenhuma, até o conjunto ser terminado.
+ */
+static void* worker(void* arg) {
+	THREADPOOL pool = ((struct worker_arg*) arg)->pool;
+	int id = ((struct worker_arg*) arg)->id;
+	TASK task;
+	long start;
+	bool starved;
+
+	while(1) {
+		if ((task = takeTask(pool, id))) {
+			runTask(pool, id, task);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+
+		/* Só conta como tempo parado a espera enquanto outros executam tarefas que o
+		 * trabalhador não pode roubar; entre tarefas submetidas o conjunto está livre */
+		while(ATOMIC_GET(pool->queued) == 0 && !pool->stop) {
+			starved = (ATOMIC_GET(pool->pending) > 0);
+			start = now();
+			pthread_cond_wait(&pool->work, &pool->lock);
+			if (starved) pool->idle += now() - start;
+		}
+
+		if (ATOMIC_GET(pool->queued) == 0 && pool->stop) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
+
+static TASK newTask(task_t run, void* arg, RANGEJOB job, int first, int last) {
+	TASK new = MALLOC(sizeof(*new));
+
+	new->run = run;
+	new->arg = arg;
+	new->job = job;
+	new->first = first;
+	new->last = last;
+
+	return new;
+}
+
+/**
+ * Coloca uma tarefa na fila dada e acorda um trabalhador parado.
+ */
+static void pushTask(THREADPOOL pool, int id, TASK task) {
+	ATOMIC_ADD(pool->pending, 1);
+	pushBottom(&pool->deques[id], task);
+	ATOMIC_ADD(pool->queued, 1);
+
+	pthread_mutex_lock(&pool->lock);
+	pthread_cond_signal(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Retira a tarefa mais recente da fila dada ou, se esta estiver vazia, rouba a mais
+ * antiga de outra fila.
+ * @return Tarefa retirada, ou NULL se todas as filas estiverem vazias
+ */
+static TASK takeTask(THREADPOOL pool, int id) {
+	TASK task;
+	int i, deques = pool->ndeques;
+
+	if ((task = popBottom(&pool->deques[id]))) {
+		ATOMIC_ADD(pool->queued, -1);
+		return task;
+	}
+
+	for(i = 1; i < deques; i++) {
+		if ((task = popTop(&pool->deques[(id + i) % deques]))) {
+			ATOMIC_ADD(pool->queued, -1);
+			ATOMIC_ADD(pool->steals, 1);
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+static void runTask(THREADPOOL pool, int id, TASK task) {
+	if (task->job)
+		runRange(pool, id, task->job, task->first, task->last);
+	else {
+		task->run(task->arg);
+		ATOMIC_ADD(pool->tasks, 1);
+	}
+
+	FREE(task);
+
+	if (ATOMIC_ADD(pool->pending, -1) == 0) {
+		pthread_mutex_lock(&pool->lock);
+		pthread_cond_broadcast(&pool->done);
+		pthread_cond_broadcast(&pool->work);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/**
+ * Executa os pedaços [first, last) de um parallelFor. Enquanto houver mais do que um
+ * pedaço, a segunda metade é colocada na fila do trabalhador, onde pode ser roubada.
+ */
+static void runRange(THREADPOOL pool, int id, RANGEJOB job, int first, int last) {
+	int mid, begin, end;
+
+	while(last - first > 1) {
+		mid = first + (last - first) / 2;
+		pushTask(pool, id, newTask(NULL, NULL, job, mid, last));
+		last = mid;
+	}
+
+	begin = job->begin + first * job->grain;
+	end = begin + job->grain;
+	if (end > job->end) end = job->end;
+
+	job->body(job->arg, begin, end);
+	ATOMIC_ADD(pool->tasks, 1);
+}
+
+/************************** DEQUE *****************************/
+
+static void initDeque(DEQUE d) {
+	d->tasks = MALLOC(sizeof(TASK) * BASE_DEQUE);
+	d->top = d->bottom = 0;
+	d->capacity = BASE_DEQUE;
+	pthread_mutex_init(&d->lock, NULL);
+}
+
+static void pushBottom(DEQUE d, TASK task) {
+	TASK *tasks;
+	int i, size;
+
+	pthread_mutex_lock(&d->lock);
+
+	size = d->bottom - d->top;
+	if (size == d->capacity) {
+		tasks = MALLOC(sizeof(TASK) * d->capacity * 2);
+		for(i = 0; i < size; i++)
+			tasks[i] = d->tasks[(d->top + i) % d->capacity];
+
+		FREE(d->tasks);
+		d->tasks = tasks;
+		d->capacity *= 2;
+		d->top = 0;
+		d->bottom = size;
+	}
+
+	d->tasks[d->bottom % d->capacity] = task;
+	d->bottom++;
+
+	pthread_mutex_unlock(&d->lock);
+}
+
+static TASK popBottom(DEQUE d) {
+	TASK task = NULL;
+
+	pthread_mutex_lock(&d->lock);
+
+	if (d->bottom > d->top) {
+		d->bottom--;
+		task = d->tasks[d->bottom % d->capacity];
+
+		if (d->top == d->bottom)
+			d->top = d->bottom = 0;
+	}
+
+	pthread_mutex_unlock(&d->lock);
+
+	return task;
+}
+
+static TASK popTop(DEQUE d) {
+	TASK task = NULL;
+
+	pthread_mutex_lock(&d->lock);
+
+	if (d->bottom > d->top) {
+		task = d->tasks[d->top % d->capacity];
+		d->top++;
+
+		/* Mantém os índices pequenos, para não excederem o limite de um int */
+		if (d->top == d->bottom)
+			d->top = d->bottom = 0;
+	}
+
+	pthread_mutex_unlock(&d->lock);
+
+	return task;
+}
+
+static void freeDeque(DEQUE d) {
+	FREE(d->tasks);
+	pthread_mutex_destroy(&d->lock);
+}
+
+/**
+ * Tempo atual em nanossegundos, medido por um relógio monótono.
+ */
+static long now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+static int countProcessors() {
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return (n < 1) ? 1 : (int) n;
+}
@@ -0,0 +1,81 @@
+#ifndef __THREADPOOL__
+#define __THREADPOOL__
+
+typedef struct threadpool *THREADPOOL;
+
+/** Tarefa executada por um dos trabalhadores, que recebe o argumento dado na submissão */
+typedef void (*task_t)(void*);
+
+/** Corpo de um parallelFor, chamado com o argumento dado e um intervalo [begin, end) */
+typedef void (*range_t)(void* arg, int begin, int end);
+
+/** Número máximo de trabalhadores de um conjunto */
+#define MAX_WORKERS 64
+
+/**
+ * Inicia um conjunto de trabalhadores (threads) que executam as tarefas submetidas.
+ * Cada trabalhador tem a sua própria fila de tarefas; quando esta fica vazia, o
+ * trabalhador rouba tarefas das filas dos outros (work stealing).
+ * @param workers Número de trabalhadores. Se for menor do que 1 é usado o número de
+ * processadores disponíveis
+ */
+THREADPOOL initThreadPool(int workers);
+
+/**
+ * Submete uma tarefa para ser executada por um dos trabalhadores. Se o conjunto não
+ * tiver trabalhadores, a tarefa é executada imediatamente por quem a submeteu.
+ */
+THREADPOOL submitTask(THREADPOOL pool, task_t task, void* arg);
+
+/**
+ * Espera que todas as tarefas submetidas terminem, executando também tarefas enquanto
+ * espera. Não deve ser chamada a partir de uma tarefa, nem por mais do que uma thread
+ * ao mesmo tempo.
+ */
+THREADPOOL waitThreadPool(THREADPOOL pool);
+
+/**
+ * Divide o intervalo [begin, end) em pedaços de grain elementos e chama body sobre cada
+ * um deles, em paralelo, esperando que todos terminem. O intervalo é dividido ao meio
+ * sucessivamente, pelo que um trabalhador sem tarefas rouba sempre a maior parte que
+ * ainda não foi começada: pedaços com custos muito diferentes não deixam trabalhadores
+ * parados.
+ *
+ * Os pedaços começam sempre em begin + k * grain, independentemente do número de
+ * trabalhadores, o que permite guardar um resultado parcial por pedaço e juntá-los por
+ * ordem no fim. Tal como waitThreadPool, não pode ser chamada a partir de uma tarefa.
+ * @param pool Trabalhadores a usar; se for NULL os pedaços são executados por ordem
+ */
+THREADPOOL parallelFor(THREADPOOL pool, int begin, int end, int grain, range_t body,
+                                                                       void* arg);
+
+/**
+ * Determina o número de trabalhadores do conjunto.
+ */
+int getThreadPoolWorkers(THREADPOOL pool);
+
+/**
+ * Determina o número de tarefas executadas até ao momento, incluindo os pedaços dos
+ * parallelFor.
+ */
+long getThreadPoolTasks(THREADPOOL pool);
+
+/**
+ * Determina o número de tarefas que foram roubadas da fila de outro trabalhador.
+ */
+long getThreadPoolSteals(THREADPOOL pool);
+
+/**
+ * Determina o tempo total, em nanossegundos, que os trabalhadores passaram parados sem
+ * tarefas para executar enquanto outras tarefas submetidas ainda não tinham terminado.
+ * O tempo entre execuções, sem tarefas submetidas, não é contado.
+ */
+long getThreadPoolIdleTime(THREADPOOL pool);
+
+/**
+ * Termina os trabalhadores, depois de executadas as tarefas pendentes, e liberta o
+ * conjunto.
+ */
+void freeThreadPool(THREADPOOL pool);
+
+#endif
@@ -0,0 +1,481 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "avl.h"
+#include "hashT.h"
+#include "set.h"
+#include "catalog.h"
+#include "memstat.h"
+
+/*
+ * Micro-benchmarks dos contentores do gereVendas. Cada medição corre sobre n códigos
+ * com o formato dos produtos, por três ordens: sequencial (alfabética), aleatória e
+ * Zipf (n acessos a códigos escolhidos com popularidade de Zipf, com repetições).
+ *
+ * O resultado é um CSV com uma linha por medição e ordem:
+ *   benchmark,order,n,ns_per_op,ops_per_s,bytes_per_op,allocs_per_op
+ * O tempo é o melhor de várias repetições; os bytes e as alocações são contados pelo
+ * memstat e não dependem da máquina, pelo que podem ser comparados entre versões.
+ */
+
+#define DEFAULT_N    100000
+#define DEFAULT_REPS 5
+#define DEFAULT_SEED 2016
+#define ZIPF_SKEW    1.0
+
+#define LETTERS 26
+#define NUMBERS 9000
+#define FIRST_NUMBER 1000
+#define CODE_SIZE 8
+
+#define MASK 0xFFFFFFFFUL
+
+/* Chaves de uma medição */
+struct keys {
+	char** order;    /* chaves pela ordem da medição (com repetições na Zipf) */
+	char** sorted;   /* chaves distintas por ordem alfabética */
+	int n;
+	char* codes;
+};
+
+/* Dois sets ordenados, para as medições de união e interseção */
+struct set_pair {
+	SET a, b;
+};
+
+typedef void* (*prepare_t)(struct keys*);
+typedef void* (*run_t)    (struct keys*, void*);
+typedef void  (*cleanup_t)(void*, void*);
+
+/**
+ * Uma medição: prepare cria, fora do tempo medido, os dados de que run precisa; run
+ * executa n operações e devolve o que criou, que é libertado por cleanup juntamente
+ * com os dados preparados.
+ */
+struct benchmark {
+	char* name;
+	prepare_t prepare;
+	run_t run;
+	cleanup_t cleanup;
+};
+
+/* Gerador xorshift128 com palavras de 32 bits, como em geraDados */
+struct rng {
+	unsigned long x, y, z, w;
+};
+
+static unsigned long nextRng(struct rng* r);
+static double uniform(struct rng* r);
+
+static struct keys* makeKeys(int n, char* order, unsigned long seed);
+static void freeKeys(struct keys* k);
+static void measure(struct benchmark* b, struct keys* k, char* order, int reps);
+static double now();
+
+static void* runAVLinsert(struct keys* k, void* input);
+static void* prepareAVL(struct keys* k);
+static void* runAVLlookup(struct keys* k, AVL tree);
+static void cleanupAVL(AVL input, AVL output);
+
+static void* runHashTinsert(struct keys* k, void* input);
+static void* prepareHashT(struct keys* k);
+static void* runHashTlookup(struct keys* k, HASHT ht);
+static void cleanupHashT(HASHT input, HASHT output);
+
+static void* runSetInsert(struct keys* k, void* input);
+static void* prepareSet(struct keys* k);
+static void* runSetSort(struct keys* k, SET s);
+static void* prepareUnion(struct keys* k);
+static void* prepareIntersect(struct keys* k);
+static void* runSetUnion(struct keys* k, struct set_pair* p);
+static void* runSetIntersect(struct keys* k, struct set_pair* p);
+static void cleanupSet(SET input, SET output);
+static void cleanupPair(struct set_pair* input, SET output);
+
+static int* cloneInt(int* i);
+static bool isEven(int* i, void* arg);
+static void* dumpInt(int* i, void* arg);
+static void* prepareCatalog(struct keys* k);
+static void* runCatalogClone(struct keys* k, CATALOG cat);
+static void* runCatalogFilter(struct keys* k, CATALOG cat);
+static void* runCatalogDump(struct keys* k, CATALOG cat);
+static void cleanupCatalog(CATALOG input, CATALOG output);
+static void cleanupCatalogSet(CATALOG input, SET output);
+
+static struct benchmark benchmarks[] = {
+	{"avl_insert", NULL, runAVLinsert, (cleanup_t) cleanupAVL},
+	{"avl_lookup", prepareAVL, (run_t) runAVLlookup, (cleanup_t) cleanupAVL},
+	{"hasht_insert", NULL, runHashTinsert, (cleanup_t) cleanupHashT},
+	{"hasht_lookup", prepareHashT, (run_t) runHashTlookup, (cleanup_t) cleanupHashT},
+	{"set_insert", NULL, runSetInsert, (cleanup_t) cleanupSet},
+	{"set_sort", prepareSet, (run_t) runSetSort, (cleanup_t) cleanupSet},
+	{"set_union", prepareUnion, (run_t) runSetUnion, (cleanup_t) cleanupPair},
+	{"set_intersect", prepareIntersect, (run_t) runSetIntersect, (cleanup_t) cleanupPair},
+	{"catalog_clone", prepareCatalog, (run_t) runCatalogClone, (cleanup_t) cleanupCatalog},
+	{"catalog_filter", prepareCatalog, (run_t) runCatalogFilter, (cleanup_t) cleanupCatalogSet},
+	{"catalog_dump", prepareCatalog, (run_t) runCatalogDump, (cleanup_t) cleanupCatalogSet},
+	{NULL, NULL, NULL, NULL}
+};
+
+static char* orders[] = {"seq", "rand", "zipf", NULL};
+
+int main(int argc, char** argv) {
+	struct keys* k;
+	char* only = NULL;
+	int i, j, n = DEFAULT_N, reps = DEFAULT_REPS;
+
+	for(i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && i + 1 < argc) n = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc) reps = atoi(argv[++i]);
+		else if (argv[i][0] != '-') only = argv[i];
+		else n = 0;
+	}
+
+	if (n < 2 || reps < 1) {
+		fprintf(stderr, "Uso: %s [-n chaves (%d)] [-r repetições (%d)] [prefixo]\n",
+		        argv[0], DEFAULT_N, DEFAULT_REPS);
+		return 1;
+	}
+
+	printf("benchmark,order,n,ns_per_op,ops_per_s,bytes_per_op,allocs_per_op\n");
+
+	for(j = 0; orders[j]; j++) {
+		k = makeKeys(n, orders[j], DEFAULT_SEED);
+
+		for(i = 0; benchmarks[i].name; i++)
+			if (!only || !strncmp(benchmarks[i].name, only, strlen(only)))
+				measure(&benchmarks[i], k, orders[j], reps);
+
+		freeKeys(k);
+	}
+
+	return 0;
+}
+
+static unsigned long nextRng(struct rng* r) {
+	unsigned long t = (r->x ^ (r->x << 11)) & MASK;
+
+	r->x = r->y;
+	r->y = r->z;
+	r->z = r->w;
+	r->w = (r->w ^ (r->w >> 19) ^ t ^ (t >> 8)) & MASK;
+
+	return r->w;
+}
+
+static double uniform(struct rng* r) {
+	return nextRng(r) / 4294967296.0;
+}
+
+static int compareKeys(const void* a, const void* b) {
+	return strcmp(*(char**) a, *(char**) b);
+}
+
+/**
+ * Cria n códigos distintos de produtos, espalhados pelo espaço de códigos, e a sequência
+ * de acessos da ordem pedida.
+ */
+static struct keys* makeKeys(int n, char* order, unsigned long seed) {
+	struct keys* k = malloc(sizeof(*k));
+	struct rng r;
+	double *cdf, sum = 0, u;
+	long code, space = (long) LETTERS * LETTERS * NUMBERS;
+	int i, j, lo, hi;
+	char* tmp;
+
+	r.x = 123456789UL ^ seed;
+	r.y = 362436069UL;
+	r.z = 521288629UL;
+	r.w = 88675123UL;
+
+	k->n = n;
+	k->codes = malloc((size_t) n * CODE_SIZE);
+	k->sorted = malloc(sizeof(char*) * n);
+	k->order = malloc(sizeof(char*) * n);
+
+	for(i = 0; i < n; i++) {
+		code = (long) ((double) i * space / n);
+		sprintf(k->codes + i * CODE_SIZE, "%c%c%ld",
+		        (int) ('A' + code / NUMBERS / LETTERS),
+		        (int) ('A' + code / NUMBERS % LETTERS), FIRST_NUMBER + code % NUMBERS);
+		k->sorted[i] = k->order[i] = k->codes + i * CODE_SIZE;
+	}
+
+	qsort(k->sorted, n, sizeof(char*), compareKeys);
+	memcpy(k->order, k->sorted, sizeof(char*) * n);
+
+	if (!strcmp(order, "rand")) {
+		for(i = n - 1; i > 0; i--) {
+			j = (int) (uniform(&r) * (i + 1));
+			tmp = k->order[i];
+			k->order[i] = k->order[j];
+			k->order[j] = tmp;
+		}
+	}
+	else if (!strcmp(order, "zipf")) {
+		cdf = malloc(sizeof(double) * n);
+
+		for(i = 0; i < n; i++)
+			cdf[i] = (sum += 1.0 / pow(i + 1, ZIPF_SKEW));
+
+		/* A popularidade segue uma permutação fixa das chaves, e não a ordem alfabética */
+		for(i = 0; i < n; i++) {
+			u = uniform(&r) * sum;
+			for(lo = 0, hi = n - 1; lo < hi; )
+				if (cdf[(lo + hi) / 2] < u) lo = (lo + hi) / 2 + 1;
+				else hi = (lo + hi) / 2;
+
+			k->order[i] = k->sorted[(int) ((lo * 2654435761UL) % n)];
+		}
+
+		free(cdf);
+	}
+
+	return k;
+}
+
+static void freeKeys(struct keys* k) {
+	free(k->codes);
+	free(k->sorted);
+	free(k->order);
+	free(k);
+}
+
+static double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void measure(struct benchmark* b, struct keys* k, char* order, int reps) {
+	void *input, *output;
+	double start, ns, best = -1;
+	long allocs = 0, bytes = 0;
+	int i;
+
+	for(i = 0; i < reps; i++) {
+		input = b->prepare ? b->prepare(k) : NULL;
+
+		allocs = getAllocCount();
+		bytes = getAllocBytes();
+		start = now();
+
+		output = b->run(k, input);
+
+		ns = now() - start;
+		allocs = getAllocCount() - allocs;
+		bytes = getAllocBytes() - bytes;
+
+		b->cleanup(input, output);
+
+		if (best < 0 || ns < best) best = ns;
+	}
+
+	printf("%s,%s,%d,%.1f,%.0f,%.1f,%.3f\n", b->name, order, k->n, best / k->n,
+	       k->n / (best / 1e9), (double) bytes / k->n, (double) allocs / k->n);
+}
+
+/* AVL */
+
+static void* runAVLinsert(struct keys* k, void* input) {
+	AVL tree = initAVL(NULL, NULL, NULL);
+	int i;
+
+	(void) input;
+
+	for(i = 0; i < k->n; i++)
+		tree = insertAVL(tree, k->order[i], NULL);
+
+	return tree;
+}
+
+static void* prepareAVL(struct keys* k) {
+	return runAVLinsert(k, NULL);
+}
+
+static void* runAVLlookup(struct keys* k, AVL tree) {
+	int i;
+
+	for(i = 0; i < k->n; i++)
+		getAVLcontent(tree, k->order[i], NULL);
+
+	return NULL;
+}
+
+static void cleanupAVL(AVL input, AVL output) {
+	if (input) freeAVL(input);
+	if (output) freeAVL(output);
+}
+
+/* Tabela de hash */
+
+static void* runHashTinsert(struct keys* k, void* input) {
+	HASHT ht = initHashT(512, NULL, NULL, NULL, NULL);
+	int i;
+
+	(void) input;
+
+	for(i = 0; i < k->n; i++)
+		ht = insertHashT(ht, k->order[i], NULL);
+
+	return ht;
+}
+
+static void* prepareHashT(struct keys* k) {
+	return runHashTinsert(k, NULL);
+}
+
+static void* runHashTlookup(struct keys* k, HASHT ht) {
+	int i;
+
+	for(i = 0; i < k->n; i++)
+		getHashTcontent(ht, k->order[i]);
+
+	return NULL;
+}
+
+static void cleanupHashT(HASHT input, HASHT output) {
+	freeHashT(input);
+	freeHashT(output);
+}
+
+/* Sets */
+
+static void* runSetInsert(struct keys* k, void* input) {
+	SET s = initSet(16, NULL);
+	int i;
+
+	(void) input;
+
+	for(i = 0; i < k->n; i++)
+		s = insertElement(s, k->order[i], NULL);
+
+	return s;
+}
+
+static void* prepareSet(struct keys* k) {
+	return runSetInsert(k, NULL);
+}
+
+static void* runSetSort(struct keys* k, SET s) {
+	(void) k;
+
+	sortSetByName(s);
+	return NULL;
+}
+
+/**
+ * Cria dois sets ordenados com as chaves [0, split) e [from, n) da ordem da medição.
+ */
+static struct set_pair* makePair(struct keys* k, int split, int from) {
+	struct set_pair* p = malloc(sizeof(*p));
+	int i;
+
+	p->a = initSet(split + 1, NULL);
+	p->b = initSet(k->n - from + 1, NULL);
+
+	for(i = 0; i < split; i++)
+		p->a = insertElement(p->a, k->order[i], NULL);
+
+	for(i = from; i < k->n; i++)
+		p->b = insertElement(p->b, k->order[i], NULL);
+
+	sortSetByName(p->a);
+	sortSetByName(p->b);
+
+	return p;
+}
+
+static void* prepareUnion(struct keys* k) {
+	return makePair(k, k->n / 2, k->n / 2);
+}
+
+static void* prepareIntersect(struct keys* k) {
+	return makePair(k, 2 * k->n / 3, k->n / 3);
+}
+
+static void* runSetUnion(struct keys* k, struct set_pair* p) {
+	(void) k;
+
+	return unionSets(p->a, p->b);
+}
+
+static void* runSetIntersect(struct keys* k, struct set_pair* p) {
+	(void) k;
+
+	return intersectSet(p->a, p->b);
+}
+
+static void cleanupSet(SET input, SET output) {
+	freeSet(input);
+	freeSet(output);
+}
+
+static void cleanupPair(struct set_pair* input, SET output) {
+	freeSet(input->a);
+	freeSet(input->b);
+	free(input);
+	freeSet(output);
+}
+
+/* Catálogo, com um inteiro como conteúdo de cada elemento */
+
+static int* cloneInt(int* i) {
+	int* new = malloc(sizeof(int));
+
+	*new = *i;
+	return new;
+}
+
+static bool isEven(int* i, void* arg) {
+	(void) arg;
+
+	return *i % 2 == 0;
+}
+
+static void* dumpInt(int* i, void* arg) {
+	(void) arg;
+
+	return i;
+}
+
+static void* prepareCatalog(struct keys* k) {
+	CATALOG cat = initCatalog(LETTERS, (clone_t) cloneInt, free);
+	int i;
+
+	for(i = 0; i < k->n; i++)
+		if (!lookUpCatalog(cat, k->order[i]))
+			cat = insertCatalog(cat, k->order[i], cloneInt(&i));
+
+	return cat;
+}
+
+static void* runCatalogClone(struct keys* k, CATALOG cat) {
+	(void) k;
+
+	return cloneCatalog(cat);
+}
+
+static void* runCatalogFilter(struct keys* k, CATALOG cat) {
+	return filterCat(cat, initSet(k->n, NULL), (condition_t) isEven, NULL);
+}
+
+static void* runCatalogDump(struct keys* k, CATALOG cat) {
+	return dumpCatalog(cat, initSet(k->n, NULL), (void* (*)(void*, void*)) dumpInt, NULL);
+}
+
+static void cleanupCatalog(CATALOG input, CATALOG output) {
+	freeCatalog(input);
+	freeCatalog(output);
+}
+
+static void cleanupCatalogSet(CATALOG input, SET output) {
+	freeCatalog(input);
+	freeSet(output);
+}
@@ -0,0 +1,1424 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "avl.h"
+#include "bloom.h"
+#include "cache.h"
+#include "catalog.h"
+#include "cursor.h"
+#include "dataloader.h"
+#include "engine.h"
+#include "perfecthash.h"
+#include "products.h"
+#include "ranking.h"
+#include "threadpool.h"
+#include "memstat.h"
+#include "region.h"
+
+/*
+ * Verificações das estruturas do gereVendas cujo comportamento não se vê no resultado
+ * das queries. Cada verificação corre por si e escreve uma linha com o nome e "ok", ou
+ * com o número de condições falhadas, cada uma delas indicada no stderr. O programa
+ * termina com 1 se alguma falhar.
+ *
+ * O make compila sempre as verificações com MEMSTAT. Sem ele, os contadores do memstat
+ * são sempre 0, pelo que as condições que esperam que mudem (CHECK_COUNT) só são
+ * verificadas com MEMSTAT.
+ *
+ * As verificações com várias threads servem também para procurar corridas, compilando
+ * com o ThreadSanitizer:
+ *   make clear; make check CFLAGS="-g -O1 -pthread -fsanitize=thread" \
+ *                          LDFLAGS="-pthread -fsanitize=thread"
+ */
+
+#define LETTERS 26
+#define CODE_SIZE 16
+
+/* Região pequena, que enche com poucos blocos */
+#define SMALL_REGION (64 * 1024)
+#define OVERFLOW_BLOCKS 32
+#define OVERFLOW_CODES 20000
+#define LARGE_BLOCK 20000
+
+/* Catálogo concorrente: escritores a inserir e atualizar, leitores a percorrer */
+#define WRITERS 4
+#define READERS 2
+#define CONCURRENT_CODES 20000
+#define UPDATES 3
+
+/* Classificação: elementos, somas e de quantas em quantas somas é verificada */
+#define RANKED 500
+#define RANK_ADDS 20000
+#define RANK_STEP 1000
+#define RANK_MAX_QUANT 7
+
+/* Árvores com subárvores contadas: códigos distintos e inserções (com repetições) */
+#define TREE_CODES 5000
+#define TREE_INSERTS 8000
+
+/* Cursores: linhas de cada página lida */
+#define CURSOR_PAGE 37
+
+/* Função de hash perfeita: códigos do catálogo (só um em cada PH_STRIDE) */
+#define PH_CODES 50000
+#define PH_STRIDE 3
+
+/* Filtro de Bloom: chaves adicionadas (e outras tantas ausentes), taxa de falsos
+ * positivos pretendida, tolerância do filtro por blocos e limite de bytes apertado */
+#define BLOOM_KEYS 50000
+#define BLOOM_RATE 0.01
+#define BLOOM_SLACK 3
+#define BLOOM_BUDGET 4096
+
+/* Dados carregados pelo dataloader: clientes, produtos, vendas e filiais */
+#define DATA_CLIENTS 300
+#define DATA_PRODUCTS 500
+#define DATA_SALES 20000
+#define DATA_BRANCHES 3
+#define DATA_MAX_QUANT 20
+#define MONTHS 12
+
+/* Cache: linhas de cada resultado e resultados que cabem na cache */
+#define CACHED_ROWS 64
+#define CACHED_RESULTS 3
+
+/* parallelFor: maior intervalo percorrido e tarefas submetidas uma a uma */
+#define FOR_SIZE 100000
+#define FOR_TASKS 1000
+
+#define MASK 0xFFFFFFFFUL
+
+#define CHECK(cond) \
+	((cond) ? (void) 0 : (void) (failures++, \
+	 fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #cond)))
+
+#ifdef MEMSTAT
+#define CHECK_COUNT(cond) CHECK(cond)
+#else
+#define CHECK_COUNT(cond) ((void) (cond))
+#endif
+
+typedef void (*check_t)();
+
+struct check {
+	char* name;
+	check_t run;
+};
+
+/* Códigos de uma árvore de teste, por ordem alfabética */
+struct tree_keys {
+	AVL tree;
+	char codes[TREE_CODES][CODE_SIZE];
+	char* sorted[TREE_CODES];
+};
+
+/* Hashes visitadas por um percurso, que termina depois de limit visitas (se não for 0) */
+struct visited {
+	char* hashes[TREE_CODES];
+	int n;
+	int limit;
+};
+
+/* Intervalo de um parallelFor e vezes que cada índice foi percorrido */
+struct coverage {
+	int begin, end, grain;
+	int* hits;
+	int errors;
+};
+
+/* Dados pequenos carregados através do dataloader, com as quantidades esperadas */
+struct dataset {
+	SALESINDEX si;
+	FATGLOBAL fat;
+	PRODUCTCAT pcat;
+	CLIENTCAT ccat;
+	int loaded;
+	int quant[DATA_CLIENTS][MONTHS];   /* somando todas as filiais */
+	bool sold[DATA_PRODUCTS][DATA_BRANCHES];
+	int bought[DATA_CLIENTS][DATA_PRODUCTS];   /* somando todos os meses */
+	int spent[DATA_CLIENTS][DATA_PRODUCTS];
+};
+
+/* Uma thread da verificação do catálogo concorrente */
+struct worker {
+	CATALOG cat;
+	int id;
+	int errors;   /* contadas pela thread, e verificadas no fim pela principal */
+};
+
+static int failures;
+static int writing;
+static unsigned long seed = 2016;
+
+static char* makeCode(char* buf, int i);
+static int randomInt(int n);
+static int compareCodes(const void* a, const void* b);
+static struct tree_keys* makeTree();
+static char* makeClientCode(char* buf, int i);
+static struct dataset* loadDataset(THREADPOOL pool);
+static void freeDataset(struct dataset* d);
+
+static void checkRegion();
+static void checkMemstat();
+static void checkRegionOverflow();
+static void allocBlocks(void** blocks, int begin, int end);
+static void checkConcurrentCatalog();
+static void checkRanking();
+static int checkRankingOrder(RANKING r, int* quant, int n);
+static void checkAVLorder();
+static void checkAVLprefix();
+static bool visitCollect(char* hash, void* content, struct visited* v);
+static int compareVisited(struct visited* v, char** expected, int n);
+static int compareCursor(CURSOR c, char** expected, int n);
+static void checkPerfectHash();
+static void checkBloom();
+static int countBloom(BLOOM b, int from, int to);
+static void checkClientsAboveQuant();
+static void checkUnsoldInBranch();
+static void checkClientProducts();
+static void checkParallelLoad();
+static int codeIndex(char* code);
+static void checkCache();
+static RESULT makeResult(int marker, int rows);
+static int cachedMarker(CACHE c, char* key);
+static void checkParallelFor();
+static int coverRange(THREADPOOL pool, int begin, int end, int grain);
+static void coverChunk(struct coverage* c, int begin, int end);
+static void countTask(int* counter);
+
+static void* runWriter(struct worker* w);
+static void* runReader(struct worker* w);
+static int* countUpdate(int* count, void* arg);
+static bool visitCount(char* hash, int* count, int* visited);
+
+static struct check checks[] = {
+	{"region", checkRegion},
+	{"memstat", checkMemstat},
+	{"region_overflow", checkRegionOverflow},
+	{"catalog_concurrent", checkConcurrentCatalog},
+	{"ranking", checkRanking},
+	{"avl_order", checkAVLorder},
+	{"avl_prefix", checkAVLprefix},
+	{"perfecthash", checkPerfectHash},
+	{"bloom", checkBloom},
+	{"buyers", checkClientsAboveQuant},
+	{"unsold", checkUnsoldInBranch},
+	{"client_products", checkClientProducts},
+	{"parallel_load", checkParallelLoad},
+	{"cache", checkCache},
+	{"parallelfor", checkParallelFor},
+	{NULL, NULL}
+};
+
+int main(int argc, char** argv) {
+	char* only = (argc > 1) ? argv[1] : NULL;
+	int i, failed = 0;
+
+	for(i = 0; checks[i].name; i++) {
+		if (only && strncmp(checks[i].name, only, strlen(only))) continue;
+
+		failures = 0;
+		checks[i].run();
+
+		if (failures) printf("%s\t%d falhas\n", checks[i].name, failures);
+		else printf("%s\tok\n", checks[i].name);
+
+		failed += failures;
+	}
+
+	return (failed != 0);
+}
+
+/**
+ * Escreve o i-ésimo de uma sequência de códigos distintos com o formato dos produtos.
+ */
+static char* makeCode(char* buf, int i) {
+	sprintf(buf, "%c%c%d", 'A' + i % LETTERS, 'A' + i / LETTERS % LETTERS,
+	        1000 + i / (LETTERS * LETTERS));
+
+	return buf;
+}
+
+/**
+ * Devolve um inteiro pseudo-aleatório entre 0 e n - 1 (gerador linear congruente, o
+ * mesmo em todas as execuções).
+ */
+static int randomInt(int n) {
+	seed = (seed * 1103515245UL + 12345UL) & MASK;
+	return (int) ((seed >> 8) % n);
+}
+
+static int compareCodes(const void* a, const void* b) {
+	return strcmp(*(char**) a, *(char**) b);
+}
+
+/**
+ * Cria uma árvore com TREE_CODES códigos, inseridos por uma ordem pseudo-aleatória e com
+ * repetições, para haver rotações de todos os tipos.
+ */
+static struct tree_keys* makeTree() {
+	struct tree_keys* k = malloc(sizeof(*k));
+	int i;
+
+	k->tree = initAVL(NULL, NULL, NULL);
+
+	for(i = 0; i < TREE_CODES; i++)
+		k->sorted[i] = makeCode(k->codes[i], i * 7);
+
+	for(i = 0; i < TREE_INSERTS; i++)
+		k->tree = insertAVL(k->tree, k->codes[randomInt(TREE_CODES)], NULL);
+
+	/* Os que não saíram entram no fim, por ordem */
+	for(i = 0; i < TREE_CODES; i++)
+		k->tree = insertAVL(k->tree, k->codes[i], NULL);
+
+	qsort(k->sorted, TREE_CODES, sizeof(char*), compareCodes);
+
+	return k;
+}
+
+/**
+ * Escreve o i-ésimo de uma sequência de códigos distintos com o formato dos clientes,
+ * pela mesma ordem alfabética que i (até 100 códigos por letra).
+ */
+static char* makeClientCode(char* buf, int i) {
+	sprintf(buf, "%c%d", 'A' + i / 100, 1000 + i % 100);
+	return buf;
+}
+
+/**
+ * Carrega, através de ficheiros temporários, DATA_CLIENTS clientes, DATA_PRODUCTS
+ * produtos (só os pares são vendidos) e DATA_SALES vendas pseudo-aleatórias, mais uma
+ * venda de um produto inexistente, acumulando à parte as quantidades de cada cliente.
+ */
+static struct dataset* loadDataset(THREADPOOL pool) {
+	struct dataset* d = calloc(1, sizeof(*d));
+	FILE *clients = tmpfile(), *products = tmpfile(), *sales = tmpfile();
+	char code[CODE_SIZE], client[CODE_SIZE];
+	int i, c, p, price, month, quant, branch, failed;
+
+	for(i = 0; i < DATA_CLIENTS; i++)
+		fprintf(clients, "%s\n", makeClientCode(code, i));
+
+	for(i = 0; i < DATA_PRODUCTS; i++)
+		fprintf(products, "%s\n", makeCode(code, i));
+
+	for(i = 0; i < DATA_SALES; i++) {
+		c = randomInt(DATA_CLIENTS);
+		p = 2 * randomInt(DATA_PRODUCTS / 2);
+		month = randomInt(MONTHS);
+		quant = randomInt(DATA_MAX_QUANT) + 1;
+		branch = randomInt(DATA_BRANCHES);
+		if (p % 4) branch = p / 4 % DATA_BRANCHES;   /* metade só vende numa filial */
+		d->quant[c][month] += quant;
+		d->sold[p][branch] = true;
+		d->bought[c][p] += quant;
+
+		/* Preços inteiros, para a faturação não ter arredondamentos */
+		price = randomInt(100);
+		d->spent[c][p] += price * quant;
+
+		fprintf(sales, "%s %d.00 %d %c %s %d %d\n", makeCode(code, p), price,
+		        quant, randomInt(2) ? 'N' : 'P',
+		        makeClientCode(client, c), month + 1, branch + 1);
+	}
+
+	fprintf(sales, "ZZ9999 1.00 1 N %s 1 1\n", makeClientCode(client, 0));
+
+	rewind(clients);
+	rewind(products);
+	rewind(sales);
+
+	d->fat  = setFatPool(initFat(DATA_BRANCHES), pool);
+	d->si   = setSalesIndexPool(initSalesIndex(DATA_BRANCHES), pool);
+	d->ccat = initClientCat();
+	d->pcat = initProductCat();
+
+	loadClients(clients, d->ccat);
+	loadProducts(products, d->pcat);
+	d->loaded = loadSales(sales, d->fat, d->si, d->pcat, d->ccat, &failed);
+	CHECK(failed == 1);
+
+	fclose(clients);
+	fclose(products);
+	fclose(sales);
+
+	return d;
+}
+
+static void freeDataset(struct dataset* d) {
+	freeFat(d->fat);
+	freeSalesIndex(d->si);
+	freeProductCat(d->pcat);
+	freeClientCat(d->ccat);
+	free(d);
+}
+
+/**
+ * Quando a região enche, os blocos seguintes vêm do malloc: dropRegion tem de recusar
+ * descartá-la, e libertar as estruturas uma a uma tem de deixar tudo libertado.
+ */
+static void checkRegionOverflow() {
+	REGION r = initRegion(SMALL_REGION);
+	void* blocks[OVERFLOW_BLOCKS];
+	long live = getMemLiveBlocks(MEM_ALL);
+	char code[CODE_SIZE];
+	THREADPOOL pool;
+	CATALOG cat;
+	int i;
+
+	CHECK(r != NULL);
+	if (!r) return;
+
+	useRegion(r);
+
+	for(i = 0; i < OVERFLOW_BLOCKS; i++)
+		blocks[i] = tagMalloc(MEM_AVL, 4096);
+
+	CHECK(inRegion(r, blocks[0]));
+	CHECK(!inRegion(r, blocks[OVERFLOW_BLOCKS - 1]));
+	CHECK(!dropRegion());
+
+	for(i = 0; i < OVERFLOW_BLOCKS; i++)
+		tagFree(blocks[i]);
+
+	releaseRegion();
+	CHECK(getMemLiveBlocks(MEM_ALL) == live);
+
+	/* O mesmo com um catálogo, libertado como o main liberta os dados */
+	useRegion(initRegion(SMALL_REGION));
+
+	cat = initCatalog(LETTERS, NULL, NULL);
+	for(i = 0; i < OVERFLOW_CODES; i++)
+		cat = insertCatalog(cat, makeCode(code, i), NULL);
+
+	CHECK(countAllElems(cat) == OVERFLOW_CODES);
+	CHECK(!dropRegion());
+
+	freeCatalog(cat);
+	releaseRegion();
+	CHECK(getMemLiveBlocks(MEM_ALL) == live);
+
+	/* O mesmo com os blocos alocados por vários trabalhadores ao mesmo tempo */
+	pool = initThreadPool(4);
+	useRegion(initRegion(SMALL_REGION));
+
+	parallelFor(pool, 0, OVERFLOW_BLOCKS, 1, (range_t) allocBlocks, blocks);
+	CHECK(!dropRegion());
+
+	for(i = 0; i < OVERFLOW_BLOCKS; i++)
+		tagFree(blocks[i]);
+
+	releaseRegion();
+	freeThreadPool(pool);
+	CHECK(getMemLiveBlocks(MEM_ALL) == live);
+}
+
+/**
+ * Aloca blocos de 4KB nas posições dadas, como corpo de um parallelFor.
+ */
+static void allocBlocks(void** blocks, int begin, int end) {
+	int i;
+
+	for(i = begin; i < end; i++)
+		blocks[i] = tagMalloc(MEM_AVL, 4096);
+}
+
+/**
+ * Alocação, realocação no sítio e com mudança de sítio, reaproveitamento de blocos
+ * libertados e comportamento com a região cheia.
+ */
+static void checkRegion() {
+	REGION r = initRegion(SMALL_REGION);
+	char *a, *b, *large, *last = NULL, local;
+	int i;
+
+	CHECK(r != NULL);
+	if (!r) return;
+
+	a = regionAlloc(r, 100);
+	CHECK(a && inRegion(r, a));
+	CHECK((unsigned long) a % sizeof(long double) == 0);
+	CHECK(getRegionBlockSize(a) >= 100);
+	CHECK(getRegionBytes(r) >= 100);
+	CHECK(!inRegion(r, &local));
+
+	for(i = 0; i < 100; i++) a[i] = (char) i;
+
+	/* Enquanto couber no bloco, o bloco não muda de sítio */
+	CHECK(regionRealloc(r, a, 50) == a);
+	CHECK(regionRealloc(r, a, getRegionBlockSize(a)) == a);
+
+	b = regionRealloc(r, a, 1000);
+	CHECK(b && b != a && inRegion(r, b));
+	for(i = 0; i < 100 && b[i] == (char) i; i++);
+	CHECK(i == 100);
+
+	/* O bloco antigo fica livre para um pedido do mesmo tamanho */
+	CHECK(regionAlloc(r, 100) == a);
+
+	large = regionAlloc(r, LARGE_BLOCK);
+	CHECK(large && inRegion(r, large));
+	regionFree(r, large);
+	CHECK(regionAlloc(r, LARGE_BLOCK) == large);
+
+	/* Cheia, a região recusa novos blocos e mantém os que não conseguiu aumentar */
+	for(i = 0; i < SMALL_REGION / 4096 + 1 && (a = regionAlloc(r, 4096)); i++)
+		last = a;
+
+	CHECK(a == NULL);
+	CHECK(last && regionRealloc(r, last, 8192) == NULL && inRegion(r, last));
+	CHECK(regionRealloc(r, b, 1000) == b);
+
+	freeRegion(r);
+}
+
+/**
+ * Contadores do memstat com e sem região: as alocações do carregamento vão para ela e
+ * as feitas depois de closeRegion não, seja qual for o subsistema; ao descartar a
+ * região, os seus blocos passam a contar como libertados.
+ */
+static void checkMemstat() {
+	REGION r = initRegion(SMALL_REGION);
+	long live = getMemLiveBlocks(MEM_AVL), bytes = getMemLiveBytes(MEM_AVL);
+	long allocs = getMemAllocs(MEM_AVL), frees = getFreeCount();
+	long queries = getMemLiveBlocks(MEM_QUERIES), sets = getMemLiveBlocks(MEM_SET);
+	char *a, *q, *s, *z;
+	int i;
+
+	CHECK(r != NULL);
+	if (!r) return;
+
+	useRegion(r);
+
+	a = tagMalloc(MEM_AVL, 100);
+	z = tagCalloc(MEM_SET, 10, 10);
+
+	CHECK(inRegion(r, a));
+	CHECK(inRegion(r, z));
+	for(i = 0; i < 100 && !z[i]; i++);
+	CHECK(i == 100);
+
+	/* Depois do carregamento, nem os subsistemas dos dados alocam na região */
+	closeRegion();
+
+	q = tagMalloc(MEM_QUERIES, 100);
+	s = tagMalloc(MEM_SET, 100);
+
+	CHECK(!inRegion(r, q));
+	CHECK(!inRegion(r, s));
+
+	a = tagRealloc(MEM_AVL, a, 5000);
+	CHECK(inRegion(r, a));
+
+	tagFree(z);
+
+	CHECK_COUNT(getMemAllocs(MEM_AVL) == allocs + 2);
+	CHECK_COUNT(getMemLiveBlocks(MEM_AVL) == live + 1);
+	CHECK_COUNT(getMemLiveBytes(MEM_AVL) == bytes + 5000);
+	CHECK_COUNT(getMemLiveBlocks(MEM_QUERIES) == queries + 1);
+	CHECK_COUNT(getMemLiveBlocks(MEM_SET) == sets + 1);
+	CHECK_COUNT(getFreeCount() == frees + 1);
+
+	/* O bloco de MEM_AVL vai com a região; os das consultas continuam por libertar */
+	CHECK(dropRegion());
+	CHECK(!dropRegion());
+
+	CHECK(getMemLiveBlocks(MEM_AVL) == live);
+	CHECK(getMemLiveBytes(MEM_AVL) == bytes);
+
+	CHECK_COUNT(getFreeCount() == frees + 2);
+	CHECK_COUNT(getMemLiveBlocks(MEM_QUERIES) == queries + 1);
+	CHECK_COUNT(getMemLiveBlocks(MEM_SET) == sets + 1);
+
+	tagFree(q);
+	tagFree(s);
+	CHECK(getMemLiveBlocks(MEM_QUERIES) == queries);
+	CHECK(getMemLiveBlocks(MEM_SET) == sets);
+}
+
+/**
+ * Modo concorrente do catálogo: WRITERS threads inserem códigos intercalados (e portanto
+ * nos mesmos índices) e atualizam cada um UPDATES vezes, enquanto READERS threads contam
+ * e percorrem o catálogo. No fim tem de estar tudo, com as contagens exatas.
+ */
+static void checkConcurrentCatalog() {
+	CATALOG cat = setCatalogConcurrent(initCatalog(LETTERS, NULL, free), true);
+	pthread_t threads[WRITERS + READERS];
+	struct worker workers[WRITERS + READERS];
+	char code[CODE_SIZE];
+	int i, wrong = 0, *count;
+
+	CHECK(isConcurrentCatalog(cat));
+
+	writing = WRITERS;
+
+	for(i = 0; i < WRITERS + READERS; i++) {
+		workers[i].cat = cat;
+		workers[i].id = i;
+		workers[i].errors = 0;
+		pthread_create(&threads[i], NULL,
+		               (void* (*)(void*)) ((i < WRITERS) ? runWriter : runReader), &workers[i]);
+	}
+
+	for(i = 0; i < WRITERS + READERS; i++) {
+		pthread_join(threads[i], NULL);
+		CHECK(workers[i].errors == 0);
+	}
+
+	CHECK(countAllElems(cat) == CONCURRENT_CODES);
+
+	for(i = 0; i < CONCURRENT_CODES; i++) {
+		count = getCatContent(cat, makeCode(code, i), NULL);
+		if (!count || *count != UPDATES) wrong++;
+	}
+
+	CHECK(wrong == 0);
+
+	freeCatalog(cat);
+}
+
+static void* runWriter(struct worker* w) {
+	char code[CODE_SIZE];
+	int i, j;
+
+	for(i = w->id; i < CONCURRENT_CODES; i += WRITERS) {
+		w->cat = insertCatalog(w->cat, makeCode(code, i), NULL);
+
+		for(j = 0; j < UPDATES; j++)
+			if (!updateCatContent(w->cat, code, (update_t) countUpdate, NULL))
+				w->errors++;
+	}
+
+	__sync_sub_and_fetch(&writing, 1);
+
+	return NULL;
+}
+
+/**
+ * Enquanto houver escritores, o número de elementos nunca pode diminuir nem passar do
+ * total, e um percurso só pode ver contagens entre 1 e UPDATES (ou elementos ainda sem
+ * conteúdo).
+ */
+static void* runReader(struct worker* w) {
+	int n, last = 0, visited;
+
+	while (__sync_add_and_fetch(&writing, 0) > 0) {
+		n = countAllElems(w->cat);
+		if (n < last || n > CONCURRENT_CODES) w->errors++;
+		last = n;
+
+		visited = 0;
+		rangeScanCatalog(w->cat, NULL, NULL, (visit_t) visitCount, &visited);
+		if (visited < 0 || visited < last) w->errors++;
+	}
+
+	return NULL;
+}
+
+static int* countUpdate(int* count, void* arg) {
+	(void) arg;
+
+	if (!count) {
+		count = malloc(sizeof(int));
+		*count = 0;
+	}
+
+	(*count)++;
+	return count;
+}
+
+/**
+ * Conta os elementos visitados, ou marca o percurso como errado (com -1) se uma contagem
+ * estiver fora dos limites.
+ */
+static bool visitCount(char* hash, int* count, int* visited) {
+	(void) hash;
+
+	if (count && (*count < 1 || *count > UPDATES)) {
+		*visited = -1;
+		return false;
+	}
+
+	(*visited)++;
+	return true;
+}
+
+/**
+ * Classificação mantida a cada soma: comparada, de RANK_STEP em RANK_STEP somas, com as
+ * quantidades acumuladas à parte. As somas não positivas e fora dos limites são
+ * ignoradas.
+ */
+static void checkRanking() {
+	RANKING r = initRanking(RANKED);
+	int quant[RANKED], i, id, q, wrong = 0;
+
+	for(i = 0; i < RANKED; i++) quant[i] = 0;
+
+	CHECK(getRankingSize(r) == 0);
+	CHECK(getRankingId(r, 0) == -1);
+
+	r = addToRanking(r, 0, 0);
+	r = addToRanking(r, 0, -5);
+	r = addToRanking(r, -1, 5);
+	r = addToRanking(r, RANKED, 5);
+	CHECK(getRankingSize(r) == 0);
+
+	for(i = 1; i <= RANK_ADDS; i++) {
+		/* Ids pequenos mais frequentes, para haver blocos grandes de quantidades iguais */
+		id = randomInt(randomInt(RANKED) + 1);
+		q = randomInt(RANK_MAX_QUANT) + 1;
+
+		r = addToRanking(r, id, q);
+		quant[id] += q;
+
+		if (i % RANK_STEP == 0)
+			wrong += checkRankingOrder(r, quant, RANKED);
+	}
+
+	CHECK(wrong == 0);
+
+	freeRanking(r);
+}
+
+/**
+ * Verifica que cada elemento com quantidade positiva ocupa exatamente uma posição, com
+ * a quantidade certa, e que as posições estão por quantidade decrescente.
+ * @return O número de erros encontrados
+ */
+static int checkRankingOrder(RANKING r, int* quant, int n) {
+	int *seen = calloc(n, sizeof(int));
+	int i, id, last = -1, used = 0, errors = 0;
+
+	for(i = 0; i < n; i++) {
+		if (getRankingQuant(r, i) != quant[i]) errors++;
+		if (quant[i] > 0) used++;
+	}
+
+	if (getRankingSize(r) != used) errors++;
+	if (getRankingId(r, used) != -1) errors++;
+
+	for(i = 0; i < used; i++) {
+		id = getRankingId(r, i);
+		if (id < 0 || id >= n || seen[id]++ || quant[id] <= 0) {
+			errors++;
+			continue;
+		}
+
+		if (last >= 0 && last < quant[id]) errors++;
+		last = quant[id];
+	}
+
+	free(seen);
+	return errors;
+}
+
+/**
+ * Tamanhos das subárvores, mantidos através das rotações: selectAVL e rankAVL têm de
+ * concordar com a ordem alfabética em todas as posições, tal como os iteradores e
+ * selectCatalog e rankCatalog no catálogo inteiro.
+ */
+static void checkAVLorder() {
+	long rotations = getAVLRotations();
+	struct tree_keys* k = makeTree();
+	char absent[CODE_SIZE + 1], *code;
+	CATALOG hashed, cat = initCatalog(LETTERS, NULL, NULL);
+	AVLITER it;
+	int i, wrong = 0;
+
+	CHECK(getAVLRotations() > rotations);
+	CHECK(countNodes(k->tree) == TREE_CODES);
+
+	for(i = 0; i < TREE_CODES; i++) {
+		if ((code = selectAVL(k->tree, i)) == NULL || strcmp(code, k->sorted[i])) wrong++;
+		if (rankAVL(k->tree, k->sorted[i]) != i) wrong++;
+
+		/* Um código ausente, logo a seguir a este */
+		sprintf(absent, "%s!", k->sorted[i]);
+		if (rankAVL(k->tree, absent) != i + 1) wrong++;
+
+		cat = insertCatalog(cat, k->sorted[i], NULL);
+	}
+
+	CHECK(wrong == 0);
+	CHECK(selectAVL(k->tree, TREE_CODES) == NULL);
+	CHECK(selectAVL(k->tree, -1) == NULL);
+	CHECK(rankAVL(k->tree, "") == 0);
+	CHECK(rankAVL(k->tree, "ZZZZZZ") == TREE_CODES);
+
+	/* Um iterador a partir de cada posição de um passo largo */
+	for(i = 0, wrong = 0; i < TREE_CODES; i += 97) {
+		it = initAVLIterator(k->tree, i);
+		if ((code = nextAVLIterator(it)) == NULL || strcmp(code, k->sorted[i])) wrong++;
+		if (i + 1 < TREE_CODES &&
+		    ((code = nextAVLIterator(it)) == NULL || strcmp(code, k->sorted[i + 1]))) wrong++;
+		freeAVLIterator(it);
+	}
+
+	it = initAVLIterator(k->tree, TREE_CODES - 1);
+	CHECK(nextAVLIterator(it) != NULL && nextAVLIterator(it) == NULL);
+	freeAVLIterator(it);
+
+	/* Com um índice por letra, a ordem do catálogo é a alfabética */
+	for(i = 0; i < TREE_CODES; i++) {
+		if (rankCatalog(cat, k->sorted[i]) != i) wrong++;
+		if ((code = selectCatalog(cat, i)) == NULL || strcmp(code, k->sorted[i])) wrong++;
+	}
+
+	CHECK(wrong == 0);
+	CHECK(selectCatalog(cat, TREE_CODES) == NULL && selectCatalog(cat, -1) == NULL);
+
+	/* Distribuídos por hash, selectCatalog e rankCatalog continuam a ser inversos */
+	hashed = initShardedCatalog(LETTERS, shardByHash, NULL, NULL);
+	for(i = 0; i < TREE_CODES; i++)
+		hashed = insertCatalog(hashed, k->sorted[i], NULL);
+
+	for(i = 0, wrong = 0; i < TREE_CODES; i++)
+		if ((code = selectCatalog(hashed, i)) == NULL || rankCatalog(hashed, code) != i)
+			wrong++;
+
+	CHECK(wrong == 0);
+
+	freeCatalog(hashed);
+	freeCatalog(cat);
+	freeAVL(k->tree);
+	free(k);
+}
+
+/**
+ * Contagens, percursos e cursores por prefixo, e percursos por intervalo, na árvore e
+ * no catálogo, comparados com uma pesquisa na lista ordenada dos códigos.
+ */
+static void checkAVLprefix() {
+	static char* prefixes[] = {"", "A", "B", "AB", "ZZ", "QC1", "A0", "NOPE", NULL};
+	static char* ranges[][2] = {
+		{"A", "B"}, {"AC1000", "AC1099"}, {"H", "K"}, {"Z", NULL}, {NULL, "B"},
+		{"K", "A"}, {NULL, NULL}, {NULL, NULL}
+	};
+	struct tree_keys* k = makeTree();
+	struct visited* v = malloc(sizeof(*v));
+	CATALOG cat = initCatalog(LETTERS, NULL, NULL);
+	char *lo, *hi;
+	int i, j, first, n, wrong = 0;
+
+	for(i = 0; i < TREE_CODES; i++)
+		cat = insertCatalog(cat, k->sorted[i], NULL);
+
+	/* O último intervalo tem por limites dois códigos da árvore, em índices diferentes */
+	ranges[7][0] = k->sorted[TREE_CODES / 10];
+	ranges[7][1] = k->sorted[TREE_CODES / 2];
+
+	for(i = 0; prefixes[i]; i++) {
+		first = rankAVL(k->tree, prefixes[i]);
+		for(n = 0; first + n < TREE_CODES &&
+		           !strncmp(k->sorted[first + n], prefixes[i], strlen(prefixes[i])); n++);
+
+		if (first > 0 && !strncmp(k->sorted[first - 1], prefixes[i], strlen(prefixes[i])))
+			wrong++;
+		if (countPrefixAVL(k->tree, prefixes[i]) != n) wrong++;
+		if (countPrefixElems(cat, prefixes[i]) != n) wrong++;
+
+		v->n = v->limit = 0;
+		if (!prefixScanAVL(k->tree, prefixes[i], (visit_t) visitCollect, v)) wrong++;
+		wrong += compareVisited(v, k->sorted + first, n);
+
+		v->n = v->limit = 0;
+		if (!prefixScanCatalog(cat, prefixes[i], (visit_t) visitCollect, v)) wrong++;
+		wrong += compareVisited(v, k->sorted + first, n);
+	}
+
+	CHECK(wrong == 0);
+
+	/* Os cursores dão as mesmas hashes, página a página */
+	for(i = 0, wrong = 0; prefixes[i]; i++) {
+		first = rankAVL(k->tree, prefixes[i]);
+		n = countPrefixAVL(k->tree, prefixes[i]);
+		wrong += compareCursor(initPrefixCursor(cat, prefixes[i]), k->sorted + first, n);
+	}
+
+	wrong += compareCursor(initCatalogCursor(cat), k->sorted, TREE_CODES);
+	CHECK(wrong == 0);
+
+	for(i = 0, wrong = 0; i < (int) (sizeof(ranges) / sizeof(ranges[0])); i++) {
+		lo = ranges[i][0];
+		hi = ranges[i][1];
+
+		/* Os limites são inclusivos */
+		for(first = 0; lo && first < TREE_CODES && strcmp(k->sorted[first], lo) < 0; first++);
+		for(j = first; j < TREE_CODES && (!hi || strcmp(k->sorted[j], hi) <= 0); j++);
+		n = (j > first) ? j - first : 0;
+
+		v->n = v->limit = 0;
+		if (!rangeScanAVL(k->tree, lo, hi, (visit_t) visitCollect, v)) wrong++;
+		wrong += compareVisited(v, k->sorted + first, n);
+
+		v->n = v->limit = 0;
+		if (!rangeScanCatalog(cat, lo, hi, (visit_t) visitCollect, v)) wrong++;
+		wrong += compareVisited(v, k->sorted + first, n);
+	}
+
+	CHECK(wrong == 0);
+
+	/* Um percurso terminado por visit fica por aí */
+	v->n = 0; v->limit = 3;
+	CHECK(!rangeScanAVL(k->tree, NULL, NULL, (visit_t) visitCollect, v) && v->n == 3);
+	v->n = 0; v->limit = 3;
+	CHECK(!prefixScanCatalog(cat, "A", (visit_t) visitCollect, v) && v->n == 3);
+
+	freeCatalog(cat);
+	freeAVL(k->tree);
+	free(k);
+	free(v);
+}
+
+static bool visitCollect(char* hash, void* content, struct visited* v) {
+	(void) content;
+
+	/* Mais visitas do que códigos já é um erro, que compareVisited deteta */
+	if (v->n == TREE_CODES) return false;
+
+	v->hashes[v->n++] = hash;
+	return !v->limit || v->n < v->limit;
+}
+
+/**
+ * Compara as hashes visitadas com as esperadas, pela mesma ordem.
+ * @return 0 se forem iguais, 1 caso contrário
+ */
+static int compareVisited(struct visited* v, char** expected, int n) {
+	int i;
+
+	if (v->n != n) return 1;
+
+	for(i = 0; i < n && !strcmp(v->hashes[i], expected[i]); i++);
+	return (i < n);
+}
+
+/**
+ * Compara as linhas de um cursor com as hashes esperadas: lido página a página desde o
+ * início, e depois a partir do meio. O cursor é libertado.
+ * @return O número de erros encontrados
+ */
+static int compareCursor(CURSOR c, char** expected, int n) {
+	RESULT page;
+	int i, pos = 0, errors = (getCursorSize(c) != n);
+
+	while(pos < n && !errors) {
+		page = readCursor(c, CURSOR_PAGE);
+		if (getResultRows(page) == 0) errors++;
+
+		for(i = 0; i < getResultRows(page); i++, pos++)
+			if (pos >= n || strcmp(getResultCode(page, i, 0), expected[pos])) errors++;
+
+		freeResult(page);
+	}
+
+	c = seekCursor(c, n / 2);
+	page = readCursor(c, CURSOR_PAGE);
+	if (n && (getResultRows(page) == 0 || strcmp(getResultCode(page, 0, 0), expected[n / 2])))
+		errors++;
+
+	freeResult(page);
+	freeCursor(c);
+	return errors;
+}
+
+/**
+ * Função de hash perfeita de um catálogo: cada código tem de receber a sua posição no
+ * catálogo (rankCatalog), e os códigos ausentes -1. O mesmo através dos identificadores
+ * de um catálogo de produtos, antes de balanceado (sem a função) e depois.
+ */
+static void checkPerfectHash() {
+	CATALOG cat = initCatalog(LETTERS, NULL, NULL);
+	PRODUCTCAT products = initProductCat();
+	PERFECTHASH ph;
+	PRODUCT p;
+	char code[CODE_SIZE];
+	int i, wrong = 0, *before = malloc(sizeof(int) * PH_CODES * PH_STRIDE);
+
+	for(i = 0; i < PH_CODES; i++) {
+		cat = insertCatalog(cat, makeCode(code, i * PH_STRIDE), NULL);
+
+		p = toProduct(code);
+		products = insertProduct(products, p);
+		freeProduct(p);
+	}
+
+	/* Uma função sobre chaves adicionadas à mão fica com a ordem de adição */
+	ph = initPerfectHash(1);
+	ph = addPerfectHashKey(addPerfectHashKey(ph, "B"), "A");
+	ph = buildPerfectHash(ph);
+	CHECK(ph && getPerfectHashSize(ph) == 2);
+	CHECK(ph && getPerfectHashId(ph, "B") == 0 && getPerfectHashId(ph, "A") == 1);
+	CHECK(ph && getPerfectHashId(ph, "C") == -1 && getPerfectHashId(ph, "") == -1);
+	freePerfectHash(ph);
+
+	for(i = 0; i < PH_CODES * PH_STRIDE; i++) {
+		before[i] = getProductCodeId(products, makeCode(code, i));
+		if (before[i] != ((i % PH_STRIDE) ? -1 : rankCatalog(cat, code))) wrong++;
+	}
+
+	CHECK(wrong == 0);
+
+	ph = perfectHashCatalog(cat);
+	CHECK(ph != NULL);
+
+	if (ph) {
+		CHECK(getPerfectHashSize(ph) == PH_CODES);
+
+		for(i = 0, wrong = 0; i < PH_CODES * PH_STRIDE; i++)
+			if (getPerfectHashId(ph, makeCode(code, i)) != before[i]) wrong++;
+
+		CHECK(wrong == 0);
+		CHECK(getPerfectHashId(ph, "A") == -1);
+		CHECK(getPerfectHashId(ph, "") == -1);
+
+		freePerfectHash(ph);
+	}
+
+	/* Balanceado, o catálogo de produtos passa a usar a função */
+	products = balanceProductCat(products);
+
+	for(i = 0, wrong = 0; i < PH_CODES * PH_STRIDE; i++)
+		if (getProductCodeId(products, makeCode(code, i)) != before[i]) wrong++;
+
+	CHECK(wrong == 0);
+	CHECK(getProductCodeId(products, "a1000") == -1);
+
+	freeProductCat(products);
+	freeCatalog(cat);
+	free(before);
+}
+
+/**
+ * Filtro de Bloom: nenhuma chave adicionada pode ser rejeitada, nem quando o limite de
+ * bytes obriga a um filtro mais pequeno, e a taxa de falsos positivos das ausentes tem
+ * de ficar perto da pretendida. Um catálogo de produtos com filtro tem de dar os mesmos
+ * identificadores que um sem filtro.
+ */
+static void checkBloom() {
+	BLOOM b = initBloom(BLOOM_KEYS, BLOOM_RATE, 0);
+	PRODUCTCAT plain = initProductCat(), filtered;
+	PRODUCT p;
+	char code[CODE_SIZE];
+	int i, wrong = 0;
+
+	for(i = 0; i < BLOOM_KEYS; i++)
+		b = addBloom(b, makeCode(code, i));
+
+	CHECK(countBloom(b, 0, BLOOM_KEYS) == BLOOM_KEYS);
+	CHECK(countBloom(b, BLOOM_KEYS, 2 * BLOOM_KEYS) < BLOOM_SLACK * BLOOM_RATE * BLOOM_KEYS);
+	CHECK(getBloomHashes(b) >= 1 && getBloomHashes(b) <= 16);
+	freeBloom(b);
+
+	b = initBloom(BLOOM_KEYS, BLOOM_RATE, BLOOM_BUDGET);
+	for(i = 0; i < BLOOM_KEYS; i++)
+		b = addBloom(b, makeCode(code, i));
+
+	CHECK(getBloomBytes(b) <= BLOOM_BUDGET + 64);
+	CHECK(countBloom(b, 0, BLOOM_KEYS) == BLOOM_KEYS);
+	freeBloom(b);
+
+	/* Só metade dos códigos no catálogo: a outra metade passa pelo filtro e é rejeitada */
+	filtered = setProductCatFilter(initProductCat(), BLOOM_RATE, 0);
+
+	for(i = 0; i < BLOOM_KEYS; i += 2) {
+		p = toProduct(makeCode(code, i));
+		plain = insertProduct(plain, p);
+		filtered = insertProduct(filtered, p);
+		freeProduct(p);
+	}
+
+	plain = balanceProductCat(plain);
+	filtered = balanceProductCat(filtered);
+
+	for(i = 0; i < BLOOM_KEYS; i++) {
+		makeCode(code, i);
+		if (getProductCodeId(filtered, code) != getProductCodeId(plain, code)) wrong++;
+	}
+
+	CHECK(wrong == 0);
+
+	freeProductCat(plain);
+	freeProductCat(filtered);
+}
+
+/**
+ * Conta quantos dos códigos de from a to - 1 o filtro aceita.
+ */
+static int countBloom(BLOOM b, int from, int to) {
+	char code[CODE_SIZE];
+	int n = 0;
+
+	for(; from < to; from++)
+		if (lookUpBloom(b, makeCode(code, from))) n++;
+
+	return n;
+}
+
+/**
+ * Clientes acima de uma quantidade num mês, percorrendo a matriz de quantidades: têm de
+ * ser exatamente os que as quantidades acumuladas à parte indicam, pela ordem dos
+ * códigos e com a quantidade certa.
+ */
+static void checkClientsAboveQuant() {
+	static int limits[] = {0, 40, 60, 100, DATA_SALES * DATA_MAX_QUANT};
+	struct dataset* d = loadDataset(NULL);
+	char code[CODE_SIZE];
+	RESULT r;
+	int i, c, month, row, wrong = 0;
+
+	CHECK(d->loaded == DATA_SALES);
+
+	for(month = 0; month < MONTHS; month++) {
+		for(i = 0; i < (int) (sizeof(limits) / sizeof(limits[0])); i++) {
+			r = getClientsAboveQuant(d->si, month, limits[i]);
+
+			for(c = 0, row = 0; c < DATA_CLIENTS; c++) {
+				if (d->quant[c][month] <= limits[i]) continue;
+
+				if (row >= getResultRows(r) ||
+				    strcmp(getResultCode(r, row, 0), makeClientCode(code, c)) ||
+				    getResultInt(r, row, 1) != d->quant[c][month]) wrong++;
+				row++;
+			}
+
+			if (row != getResultRows(r)) wrong++;
+			freeResult(r);
+		}
+	}
+
+	CHECK(wrong == 0);
+
+	freeDataset(d);
+}
+
+/**
+ * Produtos não vendidos numa filial: calculados só para essa filial, têm de ser os
+ * mesmos que os calculados para todas as filiais de uma vez, e exatamente os que não
+ * tiveram vendas nessa filial.
+ */
+static void checkUnsoldInBranch() {
+	struct dataset* d = loadDataset(NULL);
+	SET one, *all = getProductsNotSoldByBranch(d->fat);
+	char *code, *other;
+	int i, p, branch, expected, wrong = 0;
+
+	for(branch = 0; branch < DATA_BRANCHES; branch++) {
+		one = getProductsNotSoldInBranch(d->fat, branch);
+
+		for(p = 0, expected = 0; p < DATA_PRODUCTS; p++)
+			if (!d->sold[p][branch]) expected++;
+
+		if (getSetSize(one) != expected || getSetSize(all[branch]) != expected) wrong++;
+
+		for(i = 0; i < getSetSize(one) && i < getSetSize(all[branch]); i++) {
+			code = getSetHash(one, i);
+			other = getSetHash(all[branch], i);
+
+			if (strcmp(code, other) || (p = codeIndex(code)) < 0 || d->sold[p][branch])
+				wrong++;
+
+			FREE(code);
+			FREE(other);
+		}
+
+		freeSet(one);
+		freeSet(all[branch]);
+	}
+
+	CHECK(wrong == 0);
+
+	FREE(all);
+	freeDataset(d);
+}
+
+/**
+ * Produtos de cada cliente lidos diretamente das suas arestas: por mês têm de vir por
+ * ordem decrescente de quantidade, só com os comprados nesse mês e somando o total do
+ * cliente no mês; por faturação têm de ser todos os que o cliente comprou.
+ */
+static void checkClientProducts() {
+	struct dataset* d = loadDataset(NULL);
+	int *products = malloc(sizeof(int) * DATA_PRODUCTS);
+	int *quant = malloc(sizeof(int) * DATA_PRODUCTS);
+	double *billed = malloc(sizeof(double) * DATA_PRODUCTS);
+	int i, c, p, month, size, total, distinct, wrong = 0;
+
+	for(c = 0; c < DATA_CLIENTS; c++) {
+		for(p = 0, distinct = 0; p < DATA_PRODUCTS; p++)
+			if (d->bought[c][p]) distinct++;
+
+		if (countProductsByClient(d->si, c) != distinct) wrong++;
+
+		for(month = 0; month < MONTHS; month++) {
+			size = getProductsByClientQuant(d->si, c, month, products, quant);
+
+			for(i = 0, total = 0; i < size; i++) {
+				p = codeIndex(getProductCode(d->si, products[i]));
+				if (p < 0 || !d->bought[c][p] || quant[i] <= 0) wrong++;
+				if (i > 0 && quant[i] > quant[i - 1]) wrong++;
+				total += quant[i];
+			}
+
+			if (total != d->quant[c][month]) wrong++;
+		}
+
+		size = getProductsByClientBilled(d->si, c, products, billed);
+		if (size != distinct) wrong++;
+
+		for(i = 0; i < size; i++) {
+			p = codeIndex(getProductCode(d->si, products[i]));
+			if (p < 0 || !d->bought[c][p] || billed[i] != d->spent[c][p]) wrong++;
+			if (i > 0 && billed[i] > billed[i - 1]) wrong++;
+		}
+	}
+
+	CHECK(wrong == 0);
+
+	free(products);
+	free(quant);
+	free(billed);
+	freeDataset(d);
+}
+
+/**
+ * Carregamento com vários trabalhadores: as linhas são separadas e validadas em
+ * paralelo, mas as quantidades de cada cliente e o que gastou em cada produto têm de
+ * ser os das vendas geradas.
+ */
+static void checkParallelLoad() {
+	THREADPOOL pool = initThreadPool(4);
+	struct dataset* d = loadDataset(pool);
+	int *products = malloc(sizeof(int) * DATA_PRODUCTS);
+	double *billed = malloc(sizeof(double) * DATA_PRODUCTS);
+	int i, c, p, month, row, size, wrong = 0;
+	RESULT r;
+
+	CHECK(d->loaded == DATA_SALES);
+
+	for(month = 0; month < MONTHS; month++) {
+		r = getClientsAboveQuant(d->si, month, 0);
+
+		for(c = 0, row = 0; c < DATA_CLIENTS; c++)
+			if (d->quant[c][month] > 0)
+				if (row >= getResultRows(r) || getResultInt(r, row++, 1) != d->quant[c][month])
+					wrong++;
+
+		if (row != getResultRows(r)) wrong++;
+		freeResult(r);
+	}
+
+	for(c = 0; c < DATA_CLIENTS; c++) {
+		size = getProductsByClientBilled(d->si, c, products, billed);
+
+		for(i = 0; i < size; i++) {
+			p = codeIndex(getProductCode(d->si, products[i]));
+			if (p < 0 || billed[i] != d->spent[c][p]) wrong++;
+		}
+	}
+
+	CHECK(wrong == 0);
+
+	free(products);
+	free(billed);
+	freeDataset(d);
+	freeThreadPool(pool);
+}
+
+/**
+ * Determina o índice de um código escrito por makeCode, ou -1 se não for um deles.
+ */
+static int codeIndex(char* code) {
+	int i;
+
+	for(i = 0; i < DATA_PRODUCTS; i++) {
+		char buf[CODE_SIZE];
+		if (!strcmp(makeCode(buf, i), code)) return i;
+	}
+
+	return -1;
+}
+
+/**
+ * Cache de resultados com espaço para CACHED_RESULTS resultados: procuras, substituição
+ * de uma chave, descarte do resultado usado há mais tempo, resultados que não cabem e
+ * descarte de tudo ao mudar de geração. No fim não pode ficar nenhum resultado por
+ * libertar.
+ */
+static void checkCache() {
+	static char* keys[] = {"k0", "k1", "k2"};
+	long live = getMemLiveBlocks(MEM_QUERIES);
+	RESULT r[5], big = makeResult(9, CACHED_ROWS * (CACHED_RESULTS + 1));
+	long bytes;
+	CACHE c;
+	int i;
+
+	for(i = 0; i < 5; i++)
+		r[i] = makeResult(i, CACHED_ROWS);
+
+	/* Cada entrada ocupa o resultado, a chave e pouco mais de meia dúzia de ponteiros */
+	bytes = getResultBytes(r[0]);
+	CHECK(bytes > 400);
+	c = initCache((long) ((CACHED_RESULTS + 0.5) * (bytes + 100)));
+
+	CHECK(getCachedResult(c, "k0") == NULL);
+	CHECK(getCacheMisses(c) == 1 && getCacheHits(c) == 0);
+	CHECK(cacheResult(c, "k0", NULL) == NULL);
+
+	for(i = 0; i < CACHED_RESULTS; i++) {
+		CHECK(cacheResult(c, keys[i], r[i]) == r[i]);
+		freeResult(r[i]);
+	}
+
+	CHECK(cachedMarker(c, "k2") == 2);
+	CHECK(cachedMarker(c, "k1") == 1);
+	CHECK(cachedMarker(c, "k0") == 0);
+	CHECK(getCacheHits(c) == 3 && getCacheMisses(c) == 1);
+
+	/* k2 é agora o usado há mais tempo, e sai para dar lugar a k3 */
+	cacheResult(c, "k3", r[3]);
+	freeResult(r[3]);
+
+	CHECK(cachedMarker(c, "k2") == -1);
+	CHECK(cachedMarker(c, "k0") == 0);
+	CHECK(cachedMarker(c, "k1") == 1);
+	CHECK(cachedMarker(c, "k3") == 3);
+
+	/* Uma chave guardada outra vez fica com o resultado novo */
+	cacheResult(c, "k1", r[4]);
+	freeResult(r[4]);
+	CHECK(cachedMarker(c, "k1") == 4);
+
+	/* Um resultado maior do que a cache não é guardado nem descarta nada */
+	cacheResult(c, "big", big);
+	freeResult(big);
+	CHECK(cachedMarker(c, "big") == -1);
+	CHECK(cachedMarker(c, "k0") == 0);
+
+	/* A mesma geração mantém os resultados; uma nova descarta-os */
+	c = setCacheGeneration(c, 0);
+	CHECK(cachedMarker(c, "k3") == 3);
+	c = setCacheGeneration(c, 1);
+	CHECK(cachedMarker(c, "k0") == -1 && cachedMarker(c, "k3") == -1);
+
+	freeCache(c);
+	CHECK(getMemLiveBlocks(MEM_QUERIES) == live);
+}
+
+/**
+ * Cria um resultado com o número de linhas dado, cuja primeira linha tem marker.
+ */
+static RESULT makeResult(int marker, int rows) {
+	RESULT r = initResult("ci");
+	int i;
+
+	for(i = 0; i < rows; i++) {
+		r = addResultRow(r);
+		r = setResultCode(r, 0, "AA1000");
+		r = setResultInt(r, 1, i ? i : marker);
+	}
+
+	return r;
+}
+
+/**
+ * Devolve a marca do resultado guardado com a chave dada, ou -1 se não estiver na cache.
+ */
+static int cachedMarker(CACHE c, char* key) {
+	RESULT r = getCachedResult(c, key);
+	int marker = r ? getResultInt(r, 0, 1) : -1;
+
+	freeResult(r);
+	return marker;
+}
+
+/**
+ * parallelFor com vários números de trabalhadores (incluindo nenhum conjunto) e
+ * intervalos: cada índice tem de ser percorrido exatamente uma vez, em pedaços que
+ * começam em begin + k * grain. As tarefas submetidas uma a uma correm todas antes de
+ * waitThreadPool terminar.
+ */
+static void checkParallelFor() {
+	static int ranges[][3] = {
+		{0, FOR_SIZE, 1000}, {0, FOR_SIZE, 1}, {17, FOR_SIZE - 3, 333}, {5, 6, 100},
+		{10, 10, 4}, {-50, 50, 7}
+	};
+	static int workers[] = {1, 2, 4, 0};
+	THREADPOOL pool;
+	long tasks;
+	int i, j, counter, wrong = 0;
+
+	for(i = 0; i < (int) (sizeof(ranges) / sizeof(ranges[0])); i++)
+		wrong += coverRange(NULL, ranges[i][0], ranges[i][1], ranges[i][2]);
+
+	for(j = 0; j < (int) (sizeof(workers) / sizeof(workers[0])); j++) {
+		pool = initThreadPool(workers[j]);
+
+		for(i = 0; i < (int) (sizeof(ranges) / sizeof(ranges[0])); i++)
+			wrong += coverRange(pool, ranges[i][0], ranges[i][1], ranges[i][2]);
+
+		counter = 0;
+		tasks = getThreadPoolTasks(pool);
+
+		for(i = 0; i < FOR_TASKS; i++)
+			pool = submitTask(pool, (task_t) countTask, &counter);
+
+		pool = waitThreadPool(pool);
+
+		if (__sync_add_and_fetch(&counter, 0) != FOR_TASKS) wrong++;
+		if (getThreadPoolTasks(pool) - tasks != FOR_TASKS) wrong++;
+
+		freeThreadPool(pool);
+	}
+
+	CHECK(wrong == 0);
+}
+
+/**
+ * Percorre [begin, end) com um parallelFor e verifica os pedaços e os índices cobertos.
+ * @return O número de erros encontrados
+ */
+static int coverRange(THREADPOOL pool, int begin, int end, int grain) {
+	struct coverage c;
+	int i, errors;
+
+	c.begin = begin;
+	c.end = end;
+	c.grain = grain;
+	c.hits = calloc(end - begin + 1, sizeof(int));
+	c.errors = 0;
+
+	parallelFor(pool, begin, end, grain, (range_t) coverChunk, &c);
+
+	errors = c.errors;
+	for(i = 0; i < end - begin; i++)
+		if (c.hits[i] != 1) errors++;
+
+	free(c.hits);
+	return errors;
+}
+
+/**
+ * Marca os índices de um pedaço. O primeiro quarto do intervalo demora mais, para os
+ * pedaços terem custos diferentes e os trabalhadores terem de roubar.
+ */
+static void coverChunk(struct coverage* c, int begin, int end) {
+	volatile int spin;
+	int i;
+
+	if ((begin - c->begin) % c->grain || end <= begin || end - begin > c->grain ||
+	    end > c->end || (end < c->end && end - begin != c->grain))
+		__sync_add_and_fetch(&c->errors, 1);
+
+	for(i = begin; i < end; i++) {
+		if (i >= c->begin && i < c->end) __sync_add_and_fetch(&c->hits[i - c->begin], 1);
+		if (i < c->begin + (c->end - c->begin) / 4) for(spin = 0; spin < 100; spin++);
+	}
+}
+
+static void countTask(int* counter) {
+	__sync_add_and_fetch(counter, 1);
+}
@@ -0,0 +1,409 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * Gerador de dados sintéticos para o gereVendas. Escreve os ficheiros de clientes,
+ * produtos e vendas no formato lido por loadClients, loadProducts e readSale, para
+ * testar o programa com volumes e distribuições diferentes das dos ficheiros dados.
+ *
+ * Os códigos seguem o formato dos originais (uma letra e quatro dígitos nos clientes,
+ * duas letras e quatro dígitos nos produtos), com números entre 1000 e 9999. A
+ * popularidade dos produtos e dos clientes segue uma distribuição de Zipf, e todos os
+ * valores são obtidos de um gerador próprio, pelo que a mesma semente dá sempre os
+ * mesmos ficheiros, em qualquer plataforma.
+ */
+
+#define CLIENTS_FILE  "Clientes.txt"
+#define PRODUCTS_FILE "Produtos.txt"
+#define SALES_FILE    "Vendas_1M.txt"
+
+#define DEFAULT_SALES    1000000L
+#define DEFAULT_CLIENTS  16384L
+#define DEFAULT_PRODUCTS 171008L
+#define DEFAULT_BRANCHES 3
+#define DEFAULT_PROMO    0.5
+#define DEFAULT_INVALID  0.05
+#define DEFAULT_SEED     2016
+
+#define LETTERS 26
+#define FIRST_NUMBER 1000
+#define NUMBERS 9000
+
+/* Espaço ocupado por cada código, incluindo o '\0' */
+#define CODE_SIZE 8
+#define CODE(codes, i) ((codes) + (i) * CODE_SIZE)
+
+#define MAX_PRICE 100.0
+#define MAX_QUANT 200
+#define MONTHS 12
+
+#define MASK 0xFFFFFFFFUL
+#define PATH_SIZE 1024
+#define OUT_BUFFER (1 << 20)
+
+/* Opções do gerador, lidas dos argumentos */
+struct options {
+	long sales;
+	long clients;
+	long products;
+	int branches;
+	double clientSkew;
+	double productSkew;
+	double promo;
+	double invalid;
+	unsigned long seed;
+	char* dir;
+};
+
+/*
+ * Gerador xorshift128 de Marsaglia. As palavras são mantidas em 32 bits, para que a
+ * sequência não dependa do tamanho de um long.
+ */
+struct rng {
+	unsigned long x, y, z, w;
+};
+
+/* Distribuição de Zipf sobre n posições; sem cdf a distribuição é uniforme */
+struct zipf {
+	long n;
+	double* cdf;
+};
+
+static void usage(char* name);
+static long parseCount(char* str);
+static int parseOptions(struct options* opts, int argc, char** argv);
+
+static void seedRng(struct rng* r, unsigned long seed);
+static unsigned long nextRng(struct rng* r);
+static double uniform(struct rng* r);
+static long randomBelow(struct rng* r, long n);
+
+static char* makeCodes(struct rng* r, long n, int letters);
+static char* formatCode(char* code, long index, int letters);
+static void initZipf(struct zipf* z, long n, double skew);
+static long sampleZipf(struct zipf* z, struct rng* r);
+
+static FILE* openOutput(char* dir, char* name);
+static int writeCodes(char* dir, char* name, char* codes, long n);
+static int writeSales(struct options* opts, struct rng* r, char* clients, char* products);
+static void writeInvalidSale(FILE* out, struct options* opts, struct rng* r,
+                             char* client, char* product);
+
+int main(int argc, char** argv) {
+	struct options opts;
+	struct rng r;
+	char *clients, *products;
+	int failed;
+
+	if (!parseOptions(&opts, argc, argv)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	seedRng(&r, opts.seed);
+
+	clients = makeCodes(&r, opts.clients, 1);
+	products = makeCodes(&r, opts.products, 2);
+
+	failed = !writeCodes(opts.dir, CLIENTS_FILE, clients, opts.clients) ||
+	         !writeCodes(opts.dir, PRODUCTS_FILE, products, opts.products) ||
+	         !writeSales(&opts, &r, clients, products);
+
+	if (!failed)
+		printf("%ld clientes, %ld produtos e %ld vendas escritos em %s\n",
+		       opts.clients, opts.products, opts.sales, opts.dir);
+
+	free(clients);
+	free(products);
+
+	return failed;
+}
+
+static void usage(char* name) {
+	fprintf(stderr,
+	    "Uso: %s [opções] diretório\n"
+	    "  -v N      número de vendas, com sufixo K ou M opcional (%ld)\n"
+	    "  -c N      número de clientes, até %d (%ld)\n"
+	    "  -p N      número de produtos, até %d (%ld)\n"
+	    "  -f N      número de filiais (%d)\n",
+	    name, DEFAULT_SALES, LETTERS * NUMBERS, DEFAULT_CLIENTS,
+	    LETTERS * LETTERS * NUMBERS, DEFAULT_PRODUCTS, DEFAULT_BRANCHES);
+	fprintf(stderr,
+	    "  -zc S     expoente de Zipf da popularidade dos clientes, 0 = uniforme (0)\n"
+	    "  -zp S     expoente de Zipf da popularidade dos produtos, 0 = uniforme (0)\n"
+	    "  -promo R  fração das vendas em promoção (%.2f)\n"
+	    "  -inv R    fração de linhas com um cliente, produto ou filial inválidos (%.2f)\n"
+	    "  -seed N   semente do gerador (%d)\n",
+	    DEFAULT_PROMO, DEFAULT_INVALID, DEFAULT_SEED);
+}
+
+/**
+ * Lê um número inteiro positivo, que pode terminar em K (milhares) ou M (milhões).
+ * @return Número lido, ou -1 se for inválido
+ */
+static long parseCount(char* str) {
+	char* end;
+	long n = strtol(str, &end, 10);
+
+	if (*end == 'K' || *end == 'k') { n *= 1000; end++; }
+	else if (*end == 'M' || *end == 'm') { n *= 1000000; end++; }
+
+	return (*end || n < 1) ? -1 : n;
+}
+
+static int parseOptions(struct options* opts, int argc, char** argv) {
+	char* opt;
+	int i;
+
+	opts->sales = DEFAULT_SALES;
+	opts->clients = DEFAULT_CLIENTS;
+	opts->products = DEFAULT_PRODUCTS;
+	opts->branches = DEFAULT_BRANCHES;
+	opts->clientSkew = opts->productSkew = 0;
+	opts->promo = DEFAULT_PROMO;
+	opts->invalid = DEFAULT_INVALID;
+	opts->seed = DEFAULT_SEED;
+	opts->dir = NULL;
+
+	for(i = 1; i < argc; i++) {
+		opt = argv[i];
+
+		if (opt[0] != '-') {
+			opts->dir = opt;
+			continue;
+		}
+
+		if (i + 1 == argc) return 0;
+
+		if (!strcmp(opt, "-v")) opts->sales = parseCount(argv[++i]);
+		else if (!strcmp(opt, "-c")) opts->clients = parseCount(argv[++i]);
+		else if (!strcmp(opt, "-p")) opts->products = parseCount(argv[++i]);
+		else if (!strcmp(opt, "-f")) opts->branches = atoi(argv[++i]);
+		else if (!strcmp(opt, "-zc")) opts->clientSkew = atof(argv[++i]);
+		else if (!strcmp(opt, "-zp")) opts->productSkew = atof(argv[++i]);
+		else if (!strcmp(opt, "-promo")) opts->promo = atof(argv[++i]);
+		else if (!strcmp(opt, "-inv")) opts->invalid = atof(argv[++i]);
+		else if (!strcmp(opt, "-seed")) opts->seed = strtoul(argv[++i], NULL, 10);
+		else return 0;
+	}
+
+	return opts->dir && opts->sales > 0 && opts->branches > 0 &&
+	       opts->clients > 0 && opts->clients <= LETTERS * NUMBERS &&
+	       opts->products > 0 && opts->products <= LETTERS * LETTERS * NUMBERS &&
+	       opts->clientSkew >= 0 && opts->productSkew >= 0 &&
+	       opts->promo >= 0 && opts->promo <= 1 &&
+	       opts->invalid >= 0 && opts->invalid <= 1;
+}
+
+static void seedRng(struct rng* r, unsigned long seed) {
+	int i;
+
+	r->x = 123456789UL ^ (seed & MASK);
+	r->y = 362436069UL;
+	r->z = 521288629UL;
+	r->w = 88675123UL ^ ((seed >> 16) & MASK);
+
+	/* Afasta o estado inicial de sementes parecidas */
+	for(i = 0; i < 64; i++)
+		nextRng(r);
+}
+
+static unsigned long nextRng(struct rng* r) {
+	unsigned long t = (r->x ^ (r->x << 11)) & MASK;
+
+	r->x = r->y;
+	r->y = r->z;
+	r->z = r->w;
+	r->w = (r->w ^ (r->w >> 19) ^ t ^ (t >> 8)) & MASK;
+
+	return r->w;
+}
+
+/**
+ * Devolve um número real uniforme em [0, 1).
+ */
+static double uniform(struct rng* r) {
+	return nextRng(r) / 4294967296.0;
+}
+
+static long randomBelow(struct rng* r, long n) {
+	return (long) (uniform(r) * n);
+}
+
+/**
+ * Escolhe n códigos distintos, com o número de letras dado, por amostragem sequencial
+ * do espaço de códigos (algoritmo S de Knuth). Os códigos são depois baralhados: a
+ * ordem final é a do ficheiro e também a da popularidade na distribuição de Zipf, pelo
+ * que os códigos mais populares ficam espalhados pelas letras.
+ */
+static char* makeCodes(struct rng* r, long n, int letters) {
+	char *codes = malloc((size_t) n * CODE_SIZE), tmp[CODE_SIZE];
+	long i, j, chosen = 0, space = NUMBERS;
+
+	for(i = 0; i < letters; i++)
+		space *= LETTERS;
+
+	for(i = 0; chosen < n; i++)
+		if ((space - i) * uniform(r) < n - chosen)
+			formatCode(CODE(codes, chosen++), i, letters);
+
+	for(i = n - 1; i > 0; i--) {
+		j = randomBelow(r, i + 1);
+		strcpy(tmp, CODE(codes, i));
+		strcpy(CODE(codes, i), CODE(codes, j));
+		strcpy(CODE(codes, j), tmp);
+	}
+
+	return codes;
+}
+
+/**
+ * Escreve o código na posição index do espaço de códigos com o número de letras dado,
+ * por ordem alfabética.
+ */
+static char* formatCode(char* code, long index, int letters) {
+	long rest = index / NUMBERS;
+	int i;
+
+	for(i = letters - 1; i >= 0; i--) {
+		code[i] = 'A' + rest % LETTERS;
+		rest /= LETTERS;
+	}
+
+	sprintf(code + letters, "%ld", FIRST_NUMBER + index % NUMBERS);
+	return code;
+}
+
+/**
+ * Prepara uma distribuição de Zipf com o expoente dado: a posição k (a partir de 0) é
+ * escolhida com probabilidade proporcional a 1 / (k + 1)^skew.
+ */
+static void initZipf(struct zipf* z, long n, double skew) {
+	double sum = 0;
+	long i;
+
+	z->n = n;
+	z->cdf = NULL;
+
+	if (skew == 0) return;
+
+	z->cdf = malloc(sizeof(double) * n);
+
+	for(i = 0; i < n; i++) {
+		sum += 1.0 / pow(i + 1, skew);
+		z->cdf[i] = sum;
+	}
+
+	for(i = 0; i < n; i++)
+		z->cdf[i] /= sum;
+}
+
+static long sampleZipf(struct zipf* z, struct rng* r) {
+	double u;
+	long lo = 0, hi = z->n - 1, mid;
+
+	if (!z->cdf) return randomBelow(r, z->n);
+
+	u = uniform(r);
+
+	while(lo < hi) {
+		mid = (lo + hi) / 2;
+
+		if (z->cdf[mid] < u) lo = mid + 1;
+		else hi = mid;
+	}
+
+	return lo;
+}
+
+static FILE* openOutput(char* dir, char* name) {
+	char path[PATH_SIZE];
+	FILE* out;
+
+	sprintf(path, "%.*s/%s", PATH_SIZE - 32, dir, name);
+
+	if (!(out = fopen(path, "w"))) {
+		fprintf(stderr, "Não foi possível escrever %s\n", path);
+		return NULL;
+	}
+
+	setvbuf(out, NULL, _IOFBF, OUT_BUFFER);
+	return out;
+}
+
+static int writeCodes(char* dir, char* name, char* codes, long n) {
+	FILE* out = openOutput(dir, name);
+	long i;
+
+	if (!out) return 0;
+
+	for(i = 0; i < n; i++)
+		fprintf(out, "%s\r\n", CODE(codes, i));
+
+	return fclose(out) == 0;
+}
+
+/**
+ * Escreve as vendas, uma por linha: produto, preço, quantidade, modo (N ou P), cliente,
+ * mês e filial, separados por espaços.
+ */
+static int writeSales(struct options* opts, struct rng* r, char* clients, char* products) {
+	struct zipf zc, zp;
+	FILE* out = openOutput(opts->dir, SALES_FILE);
+	char *client, *product;
+	long i;
+
+	if (!out) return 0;
+
+	initZipf(&zc, opts->clients, opts->clientSkew);
+	initZipf(&zp, opts->products, opts->productSkew);
+
+	for(i = 0; i < opts->sales; i++) {
+		client = CODE(clients, sampleZipf(&zc, r));
+		product = CODE(products, sampleZipf(&zp, r));
+
+		if (uniform(r) < opts->invalid) {
+			writeInvalidSale(out, opts, r, client, product);
+			continue;
+		}
+
+		fprintf(out, "%s %.2f %ld %c %s %ld %ld\r\n", product,
+		        uniform(r) * MAX_PRICE, 1 + randomBelow(r, MAX_QUANT),
+		        uniform(r) < opts->promo ? 'P' : 'N', client,
+		        1 + randomBelow(r, MONTHS), 1 + randomBelow(r, opts->branches));
+	}
+
+	free(zc.cdf);
+	free(zp.cdf);
+
+	return fclose(out) == 0;
+}
+
+/**
+ * Escreve uma venda bem formada mas inválida: o produto ou o cliente têm um número
+ * abaixo de 1000, que nunca é gerado, ou a filial é 0.
+ */
+static void writeInvalidSale(FILE* out, struct options* opts, struct rng* r,
+                             char* client, char* product) {
+	char code[CODE_SIZE];
+	int branch = 1 + randomBelow(r, opts->branches);
+
+	switch(randomBelow(r, 3)) {
+		case 0:
+			sprintf(code, "%.2s%04ld", product, randomBelow(r, FIRST_NUMBER));
+			product = code;
+			break;
+		case 1:
+			sprintf(code, "%.1s%04ld", client, randomBelow(r, FIRST_NUMBER));
+			client = code;
+			break;
+		default:
+			branch = 0;
+	}
+
+	fprintf(out, "%s %.2f %ld %c %s %ld %d\r\n", product, uniform(r) * MAX_PRICE,
+	        1 + randomBelow(r, MAX_QUANT), uniform(r) < opts->promo ? 'P' : 'N',
+	        client, 1 + randomBelow(r, MONTHS), branch);
+}
@@ -0,0 +1,486 @@
+#define _XOPEN_SOURCE 500
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "dataloader.h"
+#include "engine.h"
+#include "threadpool.h"
+
+/*
+ * Latência ponta a ponta das queries do gereVendas. Os dados são carregados uma vez e
+ * cada query é depois executada várias vezes diretamente sobre o motor (ver engine.h),
+ * sem passar pela apresentação interativa, com os parâmetros a variar entre execuções:
+ * clientes e produtos aleatórios, todos os meses, todas as filiais e todos os
+ * intervalos de meses. A query 10 é medida à parte para cada N, em potências de 2 até
+ * ao número de produtos.
+ *
+ * O resultado é um objeto JSON, escrito no stdout, com os percentis 50, 95 e 99 do
+ * tempo de cada query e o pico de memória residente (RSS) atingido enquanto corria.
+ * A query 1 é a própria leitura dos dados.
+ */
+
+#define DEFAULT_SAMPLES 200
+#define DEFAULT_LOADS   1
+#define DEFAULT_SEED    2016
+#define DEFAULT_BRANCHES 3
+
+/* Os mesmos filtros dos catálogos que o gereVendas, configuráveis com -bloom e -bloomBytes */
+#define FILTER_FP_RATE 0
+#define FILTER_BYTES (4L * 1024 * 1024)
+
+#define LETTERS 26
+#define MASK 0xFFFFFFFFUL
+
+/* Gerador xorshift128 com palavras de 32 bits, como em geraDados */
+struct rng {
+	unsigned long x, y, z, w;
+};
+
+/* Códigos de um catálogo, por ordem alfabética, para escolher parâmetros aleatórios */
+struct codes {
+	SET sets[LETTERS];
+	char** codes;
+	int n;
+};
+
+/* Dados carregados e parâmetros da próxima execução */
+typedef struct harness {
+	SALESINDEX si;
+	FATGLOBAL fat;
+	PRODUCTCAT pcat;
+	CLIENTCAT ccat;
+	int branches;
+	double filterRate;
+	long filterBytes;
+	struct codes products;
+	struct codes clients;
+	struct rng rng;
+
+	PRODUCT product;
+	CLIENT client;
+	char prefix[2];
+	int month;
+	int begin, end;
+	int branch;
+	int n;
+}*HARNESS;
+
+typedef RESULT (*query_t)(HARNESS h);
+
+static RESULT latencyQ2(HARNESS h);
+static RESULT latencyQ3(HARNESS h);
+static RESULT latencyQ4(HARNESS h);
+static RESULT latencyQ5(HARNESS h);
+static RESULT latencyQ6(HARNESS h);
+static RESULT latencyQ7(HARNESS h);
+static RESULT latencyQ8(HARNESS h);
+static RESULT latencyQ9(HARNESS h);
+static RESULT latencyQ10(HARNESS h);
+static RESULT latencyQ11(HARNESS h);
+static RESULT latencyQ12(HARNESS h);
+
+static int load(HARNESS h, char** paths, THREADPOOL pool, int* counts);
+static void unload(HARNESS h);
+static struct codes listCodes(void* cat, SET (*fill)(void*, char));
+static void freeCodes(struct codes* c);
+static void nextParams(HARNESS h, int run);
+static void measure(HARNESS h, char* name, query_t query, int runs, int n);
+static void printStats(char* name, int n, long* ns, int runs, double rows);
+static void printString(char* str);
+static unsigned long nextRng(struct rng* r);
+static long now();
+static bool resetPeakRSS();
+static long getPeakRSS();
+
+static struct query {
+	char* name;
+	query_t run;
+} queries[] = {
+	{"q2",  latencyQ2},
+	{"q3",  latencyQ3},
+	{"q4",  latencyQ4},
+	{"q5",  latencyQ5},
+	{"q6",  latencyQ6},
+	{"q7",  latencyQ7},
+	{"q8",  latencyQ8},
+	{"q9",  latencyQ9},
+	{"q11", latencyQ11},
+	{"q12", latencyQ12},
+	{NULL,  NULL}
+};
+
+int main(int argc, char** argv) {
+	struct harness h;
+	THREADPOOL pool;
+	char* paths[3] = {CLIENTS_PATH, PRODUCTS_PATH, SALES_PATH};
+	long* ns;
+	long start;
+	int i, n, counts[4], nPaths = 0, samples = DEFAULT_SAMPLES, loads = DEFAULT_LOADS;
+	unsigned long seed = DEFAULT_SEED;
+	bool reset;
+
+	h.branches = DEFAULT_BRANCHES;
+	h.filterRate = FILTER_FP_RATE;
+	h.filterBytes = FILTER_BYTES;
+
+	for(i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-s") && i + 1 < argc) samples = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc) loads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-f") && i + 1 < argc) h.branches = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-seed") && i + 1 < argc) seed = atol(argv[++i]);
+		else if (!strcmp(argv[i], "-bloom") && i + 1 < argc) h.filterRate = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-bloomBytes") && i + 1 < argc) h.filterBytes = atol(argv[++i]);
+		else if (argv[i][0] != '-' && nPaths < 3) paths[nPaths++] = argv[i];
+		else samples = 0;
+	}
+
+	if (samples < 1 || loads < 1 || h.branches < 1 || h.branches > MAX_BRANCHES ||
+	    h.filterRate < 0 || h.filterRate >= 1 || h.filterBytes < 0) {
+		fprintf(stderr, "Uso: %s [-s execuções (%d)] [-l leituras (%d)] [-f filiais (%d)] "
+		                "[-seed semente]\n", argv[0], DEFAULT_SAMPLES, DEFAULT_LOADS,
+		        DEFAULT_BRANCHES);
+		fprintf(stderr, "       [-bloom taxa [-bloomBytes bytes]] [clientes produtos vendas]\n");
+		return 1;
+	}
+
+	h.rng.x = 123456789UL ^ seed;
+	h.rng.y = 362436069UL;
+	h.rng.z = 521288629UL;
+	h.rng.w = 88675123UL;
+
+	pool = initThreadPool(0);
+	ns = malloc(sizeof(long) * loads);
+	reset = resetPeakRSS();
+
+	/* Query 1: só os dados da última leitura ficam carregados */
+	for(i = 0; i < loads; i++) {
+		if (i) unload(&h);
+
+		start = now();
+		if (load(&h, paths, pool, counts)) {
+			fprintf(stderr, "Ficheiros de dados inválidos ou inexistentes!\n");
+			freeThreadPool(pool);
+			free(ns);
+			return 1;
+		}
+		ns[i] = now() - start;
+	}
+
+	printf("{\n  \"dataset\": {");
+	printf("\"clients\": ");  printString(paths[0]);
+	printf(", \"products\": "); printString(paths[1]);
+	printf(", \"sales\": ");  printString(paths[2]);
+	printf(", \"branches\": %d, \"clients_loaded\": %d, \"products_loaded\": %d, "
+	       "\"sales_loaded\": %d, \"sales_failed\": %d},\n",
+	       h.branches, counts[0], counts[1], counts[2], counts[3]);
+	printf("  \"samples\": %d,\n  \"seed\": %lu,\n  \"workers\": %d,\n", samples, seed,
+	       getThreadPoolWorkers(pool));
+	printf("  \"rss_per_query\": %s,\n", reset ? "true" : "false");
+	printf("  \"queries\": [\n");
+
+	printStats("q1", -1, ns, loads, counts[2]);
+	free(ns);
+
+	h.products = listCodes(h.pcat, (SET (*)(void*, char)) fillProductSet);
+	h.clients = listCodes(h.ccat, (SET (*)(void*, char)) fillClientSet);
+	h.product = newProduct();
+	h.client = newClient();
+
+	for(i = 0; queries[i].name; i++)
+		measure(&h, queries[i].name, queries[i].run, samples, -1);
+
+	for(n = 1; n < h.products.n * 2; n *= 2)
+		measure(&h, "q10", latencyQ10, samples, (n < h.products.n) ? n : h.products.n);
+
+	printf("\n  ]\n}\n");
+
+	freeProduct(h.product);
+	freeClient(h.client);
+	freeCodes(&h.products);
+	freeCodes(&h.clients);
+	unload(&h);
+	freeThreadPool(pool);
+
+	return 0;
+}
+
+	/*========================= QUERIES ==========================*/
+
+static RESULT latencyQ2(HARNESS h) {
+	return getProductsByPrefix(h->pcat, h->prefix);
+}
+
+static RESULT latencyQ3(HARNESS h) {
+	return getProductRevenue(h->fat, h->pcat, h->product, h->month);
+}
+
+static RESULT latencyQ4(HARNESS h) {
+	/* A filial -1 corresponde a nenhuma filial */
+	return getUnsoldProducts(h->fat, h->branch - 1);
+}
+
+static RESULT latencyQ5(HARNESS h) {
+	return getClientMonthlyQuant(h->si, h->client);
+}
+
+static RESULT latencyQ6(HARNESS h) {
+	return getSalesInMonthRange(h->fat, h->begin, h->end);
+}
+
+static RESULT latencyQ7(HARNESS h) {
+	return getLoyalClients(h->si);
+}
+
+static RESULT latencyQ8(HARNESS h) {
+	return getProductBuyers(h->si, h->pcat, h->product, h->branch % h->branches);
+}
+
+static RESULT latencyQ9(HARNESS h) {
+	return getClientFavourites(h->si, h->client, h->month);
+}
+
+static RESULT latencyQ10(HARNESS h) {
+	return getTopProducts(h->si, h->n);
+}
+
+static RESULT latencyQ11(HARNESS h) {
+	return getClientTopSpending(h->si, h->client, 3);
+}
+
+static RESULT latencyQ12(HARNESS h) {
+	return getInactiveCounts(h->si, h->fat);
+}
+
+	/*========================== HARNESS =========================*/
+
+/**
+ * Lê os três ficheiros de dados para estruturas novas.
+ * @param counts Clientes, produtos, vendas válidas e vendas inválidas lidos
+ * @return 0 se os dados foram carregados, -1 se algum ficheiro não pôde ser aberto
+ */
+static int load(HARNESS h, char** paths, THREADPOOL pool, int* counts) {
+	FILE *clients, *products, *sales;
+
+	clients  = fopen(paths[0], "r");
+	products = fopen(paths[1], "r");
+	sales    = fopen(paths[2], "r");
+
+	if (!clients || !products || !sales) {
+		if (clients) fclose(clients);
+		if (products) fclose(products);
+		if (sales) fclose(sales);
+		return -1;
+	}
+
+	h->fat  = setFatPool(initFat(h->branches), pool);
+	h->si   = setSalesIndexPool(initSalesIndex(h->branches), pool);
+	h->ccat = setClientCatFilter(initClientCat(), h->filterRate, h->filterBytes);
+	h->pcat = setProductCatFilter(initProductCat(), h->filterRate, h->filterBytes);
+
+	counts[0] = loadClients(clients, h->ccat);
+	counts[1] = loadProducts(products, h->pcat);
+	counts[2] = loadSales(sales, h->fat, h->si, h->pcat, h->ccat, &counts[3]);
+
+	fclose(clients);
+	fclose(products);
+	fclose(sales);
+
+	return 0;
+}
+
+static void unload(HARNESS h) {
+	freeFat(h->fat);
+	freeSalesIndex(h->si);
+	freeProductCat(h->pcat);
+	freeClientCat(h->ccat);
+}
+
+/**
+ * Junta os códigos de um catálogo, letra a letra, num único array.
+ * @param fill Função que preenche um set com os códigos começados por uma letra
+ */
+static struct codes listCodes(void* cat, SET (*fill)(void*, char)) {
+	struct codes c;
+	int i, j, n = 0;
+
+	for(i = 0; i < LETTERS; i++) {
+		c.sets[i] = fill(cat, 'A' + i);
+		n += getSetSize(c.sets[i]);
+	}
+
+	c.codes = malloc(sizeof(char*) * (n ? n : 1));
+	c.n = 0;
+
+	for(i = 0; i < LETTERS; i++)
+		for(j = 0; j < getSetSize(c.sets[i]); j++)
+			c.codes[c.n++] = getSetHash(c.sets[i], j);
+
+	return c;
+}
+
+static void freeCodes(struct codes* c) {
+	int i;
+
+	for(i = 0; i < LETTERS; i++)
+		freeSet(c->sets[i]);
+
+	free(c->codes);
+}
+
+/**
+ * Escolhe os parâmetros de uma execução. Os clientes e os produtos são aleatórios; os
+ * meses, as filiais e os intervalos de meses são percorridos por ordem, para que todos
+ * sejam usados com execuções suficientes.
+ */
+static void nextParams(HARNESS h, int run) {
+	int pair = run % (MONTHS * (MONTHS + 1) / 2);
+
+	if (h->products.n)
+		h->product = changeProductCode(h->product,
+		                               h->products.codes[nextRng(&h->rng) % h->products.n]);
+	if (h->clients.n)
+		h->client = changeClientCode(h->client,
+		                             h->clients.codes[nextRng(&h->rng) % h->clients.n]);
+
+	h->prefix[0] = 'A' + run % LETTERS;
+	h->prefix[1] = '\0';
+	h->month = run % MONTHS;
+	h->branch = run % (h->branches + 1);
+
+	/* Intervalo [begin, end] número pair, por ordem de begin e depois de end */
+	for(h->begin = 0; pair >= MONTHS - h->begin; h->begin++)
+		pair -= MONTHS - h->begin;
+	h->end = h->begin + pair;
+}
+
+/**
+ * Executa uma query runs vezes e escreve as suas estatísticas.
+ * @param n N da query 10, ou -1 para as restantes
+ */
+static void measure(HARNESS h, char* name, query_t query, int runs, int n) {
+	RESULT r;
+	long start, *ns = malloc(sizeof(long) * runs);
+	double rows = 0;
+	int i;
+
+	h->n = n;
+	resetPeakRSS();
+
+	for(i = 0; i < runs; i++) {
+		nextParams(h, i);
+
+		start = now();
+		r = query(h);
+		ns[i] = now() - start;
+
+		if (r) {
+			rows += getResultRows(r);
+			freeResult(r);
+		}
+	}
+
+	printf(",\n");
+	printStats(name, n, ns, runs, rows / runs);
+	free(ns);
+}
+
+static int compareLong(const void* a, const void* b) {
+	long x = *(long*) a, y = *(long*) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * Escreve o objeto JSON de uma query. Os percentis usam o método do posto mais próximo
+ * sobre os tempos ordenados.
+ */
+static void printStats(char* name, int n, long* ns, int runs, double rows) {
+	double p[3] = {0.50, 0.95, 0.99};
+	int i, rank;
+
+	qsort(ns, runs, sizeof(long), compareLong);
+
+	printf("    {\"query\": \"%s\", ", name);
+	if (n >= 0) printf("\"n\": %d, ", n);
+	printf("\"runs\": %d", runs);
+
+	for(i = 0; i < 3; i++) {
+		rank = (int) (p[i] * runs + 0.999999);
+		printf(", \"p%d_ns\": %ld", (int) (p[i] * 100 + 0.5), ns[rank > 0 ? rank - 1 : 0]);
+	}
+
+	printf(", \"max_ns\": %ld, \"mean_rows\": %.1f, \"peak_rss_kb\": %ld}",
+	       ns[runs - 1], rows, getPeakRSS());
+}
+
+static void printString(char* str) {
+	putchar('"');
+
+	for(; *str; str++)
+		if (*str == '"' || *str == '\\') printf("\\%c", *str);
+		else if ((unsigned char) *str < ' ') printf("\\u%04x", *str);
+		else putchar(*str);
+
+	putchar('"');
+}
+
+static unsigned long nextRng(struct rng* r) {
+	unsigned long t = (r->x ^ (r->x << 11)) & MASK;
+
+	r->x = r->y;
+	r->y = r->z;
+	r->z = r->w;
+	r->w = (r->w ^ (r->w >> 19) ^ t ^ (t >> 8)) & MASK;
+
+	return r->w;
+}
+
+static long now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+/**
+ * Reinicia o pico de RSS do processo (VmHWM), o que só é possível em Linux.
+ * @return false se o pico não pôde ser reiniciado, ficando o do processo inteiro
+ */
+static bool resetPeakRSS() {
+	FILE* f = fopen("/proc/self/clear_refs", "w");
+	bool ok;
+
+	if (!f) return false;
+
+	ok = (fputs("5", f) >= 0);
+	return (fclose(f) == 0) && ok;
+}
+
+/**
+ * Determina o pico de RSS desde o último resetPeakRSS, ou do processo inteiro se o
+ * /proc não estiver disponível, em kB.
+ */
+static long getPeakRSS() {
+	struct rusage usage;
+	char line[128];
+	long kb = -1;
+	FILE* f = fopen("/proc/self/status", "r");
+
+	if (f) {
+		while(kb < 0 && fgets(line, sizeof(line), f))
+			if (!strncmp(line, "VmHWM:", 6)) kb = atol(line + 6);
+
+		fclose(f);
+	}
+
+	if (kb < 0) {
+		getrusage(RUSAGE_SELF, &usage);
+		kb = usage.ru_maxrss;
+	}
+
+	return kb;
+}